@@ -0,0 +1,120 @@
+#ifndef S3BENCHCOMMON_H
+#define S3BENCHCOMMON_H
+
+// Helpers shared by the programs in bench/
+
+#include "S3Common.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Exports without a declaration in the library headers (the host declares them, as the VB6 module does)
+extern "C" {
+    S3UPLOAD_API const char* __stdcall UploadFileSync(const char* accessKey, const char* secretKey,
+                                                      const char* sessionToken, const char* region,
+                                                      const char* bucketName, const char* objectKey,
+                                                      const char* localFilePath);
+    S3UPLOAD_API const char* __stdcall UploadFileAsync(const char* accessKey, const char* secretKey,
+                                                       const char* sessionToken, const char* region,
+                                                       const char* bucketName, const char* objectKey,
+                                                       const char* localFilePath, const char* dataId);
+    S3UPLOAD_API const char* __stdcall UploadFolderAsync(const char* accessKey, const char* secretKey,
+                                                         const char* sessionToken, const char* region,
+                                                         const char* bucketName, const char* keyPrefix,
+                                                         const char* localFolderPath, const char* dataId);
+    S3UPLOAD_API int __stdcall WaitForUploadsByDataId(const char* dataId, long timeoutMs);
+    S3UPLOAD_API int __stdcall GetAsyncUploadStatusRecords(const char* dataId,
+                                                           UploadStatusSummaryRecord* summary,
+                                                           UploadStatusRecord* records,
+                                                           int maxRecords);
+    S3UPLOAD_API int __stdcall GetAsyncUploadStatusDelta(const char* dataId, double sinceVersion,
+                                                         unsigned char* buffer, int bufferSize);
+    S3UPLOAD_API const char* __stdcall SetMaxConcurrentUploads(long maxUploads);
+}
+
+// Credentials are not checked by the stand-in server
+static const char* const BENCH_ACCESS_KEY = "BENCHACCESSKEY";
+static const char* const BENCH_SECRET_KEY = "bench-secret-key";
+
+// Milliseconds on the clock the status records use
+inline long long nowMs() {
+    return getStatusTimeMs(std::chrono::steady_clock::now());
+}
+
+// Nearest-rank percentile of sorted values
+inline double percentile(const std::vector<double>& sortedValues, double fraction) {
+    if (sortedValues.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(fraction * sortedValues.size() + 0.999999);
+    rank = std::min(std::max<size_t>(rank, 1), sortedValues.size());
+    return sortedValues[rank - 1];
+}
+
+// Write size bytes of incompressible data (xorshift), so compression cannot flatter the numbers
+inline bool writeBenchFile(const String& path, long long size, unsigned long long seed) {
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<unsigned long long> block(64 * 1024 / sizeof(unsigned long long));
+    unsigned long long state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    long long remaining = size;
+    while (remaining > 0) {
+        for (auto& word : block) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            word = state;
+        }
+        std::streamsize chunk = static_cast<std::streamsize>(
+            std::min<long long>(remaining, static_cast<long long>(block.size() * sizeof(unsigned long long))));
+        file.write(reinterpret_cast<const char*>(block.data()), chunk);
+        remaining -= chunk;
+    }
+    return file.good();
+}
+
+// Create a directory and its missing parents
+inline bool ensureDirectory(const String& path) {
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    if (attributes != INVALID_FILE_ATTRIBUTES) {
+        return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    }
+    size_t separator = path.find_last_of("\\/");
+    if (separator != String::npos && separator > 0 && path[separator - 1] != ':') {
+        ensureDirectory(path.substr(0, separator));
+    }
+    return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+inline long long getExistingFileSize(const String& path) {
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<long long>(file.tellg()) : -1;
+}
+
+// Value of the "code" field of a library JSON response, -1 if missing
+inline int getResponseCode(const char* response) {
+    const char* code = response ? strstr(response, "\"code\":") : nullptr;
+    return code ? atoi(code + 7) : -1;
+}
+
+inline bool isSuccessResponse(const char* response) {
+    return getResponseCode(response) == UPLOAD_SUCCESS;
+}
+
+// Value of the "message" field of a create_response JSON (the uploadId for UploadFileAsync)
+inline String getResponseMessage(const char* response) {
+    static const String field = "\"message\":\"";
+    String text = response ? response : "";
+    size_t start = text.find(field);
+    if (start == String::npos) {
+        return "";
+    }
+    start += field.size();
+    size_t end = text.find('"', start);
+    return end == String::npos ? "" : text.substr(start, end - start);
+}
+
+// S3BENCHCOMMON_H
+#endif
@@ -0,0 +1,419 @@
+// Throughput benchmark for S3UploadLib
+// Runs the sync, async and folder upload flows over a generated file set against an
+// S3-compatible endpoint (normally bench/local_s3_server.py) and reports MB/s, per-file
+// latency percentiles, process CPU time and peak RSS per flow.
+//
+//   python3 bench/local_s3_server.py --port 9000 &
+//   build/bench/S3UploadBench --endpoint http://127.0.0.1:9000 --mix 64K:200,1M:50,32M:4
+
+#include "S3BenchCommon.h"
+#include "S3ClientCache.h"
+#include "S3UploadBundle.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Poll interval while waiting for an async batch
+static const long BENCH_WAIT_SLICE_MS = 200;
+
+struct BenchOptions {
+    String endpoint;
+    String bucket;
+    String region;
+    String mix;
+    String flows;
+    String workDir;
+    String jsonPath;
+    int iterations;
+    long concurrency;
+    long bundleKB;
+
+    BenchOptions()
+        : endpoint("http://127.0.0.1:9000"),
+          bucket("s3upload-bench"),
+          region("us-east-1"),
+          mix("64K:200,1M:50,32M:4"),
+          flows("sync,async,folder"),
+          iterations(1),
+          concurrency(0),
+          bundleKB(0) {}
+};
+
+struct BenchFile {
+    String path;
+    String name;
+    long long size;
+};
+
+// Process resource usage at one point in time
+struct ResourceSample {
+    double cpuSeconds;
+    long long peakRssBytes;
+};
+
+struct FlowResult {
+    String flow;
+    int iteration;
+    size_t fileCount;
+    size_t failedCount;
+    long long totalBytes;
+    double wallSeconds;
+    double cpuSeconds;
+    long long peakRssBytes;
+    double p50Ms;
+    double p99Ms;
+
+    FlowResult() : iteration(0), fileCount(0), failedCount(0), totalBytes(0), wallSeconds(0),
+                   cpuSeconds(0), peakRssBytes(0), p50Ms(0), p99Ms(0) {}
+
+    double getMegabytesPerSecond() const {
+        return wallSeconds > 0 ? totalBytes / (1024.0 * 1024.0) / wallSeconds : 0;
+    }
+};
+
+static ResourceSample sampleResources() {
+    ResourceSample sample;
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+    auto toSeconds = [](const FILETIME& time) {
+        return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+    };
+    sample.cpuSeconds = toSeconds(kernelTime) + toSeconds(userTime);
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    sample.peakRssBytes = static_cast<long long>(counters.PeakWorkingSetSize);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    sample.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    sample.peakRssBytes = usage.ru_maxrss;
+#else
+    sample.peakRssBytes = usage.ru_maxrss * 1024LL;
+#endif
+#endif
+    return sample;
+}
+
+// Parse "64K", "1M", "2G" or plain bytes
+static long long parseSize(const String& text) {
+    if (text.empty()) {
+        return -1;
+    }
+    long long multiplier = 1;
+    String number = text;
+    switch (toupper(static_cast<unsigned char>(text.back()))) {
+    case 'K': multiplier = 1024LL; break;
+    case 'M': multiplier = 1024LL * 1024; break;
+    case 'G': multiplier = 1024LL * 1024 * 1024; break;
+    default: break;
+    }
+    if (multiplier != 1) {
+        number.pop_back();
+    }
+    char* end = nullptr;
+    long long value = strtoll(number.c_str(), &end, 10);
+    return end != nullptr && *end == '\0' && value >= 0 ? value * multiplier : -1;
+}
+
+// Parse a file-size mix "size:count,size:count"
+static bool parseMix(const String& mix, std::vector<std::pair<long long, int>>& entries) {
+    std::istringstream stream(mix);
+    String item;
+    while (std::getline(stream, item, ',')) {
+        size_t colon = item.find(':');
+        long long size = parseSize(item.substr(0, colon));
+        int count = colon == String::npos ? 1 : atoi(item.substr(colon + 1).c_str());
+        if (size < 0 || count <= 0) {
+            return false;
+        }
+        entries.push_back(std::make_pair(size, count));
+    }
+    return !entries.empty();
+}
+
+// Generate the file set; files of the right size from an earlier run are reused
+static bool prepareFiles(const String& filesDir, const std::vector<std::pair<long long, int>>& mix,
+                         std::vector<BenchFile>& files) {
+    if (!ensureDirectory(filesDir)) {
+        fprintf(stderr, "Cannot create %s\n", filesDir.c_str());
+        return false;
+    }
+    unsigned long long seed = 0;
+    for (const auto& entry : mix) {
+        for (int i = 0; i < entry.second; i++) {
+            char name[64];
+            snprintf(name, sizeof(name), "f%05llu_%lld.bin", seed, entry.first);
+            BenchFile file;
+            file.name = name;
+            file.path = filesDir + PATH_SEPARATOR + name;
+            file.size = entry.first;
+            if (getExistingFileSize(file.path) != file.size && !writeBenchFile(file.path, file.size, seed)) {
+                fprintf(stderr, "Cannot write %s\n", file.path.c_str());
+                return false;
+            }
+            files.push_back(file);
+            seed++;
+        }
+    }
+    return true;
+}
+
+// Wait for an async batch, then collect per-upload latencies from the status records
+// Latency runs from submitMs (per uploadId, or defaultSubmitMs) to the upload's end time.
+static void finishAsyncBatch(const String& dataId, const std::map<String, long long>& submitMs,
+                             long long defaultSubmitMs, std::vector<double>& latencies, FlowResult& result) {
+    while (WaitForUploadsByDataId(dataId.c_str(), BENCH_WAIT_SLICE_MS) == UPLOAD_UPLOADING) {
+    }
+
+    UploadStatusSummaryRecord summary;
+    int count = GetAsyncUploadStatusRecords(dataId.c_str(), &summary, nullptr, 0);
+    std::vector<UploadStatusRecord> records(count > 0 ? summary.uploadCount : 0);
+    if (!records.empty()) {
+        count = GetAsyncUploadStatusRecords(dataId.c_str(), &summary, records.data(),
+                                            static_cast<int>(records.size()));
+    }
+
+    for (int i = 0; i < count; i++) {
+        const UploadStatusRecord& record = records[i];
+        if (record.status != UPLOAD_SUCCESS) {
+            result.failedCount++;
+            continue;
+        }
+        auto it = submitMs.find(record.uploadId);
+        long long startMs = it != submitMs.end() ? it->second : defaultSubmitMs;
+        latencies.push_back(static_cast<double>(record.endTimeMs - startMs));
+    }
+    CleanupUploadsByDataId(dataId.c_str());
+}
+
+static void runSyncFlow(const BenchOptions& options, const std::vector<BenchFile>& files,
+                        const String& keyPrefix, std::vector<double>& latencies, FlowResult& result) {
+    for (const auto& file : files) {
+        String objectKey = keyPrefix + file.name;
+        long long startMs = nowMs();
+        const char* response = UploadFileSync(BENCH_ACCESS_KEY, BENCH_SECRET_KEY, "", options.region.c_str(),
+                                              options.bucket.c_str(), objectKey.c_str(), file.path.c_str());
+        if (!isSuccessResponse(response)) {
+            result.failedCount++;
+            fprintf(stderr, "UploadFileSync %s: %s\n", file.name.c_str(), response);
+            continue;
+        }
+        latencies.push_back(static_cast<double>(nowMs() - startMs));
+    }
+}
+
+static void runAsyncFlow(const BenchOptions& options, const std::vector<BenchFile>& files,
+                         const String& keyPrefix, const String& dataId,
+                         std::vector<double>& latencies, FlowResult& result) {
+    std::map<String, long long> submitMs;
+    for (const auto& file : files) {
+        String objectKey = keyPrefix + file.name;
+        long long startMs = nowMs();
+        const char* response = UploadFileAsync(BENCH_ACCESS_KEY, BENCH_SECRET_KEY, "", options.region.c_str(),
+                                               options.bucket.c_str(), objectKey.c_str(), file.path.c_str(),
+                                               dataId.c_str());
+        if (!isSuccessResponse(response)) {
+            result.failedCount++;
+            fprintf(stderr, "UploadFileAsync %s: %s\n", file.name.c_str(), response);
+            continue;
+        }
+        submitMs[getResponseMessage(response)] = startMs;
+    }
+    finishAsyncBatch(dataId, submitMs, nowMs(), latencies, result);
+}
+
+static void runFolderFlow(const BenchOptions& options, const String& filesDir,
+                          const String& keyPrefix, const String& dataId,
+                          std::vector<double>& latencies, FlowResult& result) {
+    long long startMs = nowMs();
+    const char* response = UploadFolderAsync(BENCH_ACCESS_KEY, BENCH_SECRET_KEY, "", options.region.c_str(),
+                                             options.bucket.c_str(), keyPrefix.c_str(), filesDir.c_str(),
+                                             dataId.c_str());
+    if (!isSuccessResponse(response)) {
+        result.failedCount = result.fileCount;
+        fprintf(stderr, "UploadFolderAsync: %s\n", response);
+        return;
+    }
+    finishAsyncBatch(dataId, std::map<String, long long>(), startMs, latencies, result);
+}
+
+static FlowResult runFlow(const BenchOptions& options, const String& flow, int iteration,
+                          const String& filesDir, const std::vector<BenchFile>& files) {
+    FlowResult result;
+    result.flow = flow;
+    result.iteration = iteration;
+    result.fileCount = files.size();
+    for (const auto& file : files) {
+        result.totalBytes += file.size;
+    }
+
+    // Step 1: Unique keys and dataId per run, so dedup and coalescing never skip work
+    std::ostringstream runName;
+    runName << flow << "-" << iteration << "-" << nowMs();
+    String keyPrefix = "bench/" + runName.str() + "/";
+    String dataId = "bench-" + runName.str();
+
+    // Step 2: Run the flow between two resource samples
+    std::vector<double> latencies;
+    ResourceSample before = sampleResources();
+    auto startTime = std::chrono::steady_clock::now();
+    if (flow == "sync") {
+        runSyncFlow(options, files, keyPrefix, latencies, result);
+    } else if (flow == "async") {
+        runAsyncFlow(options, files, keyPrefix, dataId, latencies, result);
+    } else {
+        runFolderFlow(options, filesDir, keyPrefix, dataId, latencies, result);
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    ResourceSample after = sampleResources();
+
+    // Step 3: Summarize
+    result.wallSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    result.cpuSeconds = after.cpuSeconds - before.cpuSeconds;
+    result.peakRssBytes = after.peakRssBytes;
+    std::sort(latencies.begin(), latencies.end());
+    result.p50Ms = percentile(latencies, 0.50);
+    result.p99Ms = percentile(latencies, 0.99);
+    return result;
+}
+
+static void printResult(const FlowResult& result) {
+    printf("%-7s %4d %7zu %6zu %10.1f %9.2f %9.1f %9.1f %8.2f %9.1f\n",
+           result.flow.c_str(), result.iteration, result.fileCount, result.failedCount,
+           result.totalBytes / (1024.0 * 1024.0), result.getMegabytesPerSecond(),
+           result.p50Ms, result.p99Ms, result.cpuSeconds, result.peakRssBytes / (1024.0 * 1024.0));
+}
+
+static bool writeJson(const String& path, const BenchOptions& options, const std::vector<FlowResult>& results) {
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    // parseMix only accepts digits, size suffixes, ':' and ',', so the mix needs no escaping
+    file << "{\"mix\":\"" << options.mix << "\",\"results\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const FlowResult& result = results[i];
+        file << (i > 0 ? "," : "") << "{"
+             << "\"flow\":\"" << result.flow << "\","
+             << "\"iteration\":" << result.iteration << ","
+             << "\"fileCount\":" << result.fileCount << ","
+             << "\"failedCount\":" << result.failedCount << ","
+             << "\"totalBytes\":" << result.totalBytes << ","
+             << "\"wallSeconds\":" << result.wallSeconds << ","
+             << "\"megabytesPerSecond\":" << result.getMegabytesPerSecond() << ","
+             << "\"p50Ms\":" << result.p50Ms << ","
+             << "\"p99Ms\":" << result.p99Ms << ","
+             << "\"cpuSeconds\":" << result.cpuSeconds << ","
+             << "\"peakRssBytes\":" << result.peakRssBytes
+             << "}";
+    }
+    file << "]}\n";
+    return file.good();
+}
+
+static void printUsage() {
+    printf("Usage: S3UploadBench [options]\n"
+           "  --endpoint URL     S3-compatible endpoint (default http://127.0.0.1:9000)\n"
+           "  --bucket NAME      bucket (default s3upload-bench)\n"
+           "  --region NAME      region used for signing (default us-east-1)\n"
+           "  --mix SPEC         file sizes and counts, e.g. 64K:200,1M:50,32M:4\n"
+           "  --flows LIST       any of sync,async,folder (default all three)\n"
+           "  --iterations N     runs per flow (default 1)\n"
+           "  --concurrency N    SetMaxConcurrentUploads (default: library default)\n"
+           "  --bundle-kb N      SetFolderUploadBundling threshold for the folder flow (default off)\n"
+           "  --work-dir DIR     where the file set is generated (default: temp dir)\n"
+           "  --json FILE        also write the results as JSON\n");
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        String name = argv[i];
+        if (name == "--help" || name == "-h" || i + 1 >= argc) {
+            return false;
+        }
+        String value = argv[++i];
+        if (name == "--endpoint") options.endpoint = value;
+        else if (name == "--bucket") options.bucket = value;
+        else if (name == "--region") options.region = value;
+        else if (name == "--mix") options.mix = value;
+        else if (name == "--flows") options.flows = value;
+        else if (name == "--iterations") options.iterations = std::max(1, atoi(value.c_str()));
+        else if (name == "--concurrency") options.concurrency = atol(value.c_str());
+        else if (name == "--bundle-kb") options.bundleKB = atol(value.c_str());
+        else if (name == "--work-dir") options.workDir = value;
+        else if (name == "--json") options.jsonPath = value;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    std::vector<std::pair<long long, int>> mix;
+    if (!parseOptions(argc, argv, options) || !parseMix(options.mix, mix)) {
+        printUsage();
+        return 2;
+    }
+
+    // Step 1: Generate the file set
+    if (options.workDir.empty()) {
+        char tempPath[MAX_PATH + 1];
+        DWORD length = GetTempPathA(sizeof(tempPath), tempPath);
+        options.workDir = String(tempPath, length) + "s3upload-bench";
+    }
+    String filesDir = options.workDir + PATH_SEPARATOR + "files";
+    std::vector<BenchFile> files;
+    if (!prepareFiles(filesDir, mix, files)) {
+        return 1;
+    }
+
+    // Step 2: Point the library at the endpoint
+    if (getResponseCode(InitializeAwsSDK()) != SDK_INIT_SUCCESS) {
+        fprintf(stderr, "InitializeAwsSDK failed\n");
+        return 1;
+    }
+    SetS3Endpoint(options.endpoint.c_str());
+    if (options.concurrency > 0) {
+        SetMaxConcurrentUploads(options.concurrency);
+    }
+    if (options.bundleKB > 0) {
+        SetFolderUploadBundling(options.bundleKB, 0);
+    }
+
+    // Step 3: Run every flow
+    printf("%zu file(s) from mix %s against %s\n", files.size(), options.mix.c_str(), options.endpoint.c_str());
+    printf("%-7s %4s %7s %6s %10s %9s %9s %9s %8s %9s\n",
+           "flow", "run", "files", "failed", "MB", "MB/s", "p50 ms", "p99 ms", "cpu s", "peak MB");
+    std::vector<FlowResult> results;
+    std::istringstream flowList(options.flows);
+    String flow;
+    while (std::getline(flowList, flow, ',')) {
+        if (flow != "sync" && flow != "async" && flow != "folder") {
+            fprintf(stderr, "Unknown flow: %s\n", flow.c_str());
+            continue;
+        }
+        for (int iteration = 1; iteration <= options.iterations; iteration++) {
+            results.push_back(runFlow(options, flow, iteration, filesDir, files));
+            printResult(results.back());
+        }
+    }
+
+    CleanupAwsSDK();
+
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, results)) {
+        fprintf(stderr, "Cannot write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+
+    size_t failedCount = 0;
+    for (const auto& result : results) {
+        failedCount += result.failedCount;
+    }
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+// Status polling stress test for S3UploadLib
+// Uploads a batch of small files twice against an S3-compatible endpoint (normally
+// bench/local_s3_server.py): once with no status readers, then with reader threads polling
+// GetAsyncUploadStatusRecords and GetAsyncUploadStatusDelta as fast as they can. Every
+// snapshot is checked for torn or inconsistent data, delta readers must end up with the
+// final status of every upload, and the two batches are compared to show that polling
+// does not slow the upload workers down.
+//
+//   python3 bench/local_s3_server.py --port 9000 &
+//   build/bench/S3UploadStatusStress --endpoint http://127.0.0.1:9000 --files 2000 --readers 8
+
+#include "S3BenchCommon.h"
+#include "S3ClientCache.h"
+
+struct StressOptions {
+    String endpoint;
+    String bucket;
+    String region;
+    String workDir;
+    int fileCount;
+    long long fileSize;
+    int readers;
+    long concurrency;
+
+    StressOptions()
+        : endpoint("http://127.0.0.1:9000"),
+          bucket("s3upload-bench"),
+          region("us-east-1"),
+          fileCount(2000),
+          fileSize(4 * 1024),
+          readers(8),
+          concurrency(16) {}
+};
+
+// What one reader thread saw
+struct ReaderResult {
+    // Records readers poll the binary snapshot; the others follow the JSON delta
+    bool usesRecords;
+    size_t polls;
+    std::vector<double> latenciesUs;
+    // Snapshots that contradicted themselves or an earlier snapshot
+    size_t violations;
+    String firstViolation;
+    // Delta readers: last status seen per upload
+    std::map<String, int> lastStatus;
+
+    ReaderResult() : usesRecords(false), polls(0), violations(0) {}
+
+    void fail(const String& description) {
+        if (violations++ == 0) {
+            firstViolation = description;
+        }
+    }
+};
+
+// Bytes reserved per upload in the delta buffer (grown if a response fills it)
+static const int STRESS_JSON_BYTES_PER_UPLOAD = 2048;
+
+// Integer value of "name": in text, or fallback if missing
+static long long getJsonNumber(const String& text, const char* name, long long fallback) {
+    String field = String("\"") + name + "\":";
+    size_t start = text.find(field);
+    return start == String::npos ? fallback : strtoll(text.c_str() + start + field.size(), nullptr, 10);
+}
+
+// String value of "name": in text (escapes are kept as they are)
+static String getJsonString(const String& text, const char* name) {
+    String field = String("\"") + name + "\":\"";
+    size_t start = text.find(field);
+    if (start == String::npos) {
+        return "";
+    }
+    start += field.size();
+    size_t end = start;
+    while (end < text.size() && text[end] != '"') {
+        end += text[end] == '\\' ? 2 : 1;
+    }
+    return text.substr(start, std::min(end, text.size()) - start);
+}
+
+// Check one binary snapshot against itself and against the previous one
+static void checkRecords(const String& dataId, const UploadStatusSummaryRecord& summary,
+                         const std::vector<UploadStatusRecord>& records, int count,
+                         int& lastUploadedCount, ReaderResult& result) {
+    int counted = summary.pendingCount + summary.uploadingCount + summary.uploadedCount +
+                  summary.failedCount + summary.cancelledCount;
+    if (summary.structSize != sizeof(UploadStatusSummaryRecord) || counted != summary.uploadCount) {
+        result.fail("summary counts do not add up to uploadCount");
+    }
+    if (summary.uploadedCount < lastUploadedCount) {
+        result.fail("uploadedCount went backwards");
+    }
+    lastUploadedCount = summary.uploadedCount;
+
+    String prefix = getUploadIdPrefixByDataId(dataId);
+    for (int i = 0; i < count; i++) {
+        const UploadStatusRecord& record = records[i];
+        if (strncmp(record.uploadId, prefix.c_str(), prefix.size()) != 0) {
+            result.fail(String("record of another dataId: ") + record.uploadId);
+        } else if (record.status < UPLOAD_PENDING || record.status > UPLOAD_CANCELLED) {
+            result.fail(String("invalid status in ") + record.uploadId);
+        } else if (record.bytesSent < 0 || (record.totalSize > 0 && record.bytesSent > record.totalSize)) {
+            result.fail(String("bytesSent beyond totalSize in ") + record.uploadId);
+        } else if (record.status == UPLOAD_SUCCESS &&
+                   (record.bytesSent != record.totalSize || record.endTimeMs < record.startTimeMs ||
+                    record.startTimeMs == 0)) {
+            result.fail(String("finished upload without its final size or times: ") + record.uploadId);
+        }
+    }
+}
+
+// Check the uploads of one delta response and remember their status
+static void checkDelta(const String& json, ReaderResult& result) {
+    static const String uploadStart = "{\"uploadId\":";
+    size_t position = json.find(uploadStart);
+    while (position != String::npos) {
+        size_t next = json.find(uploadStart, position + 1);
+        String upload = json.substr(position, next == String::npos ? String::npos : next - position);
+        position = next;
+
+        String uploadId = getJsonString(upload, "uploadId");
+        long long status = getJsonNumber(upload, "status", -1);
+        long long totalSize = getJsonNumber(upload, "totalSize", -1);
+        long long bytesSent = getJsonNumber(upload, "bytesSent", -1);
+        if (status < UPLOAD_PENDING || status > UPLOAD_CANCELLED) {
+            result.fail("invalid status in " + uploadId);
+            continue;
+        }
+        if (bytesSent < 0 || (totalSize > 0 && bytesSent > totalSize)) {
+            result.fail("bytesSent beyond totalSize in " + uploadId);
+        }
+        // Deduplicated uploads send nothing, so S3 returns no checksum for them
+        bool deduplicated = upload.find("\"deduplicated\":true") != String::npos;
+        if (status == UPLOAD_SUCCESS &&
+            ((!deduplicated && getJsonString(upload, "checksum").empty()) || bytesSent != totalSize)) {
+            result.fail("finished upload without its checksum or final size: " + uploadId);
+        }
+        if (status == UPLOAD_FAILED && getJsonString(upload, "errorMessage").empty()) {
+            result.fail("failed upload without an error message: " + uploadId);
+        }
+        // A final status never changes again
+        auto seen = result.lastStatus.find(uploadId);
+        if (seen != result.lastStatus.end() && isFinishedStatus(seen->second) && seen->second != status) {
+            result.fail("final status changed: " + uploadId);
+        }
+        result.lastStatus[uploadId] = static_cast<int>(status);
+    }
+}
+
+// Poll one dataId until stop is set, then take one last look once the batch is over
+static void runReader(const String& dataId, int fileCount, const std::atomic<bool>& stop, ReaderResult& result) {
+    std::vector<UploadStatusRecord> records(fileCount);
+    std::vector<unsigned char> buffer(static_cast<size_t>(fileCount) * STRESS_JSON_BYTES_PER_UPLOAD);
+    unsigned long long version = 0;
+    long long lastVersion = 0;
+    int lastUploadedCount = 0;
+
+    bool finalPoll = false;
+    while (true) {
+        if (stop.load()) {
+            finalPoll = true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (result.usesRecords) {
+            UploadStatusSummaryRecord summary;
+            int count = GetAsyncUploadStatusRecords(dataId.c_str(), &summary, records.data(), fileCount);
+            result.latenciesUs.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+            if (count >= 0) {
+                checkRecords(dataId, summary, records, count, lastUploadedCount, result);
+            }
+        } else {
+            int size = GetAsyncUploadStatusDelta(dataId.c_str(), static_cast<double>(version),
+                                                 buffer.data(), static_cast<int>(buffer.size()));
+            result.latenciesUs.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+            if (size >= static_cast<int>(buffer.size())) {
+                // Truncated: ask again with room to spare from the same version
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+            String json(reinterpret_cast<const char*>(buffer.data()), size > 0 ? size : 0);
+            if (getJsonNumber(json, "code", -1) == UPLOAD_SUCCESS) {
+                long long responseVersion = getJsonNumber(json, "version", -1);
+                if (responseVersion < lastVersion) {
+                    result.fail("version went backwards");
+                }
+                lastVersion = responseVersion;
+                version = static_cast<unsigned long long>(responseVersion);
+                checkDelta(json, result);
+            }
+        }
+        result.polls++;
+        if (finalPoll) {
+            break;
+        }
+    }
+}
+
+// Outcome of one batch
+struct BatchResult {
+    double wallSeconds;
+    int failedCount;
+    std::vector<ReaderResult> readers;
+
+    BatchResult() : wallSeconds(0), failedCount(0) {}
+};
+
+// Upload every file under a new dataId while readerCount threads poll it
+static BatchResult runBatch(const StressOptions& options, const std::vector<String>& files, int readerCount,
+                            const String& name) {
+    BatchResult batch;
+    String runName = name + "-" + std::to_string(nowMs());
+    String dataId = "stress-" + runName;
+    String keyPrefix = "stress/" + runName + "/";
+
+    // Step 1: Start the readers; they see "unknown dataId" until the first submission
+    std::atomic<bool> stop(false);
+    batch.readers.resize(readerCount);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readerCount; i++) {
+        batch.readers[i].usesRecords = i % 2 == 0;
+        threads.emplace_back(runReader, dataId, options.fileCount, std::cref(stop), std::ref(batch.readers[i]));
+    }
+
+    // Step 2: Submit and wait for the batch
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < files.size(); i++) {
+        String objectKey = keyPrefix + std::to_string(i) + ".bin";
+        const char* response = UploadFileAsync(BENCH_ACCESS_KEY, BENCH_SECRET_KEY, "", options.region.c_str(),
+                                               options.bucket.c_str(), objectKey.c_str(), files[i].c_str(),
+                                               dataId.c_str());
+        if (!isSuccessResponse(response)) {
+            fprintf(stderr, "UploadFileAsync %s: %s\n", files[i].c_str(), response);
+            batch.failedCount++;
+        }
+    }
+    while (WaitForUploadsByDataId(dataId.c_str(), 200) == UPLOAD_UPLOADING) {
+    }
+    batch.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Step 3: Stop the readers, then check what they ended up with against the final records
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    UploadStatusSummaryRecord summary;
+    std::vector<UploadStatusRecord> records(files.size());
+    int count = GetAsyncUploadStatusRecords(dataId.c_str(), &summary, records.data(), static_cast<int>(records.size()));
+    for (int i = 0; i < count; i++) {
+        if (records[i].status != UPLOAD_SUCCESS) {
+            batch.failedCount++;
+        }
+    }
+    for (auto& reader : batch.readers) {
+        if (reader.usesRecords) {
+            continue;
+        }
+        if (reader.lastStatus.size() != static_cast<size_t>(count)) {
+            reader.fail("delta reader missed uploads");
+        }
+        for (int i = 0; i < count; i++) {
+            auto seen = reader.lastStatus.find(records[i].uploadId);
+            if (seen == reader.lastStatus.end() || seen->second != records[i].status) {
+                reader.fail(String("delta reader missed the final status of ") + records[i].uploadId);
+                break;
+            }
+        }
+    }
+    CleanupUploadsByDataId(dataId.c_str());
+    return batch;
+}
+
+static void printUsage() {
+    printf("Usage: S3UploadStatusStress [options]\n"
+           "  --endpoint URL     S3-compatible endpoint (default http://127.0.0.1:9000)\n"
+           "  --bucket NAME      bucket (default s3upload-bench)\n"
+           "  --region NAME      region used for signing (default us-east-1)\n"
+           "  --files N          uploads per batch (default 2000)\n"
+           "  --size BYTES       size of each file (default 4096)\n"
+           "  --readers N        status reader threads in the second batch (default 8)\n"
+           "  --concurrency N    SetMaxConcurrentUploads (default 16)\n"
+           "  --work-dir DIR     where the files are generated (default: temp dir)\n");
+}
+
+static bool parseOptions(int argc, char** argv, StressOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        String name = argv[i];
+        if (name == "--help" || name == "-h" || i + 1 >= argc) {
+            return false;
+        }
+        String value = argv[++i];
+        if (name == "--endpoint") options.endpoint = value;
+        else if (name == "--bucket") options.bucket = value;
+        else if (name == "--region") options.region = value;
+        else if (name == "--files") options.fileCount = std::max(1, atoi(value.c_str()));
+        else if (name == "--size") options.fileSize = std::max(1LL, atoll(value.c_str()));
+        else if (name == "--readers") options.readers = std::max(1, atoi(value.c_str()));
+        else if (name == "--concurrency") options.concurrency = atol(value.c_str());
+        else if (name == "--work-dir") options.workDir = value;
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    StressOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    // Step 1: Generate the files (one per upload, so coalescing never merges them)
+    if (options.workDir.empty()) {
+        char tempPath[MAX_PATH + 1];
+        DWORD length = GetTempPathA(sizeof(tempPath), tempPath);
+        options.workDir = String(tempPath, length) + "s3upload-stress";
+    }
+    String filesDir = options.workDir + PATH_SEPARATOR + "files";
+    if (!ensureDirectory(filesDir)) {
+        fprintf(stderr, "Cannot create %s\n", filesDir.c_str());
+        return 1;
+    }
+    std::vector<String> files;
+    for (int i = 0; i < options.fileCount; i++) {
+        String path = filesDir + PATH_SEPARATOR + "s" + std::to_string(i) + ".bin";
+        if (getExistingFileSize(path) != options.fileSize && !writeBenchFile(path, options.fileSize, i)) {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return 1;
+        }
+        files.push_back(path);
+    }
+
+    // Step 2: Point the library at the endpoint
+    if (getResponseCode(InitializeAwsSDK()) != SDK_INIT_SUCCESS) {
+        fprintf(stderr, "InitializeAwsSDK failed\n");
+        return 1;
+    }
+    SetS3Endpoint(options.endpoint.c_str());
+    if (options.concurrency > 0) {
+        SetMaxConcurrentUploads(options.concurrency);
+    }
+    // Keep every finished upload of a batch, so counts only grow and delta readers can see them all
+    SetUploadHistoryRetention(options.fileCount, 0);
+
+    // Step 3: The same batch without and with status readers
+    printf("%d file(s) of %lld bytes against %s, %d reader(s)\n", options.fileCount, options.fileSize,
+           options.endpoint.c_str(), options.readers);
+    BatchResult baseline = runBatch(options, files, 0, "baseline");
+    BatchResult polled = runBatch(options, files, options.readers, "polled");
+    CleanupAwsSDK();
+
+    // Step 4: Report
+    printf("%-9s %8s %10s %7s\n", "batch", "wall s", "uploads/s", "failed");
+    printf("%-9s %8.2f %10.1f %7d\n", "baseline", baseline.wallSeconds,
+           baseline.wallSeconds > 0 ? options.fileCount / baseline.wallSeconds : 0, baseline.failedCount);
+    printf("%-9s %8.2f %10.1f %7d\n", "polled", polled.wallSeconds,
+           polled.wallSeconds > 0 ? options.fileCount / polled.wallSeconds : 0, polled.failedCount);
+
+    printf("\n%-7s %-8s %9s %10s %10s %10s %10s\n",
+           "reader", "api", "polls", "polls/s", "p50 us", "p99 us", "max us");
+    size_t violations = 0;
+    for (size_t i = 0; i < polled.readers.size(); i++) {
+        ReaderResult& reader = polled.readers[i];
+        std::sort(reader.latenciesUs.begin(), reader.latenciesUs.end());
+        printf("%-7zu %-8s %9zu %10.0f %10.1f %10.1f %10.1f\n", i, reader.usesRecords ? "records" : "delta",
+               reader.polls, polled.wallSeconds > 0 ? reader.polls / polled.wallSeconds : 0,
+               percentile(reader.latenciesUs, 0.50), percentile(reader.latenciesUs, 0.99),
+               reader.latenciesUs.empty() ? 0 : reader.latenciesUs.back());
+        if (reader.violations > 0) {
+            fprintf(stderr, "reader %zu: %zu violation(s), first: %s\n", i, reader.violations,
+                    reader.firstViolation.c_str());
+            violations += reader.violations;
+        }
+    }
+    printf("\n%zu violation(s)\n", violations);
+    return violations == 0 && baseline.failedCount == 0 && polled.failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,445 @@
+#!/usr/bin/env python3
+"""Local S3 stand-in for the S3UploadLib benchmark suite.
+
+Implements the S3 calls the library makes, path-style and without checking signatures:
+PutObject, HeadObject, GetObject, CreateMultipartUpload, UploadPart, ListParts,
+CompleteMultipartUpload and AbortMultipartUpload. Request bodies may use aws-chunked
+encoding with a trailing checksum (what the SDK sends for CRC32C uploads) and HTTP
+chunked transfer encoding. Checksums are echoed back, not verified.
+
+Object data is discarded unless --data-dir is given, so the server stays out of the way
+of the client being measured; sizes and metadata are kept for HeadObject.
+
+Usage:
+    python3 local_s3_server.py --port 9000
+    python3 local_s3_server.py --port 9000 --data-dir /tmp/s3data --fail-rate 0.02 --latency-ms 20
+"""
+
+import argparse
+import base64
+import os
+import random
+import struct
+import sys
+import threading
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, unquote, urlsplit
+from xml.etree import ElementTree
+
+S3_XMLNS = "http://s3.amazonaws.com/doc/2006-03-01/"
+READ_SIZE = 1024 * 1024
+
+
+def make_crc32c_table():
+    table = []
+    for index in range(256):
+        crc = index
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x82F63B78 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+CRC32C_TABLE = make_crc32c_table()
+
+
+def crc32c(data):
+    crc = 0xFFFFFFFF
+    for byte in data:
+        crc = CRC32C_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8)
+    return crc ^ 0xFFFFFFFF
+
+
+def composite_crc32c(part_checksums):
+    """Checksum S3 reports for a multipart object: CRC32C of the part CRCs, '-' part count."""
+    raw = b"".join(base64.b64decode(checksum) for checksum in part_checksums)
+    return "%s-%d" % (base64.b64encode(struct.pack(">I", crc32c(raw))).decode(), len(part_checksums))
+
+
+class BufferedReader:
+    """read/readline over a function returning up to n bytes (b'' at the end)."""
+
+    def __init__(self, read_some):
+        self.read_some = read_some
+        self.buffer = b""
+        self.eof = False
+
+    def fill(self):
+        if not self.eof:
+            data = self.read_some(READ_SIZE)
+            if data:
+                self.buffer += data
+            else:
+                self.eof = True
+
+    def read(self, size):
+        while len(self.buffer) < size and not self.eof:
+            self.fill()
+        data, self.buffer = self.buffer[:size], self.buffer[size:]
+        return data
+
+    def readline(self):
+        while b"\n" not in self.buffer and not self.eof:
+            self.fill()
+        end = self.buffer.find(b"\n")
+        end = len(self.buffer) if end < 0 else end + 1
+        line, self.buffer = self.buffer[:end], self.buffer[end:]
+        return line
+
+
+def chunk_reader(source):
+    """Decode chunked framing (HTTP chunked and aws-chunked share it); returns data and trailers."""
+    trailers = {}
+
+    def chunks():
+        while True:
+            size_line = source.readline()
+            if not size_line:
+                return
+            # aws-chunked signed chunks add ";chunk-signature=..."
+            size = int(size_line.split(b";")[0].strip() or b"0", 16)
+            if size == 0:
+                break
+            remaining = size
+            while remaining > 0:
+                data = source.read(min(remaining, READ_SIZE))
+                if not data:
+                    return
+                remaining -= len(data)
+                yield data
+            source.readline()
+        while True:
+            line = source.readline().strip()
+            if not line:
+                return
+            name, _, value = line.decode("latin-1").partition(":")
+            trailers[name.strip().lower()] = value.strip()
+
+    return chunks(), trailers
+
+
+class ObjectStore:
+    def __init__(self, data_dir):
+        self.data_dir = data_dir
+        self.lock = threading.Lock()
+        # (bucket, key) -> {"size", "etag", "checksum", "metadata"}
+        self.objects = {}
+        # uploadId -> {"bucket", "key", "metadata", "parts": {number: {"size", "etag", "checksum"}}}
+        self.uploads = {}
+        self.bytes_received = 0
+
+    def object_path(self, bucket, key, suffix=""):
+        path = os.path.join(self.data_dir, bucket, key + suffix)
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        return path
+
+
+class S3Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "LocalS3"
+    store = None
+    options = None
+
+    def log_message(self, format, *args):
+        if self.options.verbose:
+            sys.stderr.write("%s - %s\n" % (self.address_string(), format % args))
+
+    # Step 1: Request parsing
+
+    def parse_target(self):
+        parts = urlsplit(self.path)
+        path = unquote(parts.path).lstrip("/")
+        bucket, _, key = path.partition("/")
+        query = parse_qs(parts.query, keep_blank_values=True)
+        return bucket, key, {name: values[0] for name, values in query.items()}
+
+    def body_chunks(self):
+        """Yield the decoded request body; returns a dict filled with aws-chunked trailers."""
+        if "chunked" in self.headers.get("Transfer-Encoding", "").lower():
+            http_chunks, _ = chunk_reader(BufferedReader(self.rfile.read1))
+            pending = iter(http_chunks)
+
+            def read_some(size):
+                return next(pending, b"")
+        else:
+            remaining = [int(self.headers.get("Content-Length", "0"))]
+
+            def read_some(size):
+                if remaining[0] <= 0:
+                    return b""
+                data = self.rfile.read(min(size, remaining[0]))
+                remaining[0] -= len(data)
+                return data
+
+        aws_chunked = ("aws-chunked" in self.headers.get("Content-Encoding", "") or
+                       self.headers.get("x-amz-content-sha256", "").startswith("STREAMING-"))
+        if aws_chunked:
+            return chunk_reader(BufferedReader(read_some))
+
+        def raw():
+            while True:
+                data = read_some(READ_SIZE)
+                if not data:
+                    return
+                yield data
+
+        return raw(), {}
+
+    def receive_body(self, path):
+        """Consume the body, writing it to path when given; returns (size, trailers)."""
+        chunks, trailers = self.body_chunks()
+        size = 0
+        output = open(path, "wb") if path else None
+        try:
+            for data in chunks:
+                size += len(data)
+                if output:
+                    output.write(data)
+        finally:
+            if output:
+                output.close()
+        with self.store.lock:
+            self.store.bytes_received += size
+        return size, trailers
+
+    def request_checksum(self, trailers):
+        return trailers.get("x-amz-checksum-crc32c") or self.headers.get("x-amz-checksum-crc32c", "")
+
+    def request_metadata(self):
+        return {name.lower(): value for name, value in self.headers.items()
+                if name.lower().startswith("x-amz-meta-")}
+
+    # Step 2: Responses
+
+    def send(self, status, body=b"", headers=None):
+        self.send_response(status)
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        if body:
+            self.send_header("Content-Type", "application/xml")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if body and self.command != "HEAD":
+            self.wfile.write(body)
+
+    def send_xml(self, root_name, fields):
+        root = ElementTree.Element(root_name, xmlns=S3_XMLNS)
+        for name, value in fields:
+            if isinstance(value, list):
+                element = ElementTree.SubElement(root, name)
+                for child_name, child_value in value:
+                    ElementTree.SubElement(element, child_name).text = str(child_value)
+            else:
+                ElementTree.SubElement(root, name).text = str(value)
+        self.send(200, b'<?xml version="1.0" encoding="UTF-8"?>' + ElementTree.tostring(root))
+
+    def send_error_xml(self, status, code, message):
+        root = ElementTree.Element("Error")
+        ElementTree.SubElement(root, "Code").text = code
+        ElementTree.SubElement(root, "Message").text = message
+        ElementTree.SubElement(root, "RequestId").text = uuid.uuid4().hex
+        self.send(status, b'<?xml version="1.0" encoding="UTF-8"?>' + ElementTree.tostring(root))
+
+    def inject_fault(self):
+        """Simulated latency and transient failures; the body must already be consumed."""
+        if self.options.latency_ms > 0:
+            time.sleep(self.options.latency_ms / 1000.0)
+        if self.options.fail_rate > 0 and random.random() < self.options.fail_rate:
+            self.send_error_xml(503, "SlowDown", "Injected failure (--fail-rate)")
+            return True
+        return False
+
+    # Step 3: Operations
+
+    def do_PUT(self):
+        bucket, key, query = self.parse_target()
+        if "uploadId" in query:
+            return self.upload_part(bucket, key, query)
+
+        path = self.store.object_path(bucket, key) if self.store.data_dir else None
+        size, trailers = self.receive_body(path)
+        if self.inject_fault():
+            return
+        etag = '"%s"' % uuid.uuid4().hex
+        checksum = self.request_checksum(trailers)
+        with self.store.lock:
+            self.store.objects[(bucket, key)] = {
+                "size": size, "etag": etag, "checksum": checksum, "metadata": self.request_metadata()}
+        headers = {"ETag": etag}
+        if checksum:
+            headers["x-amz-checksum-crc32c"] = checksum
+        self.send(200, headers=headers)
+
+    def upload_part(self, bucket, key, query):
+        upload_id = query["uploadId"]
+        part_number = int(query.get("partNumber", "0"))
+        with self.store.lock:
+            known = upload_id in self.store.uploads
+        path = None
+        if known and self.store.data_dir:
+            path = self.store.object_path(bucket, key, ".%s.part%05d" % (upload_id, part_number))
+        size, trailers = self.receive_body(path)
+        if not known:
+            return self.send_error_xml(404, "NoSuchUpload", "The specified upload does not exist.")
+        if self.inject_fault():
+            return
+        etag = '"%s"' % uuid.uuid4().hex
+        checksum = self.request_checksum(trailers)
+        with self.store.lock:
+            upload = self.store.uploads.get(upload_id)
+            if upload is not None:
+                upload["parts"][part_number] = {"size": size, "etag": etag, "checksum": checksum}
+        headers = {"ETag": etag}
+        if checksum:
+            headers["x-amz-checksum-crc32c"] = checksum
+        self.send(200, headers=headers)
+
+    def do_POST(self):
+        bucket, key, query = self.parse_target()
+        chunks, _ = self.body_chunks()
+        body = b"".join(chunks)
+        if self.inject_fault():
+            return
+
+        if "uploads" in query:
+            upload_id = uuid.uuid4().hex
+            with self.store.lock:
+                self.store.uploads[upload_id] = {
+                    "bucket": bucket, "key": key, "metadata": self.request_metadata(), "parts": {}}
+            return self.send_xml("InitiateMultipartUploadResult",
+                                 [("Bucket", bucket), ("Key", key), ("UploadId", upload_id)])
+
+        if "uploadId" in query:
+            return self.complete_upload(bucket, key, query["uploadId"], body)
+
+        self.send_error_xml(400, "InvalidRequest", "Unsupported POST")
+
+    def complete_upload(self, bucket, key, upload_id, body):
+        requested = []
+        for part in ElementTree.fromstring(body).iter():
+            if part.tag.endswith("PartNumber"):
+                requested.append(int(part.text))
+
+        with self.store.lock:
+            upload = self.store.uploads.get(upload_id)
+            if upload is None:
+                return self.send_error_xml(404, "NoSuchUpload", "The specified upload does not exist.")
+            missing = [number for number in requested if number not in upload["parts"]]
+            if missing:
+                return self.send_error_xml(400, "InvalidPart", "Part %d was not uploaded." % missing[0])
+            parts = [upload["parts"][number] for number in requested]
+            del self.store.uploads[upload_id]
+
+        checksums = [part["checksum"] for part in parts]
+        checksum = composite_crc32c(checksums) if checksums and all(checksums) else ""
+        etag = '"%s-%d"' % (uuid.uuid4().hex, len(parts))
+        if self.store.data_dir:
+            with open(self.store.object_path(bucket, key), "wb") as output:
+                for number in requested:
+                    part_path = self.store.object_path(bucket, key, ".%s.part%05d" % (upload_id, number))
+                    with open(part_path, "rb") as part_file:
+                        while True:
+                            data = part_file.read(READ_SIZE)
+                            if not data:
+                                break
+                            output.write(data)
+                    os.remove(part_path)
+        with self.store.lock:
+            self.store.objects[(bucket, key)] = {
+                "size": sum(part["size"] for part in parts), "etag": etag,
+                "checksum": checksum, "metadata": upload["metadata"]}
+
+        fields = [("Location", "/%s/%s" % (bucket, key)), ("Bucket", bucket), ("Key", key), ("ETag", etag)]
+        if checksum:
+            fields.append(("ChecksumCRC32C", checksum))
+        self.send_xml("CompleteMultipartUploadResult", fields)
+
+    def do_DELETE(self):
+        bucket, key, query = self.parse_target()
+        self.receive_body(None)
+        with self.store.lock:
+            if "uploadId" in query:
+                self.store.uploads.pop(query["uploadId"], None)
+            else:
+                self.store.objects.pop((bucket, key), None)
+        self.send(204)
+
+    def do_HEAD(self):
+        bucket, key, _ = self.parse_target()
+        with self.store.lock:
+            obj = self.store.objects.get((bucket, key))
+        if obj is None:
+            return self.send(404)
+        headers = dict(obj["metadata"])
+        headers["ETag"] = obj["etag"]
+        headers["Content-Length"] = str(obj["size"])
+        self.send_response(200)
+        for name, value in headers.items():
+            self.send_header(name, value)
+        self.end_headers()
+
+    def do_GET(self):
+        bucket, key, query = self.parse_target()
+        if "uploadId" in query:
+            return self.list_parts(bucket, key, query)
+
+        with self.store.lock:
+            obj = self.store.objects.get((bucket, key))
+        if obj is None:
+            return self.send_error_xml(404, "NoSuchKey", "The specified key does not exist.")
+        path = os.path.join(self.store.data_dir, bucket, key) if self.store.data_dir else None
+        if path is None or not os.path.exists(path):
+            return self.send_error_xml(501, "NotImplemented", "Object data is kept with --data-dir only.")
+        with open(path, "rb") as data:
+            body = data.read()
+        self.send_response(200)
+        self.send_header("ETag", obj["etag"])
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def list_parts(self, bucket, key, query):
+        upload_id = query["uploadId"]
+        with self.store.lock:
+            upload = self.store.uploads.get(upload_id)
+            parts = sorted(upload["parts"].items()) if upload is not None else None
+        if parts is None:
+            return self.send_error_xml(404, "NoSuchUpload", "The specified upload does not exist.")
+        max_parts = int(query.get("max-parts", "1000"))
+        fields = [("Bucket", bucket), ("Key", key), ("UploadId", upload_id),
+                  ("MaxParts", max_parts), ("IsTruncated", "true" if len(parts) > max_parts else "false")]
+        for number, part in parts[:max_parts]:
+            fields.append(("Part", [("PartNumber", number), ("ETag", part["etag"]), ("Size", part["size"])]))
+        self.send_xml("ListPartsResult", fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9000)
+    parser.add_argument("--data-dir", default="", help="keep object data here (default: discard)")
+    parser.add_argument("--fail-rate", type=float, default=0.0,
+                        help="fraction of requests answered with 503 SlowDown")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="delay added to every response")
+    parser.add_argument("--verbose", action="store_true", help="log every request")
+    options = parser.parse_args()
+
+    S3Handler.store = ObjectStore(options.data_dir)
+    S3Handler.options = options
+    server = ThreadingHTTPServer((options.host, options.port), S3Handler)
+    server.daemon_threads = True
+    print("Local S3 stand-in listening on http://%s:%d" % (options.host, options.port), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+        print("Received %d bytes" % S3Handler.store.bytes_received)
+
+
+if __name__ == "__main__":
+    main()
@@ -23,7 +23,133 @@ if %ERRORLEVEL% neq 0 (
     exit /b 1
 )
 
-echo Step 2: Compiling sync upload source file
+echo Step 2: Compiling client cache source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3ClientCache.obj" src\common\S3ClientCache.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3ClientCache.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 3: Compiling multipart upload source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3MultipartUpload.obj" src\common\S3MultipartUpload.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3MultipartUpload.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 4: Compiling upload worker pool source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadWorkerPool.obj" src\common\S3UploadWorkerPool.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadWorkerPool.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 5: Compiling upload journal source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadJournal.obj" src\common\S3UploadJournal.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadJournal.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 6: Compiling mapped file body source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3MappedFileBody.obj" src\common\S3MappedFileBody.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3MappedFileBody.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 7: Compiling bandwidth governor source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3BandwidthGovernor.obj" src\common\S3BandwidthGovernor.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3BandwidthGovernor.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 8: Compiling compression source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3EegCompression.obj" src\common\S3EegCompression.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3EegCompression.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 9: Compiling content index source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3ContentIndex.obj" src\common\S3ContentIndex.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3ContentIndex.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 10: Compiling retry policy source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3RetryPolicy.obj" src\common\S3RetryPolicy.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3RetryPolicy.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 11: Compiling upload bundle source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadBundle.obj" src\common\S3UploadBundle.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadBundle.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 12: Compiling upload metrics source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadMetrics.obj" src\common\S3UploadMetrics.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadMetrics.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 13: Compiling upload trace source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadTrace.obj" src\common\S3UploadTrace.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadTrace.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 14: Compiling upload history source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadHistory.obj" src\common\S3UploadHistory.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadHistory.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 15: Compiling upload backlog source file
+cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadBacklog.obj" src\common\S3UploadBacklog.cpp
+
+if %ERRORLEVEL% neq 0 (
+    echo Compilation of S3UploadBacklog.cpp failed!
+    pause
+    exit /b 1
+)
+
+echo Step 16: Compiling sync upload source file
 cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadSync.obj" src\uploadSync\S3UploadSync.cpp
 
 if %ERRORLEVEL% neq 0 (
@@ -32,7 +158,7 @@ if %ERRORLEVEL% neq 0 (
     exit /b 1
 )
 
-echo Step 3: Compiling async upload source file
+echo Step 17: Compiling async upload source file
 cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\S3UploadAsync.obj" src\uploadAsync\S3UploadAsync.cpp
 
 if %ERRORLEVEL% neq 0 (
@@ -41,7 +167,7 @@ if %ERRORLEVEL% neq 0 (
     exit /b 1
 )
 
-echo Step 4: Compiling main source file
+echo Step 18: Compiling main source file
 cl /std:c++14 /EHsc /MD /c /DS3UPLOAD_EXPORTS /I"aws-sdk-cpp\include" /Fo"build\main.obj" src\main.cpp
 
 if %ERRORLEVEL% neq 0 (
@@ -51,8 +177,8 @@ if %ERRORLEVEL% neq 0 (
 )
 
 echo.
-echo Step 5: Linking to create DLL...
-link /DLL /OUT:"build\S3UploadLib.dll" "build\S3Common.obj" "build\S3UploadSync.obj" "build\S3UploadAsync.obj" "build\main.obj" /LIBPATH:"aws-sdk-cpp\lib" aws-cpp-sdk-core.lib aws-cpp-sdk-s3.lib aws-c-common.lib aws-c-auth.lib aws-c-cal.lib aws-c-compression.lib aws-c-event-stream.lib aws-c-http.lib aws-c-io.lib aws-c-mqtt.lib aws-c-s3.lib aws-c-sdkutils.lib aws-checksums.lib aws-crt-cpp.lib zlib.lib kernel32.lib user32.lib advapi32.lib ws2_32.lib /DEF:S3UploadLib.def
+echo Step 19: Linking to create DLL...
+link /DLL /OUT:"build\S3UploadLib.dll" "build\S3Common.obj" "build\S3ClientCache.obj" "build\S3MultipartUpload.obj" "build\S3UploadWorkerPool.obj" "build\S3UploadJournal.obj" "build\S3MappedFileBody.obj" "build\S3BandwidthGovernor.obj" "build\S3EegCompression.obj" "build\S3ContentIndex.obj" "build\S3RetryPolicy.obj" "build\S3UploadBundle.obj" "build\S3UploadMetrics.obj" "build\S3UploadTrace.obj" "build\S3UploadHistory.obj" "build\S3UploadBacklog.obj" "build\S3UploadSync.obj" "build\S3UploadAsync.obj" "build\main.obj" /LIBPATH:"aws-sdk-cpp\lib" aws-cpp-sdk-core.lib aws-cpp-sdk-s3.lib aws-c-common.lib aws-c-auth.lib aws-c-cal.lib aws-c-compression.lib aws-c-event-stream.lib aws-c-http.lib aws-c-io.lib aws-c-mqtt.lib aws-c-s3.lib aws-c-sdkutils.lib aws-checksums.lib aws-crt-cpp.lib zlib.lib zstd.lib kernel32.lib user32.lib advapi32.lib ws2_32.lib /DEF:S3UploadLib.def
 
 if %ERRORLEVEL% neq 0 (
     echo Linking failed!
@@ -61,7 +187,7 @@ if %ERRORLEVEL% neq 0 (
 )
 
 echo.
-echo Step 6: Copying AWS SDK DLLs to build directory...
+echo Step 20: Copying AWS SDK DLLs to build directory...
 copy "aws-sdk-cpp\bin\*.dll" "build\" >nul 2>&1
 echo AWS SDK DLLs copied to build directory
 
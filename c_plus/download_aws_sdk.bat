@@ -58,10 +58,10 @@ if %errorlevel% neq 0 (
 )
 cd ..
 
-REM Step 3: Install AWS SDK (32-bit)
-echo Step 3: Installing AWS SDK (32-bit)...
+REM Step 3: Install AWS SDK and zstd (32-bit)
+echo Step 3: Installing AWS SDK and zstd (32-bit)...
 echo This may take a while...
-"%VCPKG_DIR%\vcpkg.exe" install aws-sdk-cpp[s3]:x86-windows
+"%VCPKG_DIR%\vcpkg.exe" install aws-sdk-cpp[s3]:x86-windows zstd:x86-windows
 if %errorlevel% neq 0 (
     echo Failed to install AWS SDK.
     pause
@@ -0,0 +1,230 @@
+#include "S3BandwidthGovernor.h"
+#include "S3UploadMetrics.h"
+
+// Upload the current thread is sending for (see BandwidthAccountingScope)
+static thread_local AsyncUploadProgress* t_accountingProgress = nullptr;
+
+static long long steadyNowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Minutes since local midnight
+static int getLocalMinuteOfDay() {
+    SYSTEMTIME localTime;
+    GetLocalTime(&localTime);
+    return localTime.wHour * 60 + localTime.wMinute;
+}
+
+BandwidthGovernor::BandwidthGovernor()
+    : baseBytesPerSecond_(0),
+      activeBytesPerSecond_(0),
+      nextFreeMicros_(0) {}
+
+std::shared_ptr<BandwidthGovernor> BandwidthGovernor::getInstance() {
+    static std::shared_ptr<BandwidthGovernor> instance = std::make_shared<BandwidthGovernor>();
+    return instance;
+}
+
+long long BandwidthGovernor::getEffectiveRateLocked() const {
+    if (schedule_.empty()) {
+        return baseBytesPerSecond_;
+    }
+
+    int minute = getLocalMinuteOfDay();
+    for (const auto& entry : schedule_) {
+        bool inWindow = entry.startMinute <= entry.endMinute
+            ? (minute >= entry.startMinute && minute < entry.endMinute)
+            : (minute >= entry.startMinute || minute < entry.endMinute);
+        if (inWindow) {
+            return entry.bytesPerSecond;
+        }
+    }
+    return baseBytesPerSecond_;
+}
+
+void BandwidthGovernor::applyRateLocked(long long bytesPerSecond, long long nowMicros) {
+    if (bytesPerSecond == activeBytesPerSecond_) {
+        return;
+    }
+
+    // Rescale the backlog already reserved so waiting senders share the new rate
+    if (bytesPerSecond <= 0 || activeBytesPerSecond_ <= 0) {
+        nextFreeMicros_ = nowMicros;
+    } else if (nextFreeMicros_ > nowMicros) {
+        double backlog = static_cast<double>(nextFreeMicros_ - nowMicros);
+        nextFreeMicros_ = nowMicros + static_cast<long long>(
+            backlog * static_cast<double>(activeBytesPerSecond_) / static_cast<double>(bytesPerSecond));
+    }
+    activeBytesPerSecond_ = bytesPerSecond;
+}
+
+BandwidthGovernor::DelayType BandwidthGovernor::ApplyCost(int64_t cost) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    long long now = steadyNowMicros();
+    applyRateLocked(getEffectiveRateLocked(), now);
+    if (activeBytesPerSecond_ <= 0 || cost <= 0) {
+        return DelayType(0);
+    }
+
+    // Step 1: Reserve the bytes after everything reserved before (arrival order = fair share)
+    long long start = std::max(nextFreeMicros_, now - BANDWIDTH_BURST_MICROSECONDS);
+    nextFreeMicros_ = start + static_cast<long long>(
+        static_cast<double>(cost) * 1000000.0 / static_cast<double>(activeBytesPerSecond_));
+
+    // Step 2: Wait until the reservation falls inside the burst allowance
+    long long waitMicros = nextFreeMicros_ - now - BANDWIDTH_BURST_MICROSECONDS;
+    if (waitMicros <= 0) {
+        return DelayType(0);
+    }
+    return std::chrono::duration_cast<DelayType>(std::chrono::microseconds(waitMicros));
+}
+
+void BandwidthGovernor::ApplyAndPayForCost(int64_t cost) {
+    // Every client writes through the governor, so this sees all bytes sent
+    UploadMetrics::getInstance().addBytesSent(cost);
+    DelayType delay = ApplyCost(cost);
+    if (delay.count() <= 0) {
+        return;
+    }
+
+    // Sleep in slices so a cancelled upload stops waiting and its request can be aborted
+    AsyncUploadProgress* progress = t_accountingProgress;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + delay;
+    while (progress == nullptr || !progress->shouldCancel.load()) {
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            remaining, std::chrono::milliseconds(BANDWIDTH_CANCEL_CHECK_MS)));
+    }
+    if (progress != nullptr) {
+        progress->throttledMs += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void BandwidthGovernor::SetRate(int64_t rate, bool resetAccumulator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    baseBytesPerSecond_ = rate > 0 ? rate : 0;
+    long long now = steadyNowMicros();
+    if (resetAccumulator) {
+        nextFreeMicros_ = now;
+    }
+    applyRateLocked(getEffectiveRateLocked(), now);
+}
+
+void BandwidthGovernor::setSchedule(const std::vector<BandwidthScheduleEntry>& schedule) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedule_ = schedule;
+    applyRateLocked(getEffectiveRateLocked(), steadyNowMicros());
+}
+
+long long BandwidthGovernor::getEffectiveRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getEffectiveRateLocked();
+}
+
+BandwidthAccountingScope::BandwidthAccountingScope(AsyncUploadProgress* progress)
+    : previous_(t_accountingProgress) {
+    t_accountingProgress = progress;
+}
+
+BandwidthAccountingScope::~BandwidthAccountingScope() {
+    t_accountingProgress = previous_;
+}
+
+AsyncUploadProgress* getCurrentAccountingUpload() {
+    return t_accountingProgress;
+}
+
+// Parse "HH:MM" into minutes since midnight, -1 on error
+static int parseMinuteOfDay(const String& text) {
+    int hours = 0;
+    int minutes = 0;
+    char separator = 0;
+    std::istringstream iss(text);
+    if (!(iss >> hours >> separator >> minutes) || separator != ':' ||
+        hours < 0 || hours > 24 || minutes < 0 || minutes > 59 || (hours == 24 && minutes != 0)) {
+        return -1;
+    }
+    return hours * 60 + minutes;
+}
+
+// Parse "HH:MM-HH:MM=KBps;..." into schedule entries
+static bool parseBandwidthSchedule(const String& text, std::vector<BandwidthScheduleEntry>& schedule) {
+    std::istringstream iss(text);
+    String item;
+    while (std::getline(iss, item, ';')) {
+        item.erase(std::remove(item.begin(), item.end(), ' '), item.end());
+        if (item.empty()) {
+            continue;
+        }
+
+        size_t dash = item.find('-');
+        size_t equals = item.find('=');
+        if (dash == String::npos || equals == String::npos || equals < dash) {
+            return false;
+        }
+
+        BandwidthScheduleEntry entry;
+        entry.startMinute = parseMinuteOfDay(item.substr(0, dash));
+        entry.endMinute = parseMinuteOfDay(item.substr(dash + 1, equals - dash - 1));
+        if (entry.startMinute < 0 || entry.endMinute < 0 || entry.startMinute == entry.endMinute) {
+            return false;
+        }
+        try {
+            long long limitKBps = std::stoll(item.substr(equals + 1));
+            entry.bytesPerSecond = limitKBps > 0 ? limitKBps * 1024 : 0;
+        } catch (const std::exception&) {
+            return false;
+        }
+        schedule.push_back(entry);
+    }
+    return true;
+}
+
+// Set the process-wide upload bandwidth limit in KB/s (0 = unlimited)
+// Applies immediately to every running upload, including multipart parts
+extern "C" S3UPLOAD_API const char* __stdcall SetBandwidthLimit(long limitKBps) {
+    static std::string response;
+
+    if (limitKBps < 0) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    auto governor = BandwidthGovernor::getInstance();
+    governor->SetRate(static_cast<int64_t>(limitKBps) * 1024);
+
+    if (limitKBps == 0) {
+        response = create_response(UPLOAD_SUCCESS, "Bandwidth limit removed");
+    } else {
+        response = create_response(UPLOAD_SUCCESS, "Bandwidth limit set to " + std::to_string(limitKBps) + " KB/s");
+    }
+    return response.c_str();
+}
+
+// Set a time-of-day bandwidth schedule, e.g. "07:00-18:00=256;18:00-07:00=0" (KB/s, local time)
+// The first matching window wins; outside all windows the SetBandwidthLimit value applies.
+// NULL or "" removes the schedule.
+extern "C" S3UPLOAD_API const char* __stdcall SetBandwidthSchedule(const char* schedule) {
+    static std::string response;
+
+    std::vector<BandwidthScheduleEntry> entries;
+    if (schedule && !parseBandwidthSchedule(schedule, entries)) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Invalid bandwidth schedule", schedule));
+        return response.c_str();
+    }
+
+    auto governor = BandwidthGovernor::getInstance();
+    governor->setSchedule(entries);
+
+    std::ostringstream oss;
+    oss << "Bandwidth schedule set with " << entries.size() << " window(s), current limit "
+        << governor->getEffectiveRate() / 1024 << " KB/s";
+    response = create_response(UPLOAD_SUCCESS, oss.str());
+    return response.c_str();
+}
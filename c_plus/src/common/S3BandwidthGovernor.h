@@ -0,0 +1,88 @@
+#ifndef S3BANDWIDTHGOVERNOR_H
+#define S3BANDWIDTHGOVERNOR_H
+
+#include "S3Common.h"
+
+#include <aws/core/utils/ratelimiter/RateLimiterInterface.h>
+
+// Burst allowance: senders may run this far ahead of the configured rate
+static const long long BANDWIDTH_BURST_MICROSECONDS = 250 * 1000;
+// Slice of a throttled sleep between cancellation checks
+static const long long BANDWIDTH_CANCEL_CHECK_MS = 100;
+
+// One time-of-day window of a bandwidth schedule
+// Windows may wrap midnight (e.g. 18:00-07:00); limit 0 means unlimited
+struct BandwidthScheduleEntry {
+    int startMinute;
+    int endMinute;
+    long long bytesPerSecond;
+};
+
+// Process-wide upload bandwidth limit shared by every S3 client
+// Installed as the clients' writeRateLimiter, so sync uploads, async uploads and
+// multipart parts all draw from the same budget. Each send reserves its bytes in
+// arrival order (GCRA token bucket), which splits the rate evenly between the
+// uploads that are sending; a rate change rescales reservations already made.
+class BandwidthGovernor : public Aws::Utils::RateLimits::RateLimiterInterface {
+private:
+    mutable std::mutex mutex_;
+    // Limit used outside schedule windows (bytes per second, 0 = unlimited)
+    long long baseBytesPerSecond_;
+    std::vector<BandwidthScheduleEntry> schedule_;
+    // Rate the last reservation was made with
+    long long activeBytesPerSecond_;
+    // Theoretical arrival time of the next byte (steady clock, microseconds)
+    long long nextFreeMicros_;
+
+    // Get the limit for the current local time (mutex_ must be held)
+    long long getEffectiveRateLocked() const;
+
+    // Switch to a new rate, rescaling outstanding reservations (mutex_ must be held)
+    void applyRateLocked(long long bytesPerSecond, long long nowMicros);
+
+public:
+    BandwidthGovernor();
+
+    // Get the shared governor installed on every S3 client
+    static std::shared_ptr<BandwidthGovernor> getInstance();
+
+    // Reserve bandwidth for cost bytes and return how long the caller must wait
+    DelayType ApplyCost(int64_t cost) override;
+
+    // Reserve bandwidth for cost bytes and sleep until it is available
+    // Called by the HTTP client for every chunk it writes; the sleep ends early
+    // once the upload being sent for is cancelled
+    void ApplyAndPayForCost(int64_t cost) override;
+
+    // Set the base limit in bytes per second (0 = unlimited)
+    void SetRate(int64_t rate, bool resetAccumulator = false) override;
+
+    // Replace the time-of-day schedule (empty = always use the base limit)
+    void setSchedule(const std::vector<BandwidthScheduleEntry>& schedule);
+
+    // Get the limit in effect right now (bytes per second, 0 = unlimited)
+    long long getEffectiveRate() const;
+};
+
+// Attributes time spent waiting on the governor to an upload
+// Uploads run synchronously on the calling thread, so the scope marks the upload
+// the current thread is sending for while the SDK request is in flight.
+class BandwidthAccountingScope {
+private:
+    AsyncUploadProgress* previous_;
+
+public:
+    explicit BandwidthAccountingScope(AsyncUploadProgress* progress);
+    ~BandwidthAccountingScope();
+};
+
+// Get the upload the current thread is sending for, nullptr outside a BandwidthAccountingScope
+AsyncUploadProgress* getCurrentAccountingUpload();
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetBandwidthLimit(long limitKBps);
+    S3UPLOAD_API const char* __stdcall SetBandwidthSchedule(const char* schedule);
+}
+
+// S3BANDWIDTHGOVERNOR_H
+#endif
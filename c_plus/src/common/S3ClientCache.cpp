@@ -0,0 +1,157 @@
+#include "S3ClientCache.h"
+
+// S3-compatible endpoint used instead of AWS (SetS3Endpoint); empty for AWS
+static std::mutex g_endpointMutex;
+static String g_endpointOverride;
+
+S3ClientCache& S3ClientCache::getInstance() {
+    static S3ClientCache instance;
+    return instance;
+}
+
+String S3ClientCache::makeKey(const String& accessKey, const String& sessionToken, const String& region) {
+    // Newline cannot appear in any of the fields, so it is a safe separator
+    return accessKey + "\n" + sessionToken + "\n" + region;
+}
+
+bool S3ClientCache::isExpired(const Entry& entry, std::chrono::steady_clock::time_point now) {
+    if (entry.hasSessionToken &&
+        now - entry.createdTime >= std::chrono::seconds(CLIENT_CACHE_SESSION_TTL_SECONDS)) {
+        return true;
+    }
+    return now - entry.lastUsedTime >= std::chrono::seconds(CLIENT_CACHE_IDLE_TTL_SECONDS);
+}
+
+void S3ClientCache::evictLocked(std::chrono::steady_clock::time_point now) {
+    // Step 1: Drop entries whose STS session or idle time has run out
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (isExpired(it->second, now)) {
+            it = entries_.erase(it);
+            evictions_++;
+        } else {
+            ++it;
+        }
+    }
+
+    // Step 2: Trim least recently used entries above the size limit
+    while (entries_.size() > CLIENT_CACHE_MAX_ENTRIES) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.lastUsedTime < oldest->second.lastUsedTime) {
+                oldest = it;
+            }
+        }
+        entries_.erase(oldest);
+        evictions_++;
+    }
+}
+
+std::shared_ptr<Aws::S3::S3Client> S3ClientCache::acquire(const String& accessKey,
+                                                          const String& secretKey,
+                                                          const String& sessionToken,
+                                                          const String& region) {
+    String key = makeKey(accessKey, sessionToken, region);
+    auto now = std::chrono::steady_clock::now();
+
+    // Step 1: Return a live cached client
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evictLocked(now);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.secretKey == secretKey) {
+            it->second.lastUsedTime = now;
+            hits_++;
+            return it->second.client;
+        }
+    }
+
+    // Step 2: Build a new client outside the lock (this is the slow part)
+    misses_++;
+    std::shared_ptr<Aws::S3::S3Client> client = createS3Client(accessKey, secretKey, sessionToken, region);
+
+    // Step 3: Publish it; if another thread raced us, keep theirs
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second.secretKey == secretKey) {
+        it->second.lastUsedTime = now;
+        return it->second.client;
+    }
+
+    Entry entry;
+    entry.secretKey = secretKey;
+    entry.client = client;
+    entry.hasSessionToken = !sessionToken.empty();
+    entry.createdTime = now;
+    entry.lastUsedTime = now;
+    entries_[key] = entry;
+    evictLocked(now);
+    return client;
+}
+
+void S3ClientCache::invalidate(const String& accessKey, const String& sessionToken, const String& region) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.erase(makeKey(accessKey, sessionToken, region)) > 0) {
+        evictions_++;
+    }
+}
+
+void S3ClientCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t S3ClientCache::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+String getS3EndpointOverride() {
+    std::lock_guard<std::mutex> lock(g_endpointMutex);
+    return g_endpointOverride;
+}
+
+std::shared_ptr<Aws::S3::S3Client> acquireS3Client(const String& accessKey,
+                                                   const String& secretKey,
+                                                   const String& sessionToken,
+                                                   const String& region) {
+    return S3ClientCache::getInstance().acquire(accessKey, secretKey, sessionToken, region);
+}
+
+// Get client cache statistics as JSON
+// { "code": 2, "hits": 10, "misses": 1, "evictions": 0, "size": 1 }
+extern "C" S3UPLOAD_API const char* __stdcall GetS3ClientCacheStats() {
+    static std::string response;
+
+    auto& cache = S3ClientCache::getInstance();
+    std::ostringstream oss;
+    oss << "{"
+        << "\"code\":" << UPLOAD_SUCCESS << ","
+        << "\"hits\":" << cache.getHits() << ","
+        << "\"misses\":" << cache.getMisses() << ","
+        << "\"evictions\":" << cache.getEvictions() << ","
+        << "\"size\":" << cache.getSize()
+        << "}";
+    response = oss.str();
+    return response.c_str();
+}
+
+// Send uploads to an S3-compatible endpoint instead of AWS, e.g. "http://127.0.0.1:9000"
+// for the local stand-in server of the benchmark suite. Buckets are addressed path-style.
+// An empty string switches back to AWS. Cached clients are dropped so the next upload uses it.
+extern "C" S3UPLOAD_API const char* __stdcall SetS3Endpoint(const char* endpoint) {
+    static std::string response;
+
+    String value = endpoint ? endpoint : "";
+    {
+        std::lock_guard<std::mutex> lock(g_endpointMutex);
+        g_endpointOverride = value;
+    }
+    S3ClientCache::getInstance().clear();
+
+    if (value.empty()) {
+        response = create_response(UPLOAD_SUCCESS, "S3 endpoint reset to AWS");
+    } else {
+        response = create_response(UPLOAD_SUCCESS, "S3 endpoint set to " + value);
+    }
+    return response.c_str();
+}
@@ -0,0 +1,81 @@
+#ifndef S3CLIENTCACHE_H
+#define S3CLIENTCACHE_H
+
+#include "S3Common.h"
+
+// Client cache configuration
+// STS sessions issued by the backend last one hour; drop cached clients a bit earlier
+static const int CLIENT_CACHE_SESSION_TTL_SECONDS = 55 * 60;
+// Clients not used for this long are dropped even with permanent credentials
+static const int CLIENT_CACHE_IDLE_TTL_SECONDS = 15 * 60;
+// Maximum number of cached clients; least recently used is evicted first
+static const size_t CLIENT_CACHE_MAX_ENTRIES = 16;
+
+// Thread-safe cache of S3 clients keyed by (accessKey, sessionToken, region)
+// Reusing a client keeps its HTTP connections (and TLS sessions) warm between uploads.
+class S3ClientCache {
+private:
+    struct Entry {
+        // Secret key the client was built with; a mismatch forces a rebuild
+        String secretKey;
+        std::shared_ptr<Aws::S3::S3Client> client;
+        bool hasSessionToken;
+        std::chrono::steady_clock::time_point createdTime;
+        std::chrono::steady_clock::time_point lastUsedTime;
+    };
+
+    mutable std::mutex mutex_;                  // Protects entries_
+    std::unordered_map<String, Entry> entries_; // Cache key to cached client
+    std::atomic<long long> hits_;
+    std::atomic<long long> misses_;
+    std::atomic<long long> evictions_;
+
+    // Build the map key from the cache key fields
+    static String makeKey(const String& accessKey, const String& sessionToken, const String& region);
+
+    // Check whether an entry is past its session or idle lifetime
+    static bool isExpired(const Entry& entry, std::chrono::steady_clock::time_point now);
+
+    // Drop expired entries and trim to CLIENT_CACHE_MAX_ENTRIES (mutex_ must be held)
+    void evictLocked(std::chrono::steady_clock::time_point now);
+
+public:
+    S3ClientCache() : hits_(0), misses_(0), evictions_(0) {}
+
+    // Get singleton instance of the cache
+    static S3ClientCache& getInstance();
+
+    // Return a cached client for these credentials or build and cache a new one
+    std::shared_ptr<Aws::S3::S3Client> acquire(const String& accessKey,
+                                               const String& secretKey,
+                                               const String& sessionToken,
+                                               const String& region);
+
+    // Drop the client for these credentials (e.g. after an expired token error)
+    void invalidate(const String& accessKey, const String& sessionToken, const String& region);
+
+    // Drop all cached clients (must run before Aws::ShutdownAPI)
+    void clear();
+
+    long long getHits() const { return hits_.load(); }
+    long long getMisses() const { return misses_.load(); }
+    long long getEvictions() const { return evictions_.load(); }
+    size_t getSize() const;
+};
+
+// Get an S3 client from the process-wide cache
+std::shared_ptr<Aws::S3::S3Client> acquireS3Client(const String& accessKey,
+                                                   const String& secretKey,
+                                                   const String& sessionToken,
+                                                   const String& region);
+
+// Endpoint set with SetS3Endpoint; empty for the regional AWS endpoint
+String getS3EndpointOverride();
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall GetS3ClientCacheStats();
+    S3UPLOAD_API const char* __stdcall SetS3Endpoint(const char* endpoint);
+}
+
+// S3CLIENTCACHE_H
+#endif
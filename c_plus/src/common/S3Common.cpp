@@ -1,4 +1,11 @@
 #include "S3Common.h"
+#include "S3UploadWorkerPool.h"
+#include "S3ClientCache.h"
+#include "S3BandwidthGovernor.h"
+#include "S3UploadBundle.h"
+#include "S3UploadMetrics.h"
+#include "S3UploadBacklog.h"
+#include "S3MultipartUpload.h"
 
 // Global variables
 bool g_isInitialized = false;
@@ -8,11 +15,35 @@ String create_response(int code, const String& message) {
     std::ostringstream oss;
     oss << "{"
         << "\"code\":" << code << ","
-        << "\"message\":\"" << message << "\""
+        << "\"message\":\"" << escapeJson(message) << "\""
         << "}";
     return oss.str();
 }
 
+String escapeJson(const String& value) {
+    String escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char unicodeEscape[8];
+                    snprintf(unicodeEscape, sizeof(unicodeEscape), "\\u%04x", static_cast<unsigned char>(c));
+                    escaped += unicodeEscape;
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
 // Format error message helper function
 String formatErrorMessage(const String& baseMessage, const String& detail) {
     if (detail.empty()) {
@@ -21,6 +52,207 @@ String formatErrorMessage(const String& baseMessage, const String& detail) {
     return baseMessage + ": " + detail;
 }
 
+// Milliseconds on the steady clock, used for lock-free throughput sampling
+static long long steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AsyncUploadProgress::addBytesSent(long long bytes) {
+    long long total = (bytesSent += bytes);
+    long long now = steadyNowMs();
+
+    // Step 1: First callback only opens the sample window
+    long long lastTime = lastSampleTimeMs.load();
+    if (lastTime == 0) {
+        if (lastSampleTimeMs.compare_exchange_strong(lastTime, now)) {
+            lastSampleBytes = total;
+        }
+        return;
+    }
+
+    // Step 2: Once per window, one callback wins the CAS and folds in a new sample
+    if (now - lastTime < THROUGHPUT_SAMPLE_WINDOW_MS ||
+        !lastSampleTimeMs.compare_exchange_strong(lastTime, now)) {
+        return;
+    }
+    long long previousBytes = lastSampleBytes.exchange(total);
+    double sample = static_cast<double>(total - previousBytes) * 1000.0 / static_cast<double>(now - lastTime);
+    if (sample < 0) {
+        sample = 0;
+    }
+    double previous = throughputBytesPerSec.load();
+    throughputBytesPerSec = previous <= 0 ? sample
+        : THROUGHPUT_SMOOTHING_FACTOR * sample + (1.0 - THROUGHPUT_SMOOTHING_FACTOR) * previous;
+
+    // Step 3: Publish byte progress to delta status queries once per window, not per callback
+    markChanged();
+}
+
+void AsyncUploadProgress::markChanged() {
+    changeVersion = AsyncUploadManager::getInstance().nextChangeVersion();
+}
+
+void AsyncUploadProgress::rollbackBytesSent(long long bytes) {
+    bytesSent -= bytes;
+    lastSampleBytes -= bytes;
+}
+
+long long AsyncUploadProgress::getBytesSent() const {
+    long long sent = bytesSent.load();
+    long long size = totalSize.load();
+    if (sent < 0) {
+        return 0;
+    }
+    return (size > 0 && sent > size) ? size : sent;
+}
+
+double AsyncUploadProgress::getThroughput() const {
+    if (status != UPLOAD_UPLOADING) {
+        return 0;
+    }
+    double smoothed = throughputBytesPerSec.load();
+    long long lastTime = lastSampleTimeMs.load();
+    long long idleMs = steadyNowMs() - lastTime;
+
+    // No callback for several windows: decay towards the rate since the last sample
+    if (lastTime > 0 && idleMs > 2 * THROUGHPUT_SAMPLE_WINDOW_MS) {
+        double recent = static_cast<double>(bytesSent.load() - lastSampleBytes.load()) * 1000.0 / static_cast<double>(idleMs);
+        if (recent < 0) {
+            recent = 0;
+        }
+        return THROUGHPUT_SMOOTHING_FACTOR * recent + (1.0 - THROUGHPUT_SMOOTHING_FACTOR) * smoothed;
+    }
+    return smoothed;
+}
+
+long long AsyncUploadProgress::getEtaSeconds() const {
+    if (status == UPLOAD_SUCCESS) {
+        return 0;
+    }
+    double throughput = getThroughput();
+    long long size = totalSize.load();
+    if (throughput <= 0 || size <= 0) {
+        return -1;
+    }
+    long long remaining = size - getBytesSent();
+    return static_cast<long long>(static_cast<double>(remaining) / throughput + 0.5);
+}
+
+long long AsyncUploadProgress::getPhaseMs(UploadPhase phase) const {
+    // Phase boundaries in order; phase i runs from boundary i to the next recorded one
+    const std::chrono::steady_clock::time_point boundaries[] = {
+        queuedTime, startTime, clientStartTime, openStartTime, transferStartTime, endTime
+    };
+    const int boundaryCount = static_cast<int>(sizeof(boundaries) / sizeof(boundaries[0]));
+    auto isRecorded = [](const std::chrono::steady_clock::time_point& timePoint) {
+        return timePoint.time_since_epoch().count() > 0;
+    };
+
+    int first = phase == UPLOAD_PHASE_TOTAL ? 0 : static_cast<int>(phase);
+    if (!isRecorded(boundaries[first])) {
+        return -1;
+    }
+    int next = phase == UPLOAD_PHASE_TOTAL ? boundaryCount - 1 : first + 1;
+    while (next < boundaryCount - 1 && !isRecorded(boundaries[next])) {
+        next++;
+    }
+    auto end = isRecorded(boundaries[next]) ? boundaries[next] : std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - boundaries[first]).count();
+}
+
+void AsyncUploadManager::sumProgress(const DataIdView& view, DataIdProgressTotals& totals) {
+    // Finished and queued uploads come from the aggregates; only the others need their live counters
+    const DataIdSummary& summary = view.summary;
+    totals.uploadedSize = summary.statusSizes[UPLOAD_SUCCESS];
+    totals.remainingSize = summary.statusSizes[UPLOAD_PENDING];
+    totals.throughput = 0;
+    totals.totalFileCount = static_cast<int>(summary.backlogFileCount);
+    totals.uploadedFileCount = 0;
+    view.uploads.forEach([&totals](const UploadSlot& slot) {
+        // Finished uploads in the history add their files and, unless they succeeded, the bytes they sent
+        const auto& progress = slot.progress;
+        if (!progress) {
+            const UploadHistoryEntry& entry = *slot.entry;
+            int fileCount = entry.bundle ? static_cast<int>(entry.bundle->fileCount) : 1;
+            totals.totalFileCount += fileCount;
+            if (entry.status == UPLOAD_SUCCESS) {
+                totals.uploadedFileCount += fileCount;
+            } else {
+                totals.uploadedSize += entry.bytesSent;
+            }
+            return true;
+        }
+
+        // A bundle counts once per file it carries
+        int fileCount = progress->bundle ? static_cast<int>(progress->bundle->fileCount) : 1;
+        totals.totalFileCount += fileCount;
+        UploadStatus status = progress->status;
+        if (status == UPLOAD_SUCCESS) {
+            totals.uploadedFileCount += fileCount;
+            return true;
+        }
+        if (status == UPLOAD_PENDING) {
+            return true;
+        }
+        // Bytes already on the wire count as uploaded, not only finished files
+        long long sent = progress->getBytesSent();
+        totals.uploadedSize += sent;
+        totals.throughput += progress->getThroughput();
+        if (status == UPLOAD_UPLOADING) {
+            totals.remainingSize += progress->totalSize - sent;
+        }
+        return true;
+    });
+}
+
+void UploadSlotList::push_back(const UploadSlot& slot) {
+    // Fill the last chunk (as a copy, it may be shared) before starting a new one
+    std::shared_ptr<Chunk> chunk;
+    if (!chunks_.empty() && chunks_.back()->size() < UPLOAD_SLOT_CHUNK_SIZE) {
+        chunk = std::make_shared<Chunk>();
+        chunk->reserve(chunks_.back()->size() + 1);
+        chunk->assign(chunks_.back()->begin(), chunks_.back()->end());
+        chunks_.back() = chunk;
+    } else {
+        chunk = std::make_shared<Chunk>();
+        chunks_.push_back(chunk);
+    }
+    chunk->push_back(slot);
+    size_++;
+}
+
+void AsyncUploadManager::publishChangesLocked() {
+    // Step 1: A new view for every changed group; readers still holding the old one keep it
+    for (const String& dataId : changedGroups_) {
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end() || !groupIt->second.changed) {
+            continue;
+        }
+        DataIdGroup& group = groupIt->second;
+        auto view = std::make_shared<DataIdView>();
+        view->summary = group.summary;
+        view->uploads = group.uploads;
+        std::atomic_store(&group.cell->view, std::shared_ptr<const DataIdView>(view));
+        group.changed = false;
+    }
+    changedGroups_.clear();
+
+    // Step 2: The directory, once every group it lists has a view
+    if (directoryChanged_) {
+        auto directory = std::make_shared<DataIdDirectory>();
+        directory->reserve(dataIdGroups_.size());
+        for (const auto& group : dataIdGroups_) {
+            directory->emplace(group.first, group.second.cell);
+        }
+        std::atomic_store(&directory_, std::shared_ptr<const DataIdDirectory>(directory));
+        directoryChanged_ = false;
+    }
+
+    historySize_ = history_.size();
+    publishedVersion_ = changeVersion_.load();
+}
+
 // Upload ID helper functions
 String getUploadId(const String& dataId, long long timestamp) {
     return dataId + UPLOAD_ID_SEPARATOR + std::to_string(timestamp);
@@ -37,10 +269,16 @@ extern "C" S3UPLOAD_API const char* __stdcall InitializeAwsSDK() {
         // Set log level (can be adjusted as needed)
         g_options.loggingOptions.logLevel = Aws::Utils::Logging::LogLevel::Warn;
 
+        // Feed request counts and latencies into GetUploadMetrics
+        registerUploadMonitoring(g_options);
+
         // Initialize AWS SDK
         Aws::InitAPI(g_options);
         g_isInitialized = true;
 
+        // Start async upload workers (size set by SetMaxConcurrentUploads)
+        UploadWorkerPool::getInstance().start();
+
         static std::string response = create_response(SDK_INIT_SUCCESS, "AWS SDK initialized successfully");
         return response.c_str();
     }
@@ -58,6 +296,28 @@ extern "C" S3UPLOAD_API const char* __stdcall InitializeAwsSDK() {
 extern "C" S3UPLOAD_API const char* __stdcall CleanupAwsSDK() {
     if (g_isInitialized) {
         try {
+            // Stop async upload workers before the SDK goes away; running uploads are cancelled
+            auto remainingJobs = UploadWorkerPool::getInstance().stop();
+            auto& manager = AsyncUploadManager::getInstance();
+            for (const auto& job : remainingJobs) {
+                manager.updateProgress(job.uploadId, UPLOAD_CANCELLED, "AWS SDK cleaned up before upload started");
+            }
+            // No multipart upload runs any more, so its shared part threads are idle
+            stopMultipartPartHelpers();
+
+            // Backlogged uploads are registered only to be cancelled; this also deletes the spill files
+            for (const auto& entry : UploadBacklog::getInstance().takeAll()) {
+                if (manager.admitBackloggedUpload(entry.uploadId, entry.dataId, entry.localFilePath, entry.objectKey,
+                                                  entry.bucketName, entry.bundle, entry.sizeHint,
+                                                  entry.getFileCount(), entry.queuedTime)) {
+                    manager.setTotalSize(entry.uploadId, std::max(0LL, entry.sizeHint));
+                    manager.updateProgress(entry.uploadId, UPLOAD_CANCELLED, "AWS SDK cleaned up before upload started");
+                }
+            }
+
+            // Cached clients hold SDK resources and must go before ShutdownAPI
+            S3ClientCache::getInstance().clear();
+
             Aws::ShutdownAPI(g_options);
             g_isInitialized = false;
             static std::string successResponse = create_response(SDK_CLEAN_SUCCESS, "AWS SDK cleaned up successfully");
@@ -92,11 +352,135 @@ extern "C" S3UPLOAD_API long __stdcall GetS3FileSize(const char* filePath) {
     return static_cast<long>(file.tellg());
 }
 
+// Generate a unique upload ID for the dataId
+String generateUploadId(const String& dataId) {
+    static std::atomic<long long> lastTimestamp(0);
+    long long timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+
+    // Keep IDs strictly increasing so a batch queued in a tight loop never collides
+    long long previous = lastTimestamp.load();
+    while (true) {
+        long long next = timestamp > previous ? timestamp : previous + 1;
+        if (lastTimestamp.compare_exchange_weak(previous, next)) {
+            timestamp = next;
+            break;
+        }
+    }
+    return getUploadId(dataId, timestamp);
+}
+
+unsigned long long hashString64(const String& value) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Walk one directory level and recurse into subdirectories
+static void listFilesInDirectory(const String& directory, const String& relativeDir,
+                                 std::vector<LocalFileEntry>& files) {
+    WIN32_FIND_DATAA findData;
+    HANDLE findHandle = FindFirstFileA((directory + PATH_SEPARATOR + "*").c_str(), &findData);
+    if (findHandle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    do {
+        String name = findData.cFileName;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            continue;
+        }
+
+        String fullPath = directory + PATH_SEPARATOR + name;
+        String relativePath = relativeDir.empty() ? name : relativeDir + "/" + name;
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            listFilesInDirectory(fullPath, relativePath, files);
+        } else {
+            LocalFileEntry entry;
+            entry.fullPath = fullPath;
+            entry.relativePath = relativePath;
+            entry.size = (static_cast<long long>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+            entry.lastWriteTime = (static_cast<long long>(findData.ftLastWriteTime.dwHighDateTime) << 32) |
+                                  findData.ftLastWriteTime.dwLowDateTime;
+            files.push_back(entry);
+        }
+    } while (FindNextFileA(findHandle, &findData));
+
+    FindClose(findHandle);
+}
+
+// Walk a folder recursively and collect all regular files
+bool listFilesRecursive(const String& rootDir, std::vector<LocalFileEntry>& files) {
+    String root = rootDir;
+    while (!root.empty() && (root.back() == '\\' || root.back() == '/')) {
+        root.pop_back();
+    }
+
+    DWORD attributes = GetFileAttributesA(root.c_str());
+    if (root.empty() || attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+
+    listFilesInDirectory(root, "", files);
+    return true;
+}
+
+// Get file size as 64-bit value
+long long getFileSize64(const String& filePath) {
+    long long fileSize = 0;
+    long long lastWriteTime = 0;
+    if (!getFileInfo64(filePath, fileSize, lastWriteTime)) {
+        return -1;
+    }
+    return fileSize;
+}
+
+bool getFileInfo64(const String& filePath, long long& fileSize, long long& lastWriteTime) {
+    WIN32_FILE_ATTRIBUTE_DATA fileData;
+    if (!GetFileAttributesExA(filePath.c_str(), GetFileExInfoStandard, &fileData)) {
+        return false;
+    }
+    if (fileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        return false;
+    }
+    fileSize = (static_cast<long long>(fileData.nFileSizeHigh) << 32) | fileData.nFileSizeLow;
+    lastWriteTime = (static_cast<long long>(fileData.ftLastWriteTime.dwHighDateTime) << 32) |
+                    fileData.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+bool createDirectories(const String& dirPath) {
+    if (dirPath.empty()) {
+        return false;
+    }
+    DWORD attributes = GetFileAttributesA(dirPath.c_str());
+    if (attributes != INVALID_FILE_ATTRIBUTES) {
+        return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    }
+
+    // Create the parent first, then this directory
+    size_t separator = dirPath.find_last_of("\\/");
+    if (separator != String::npos && separator > 0) {
+        String parent = dirPath.substr(0, separator);
+        // Stop at drive roots such as "C:"
+        if (parent.back() != ':') {
+            createDirectories(parent);
+        }
+    }
+    return CreateDirectoryA(dirPath.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
 // S3 client creation helper
-Aws::S3::S3Client createS3Client(const String& accessKey, 
-                                const String& secretKey, 
-                                const String& sessionToken, 
-                                const String& region) {
+std::shared_ptr<Aws::S3::S3Client> createS3Client(const String& accessKey,
+                                                  const String& secretKey,
+                                                  const String& sessionToken,
+                                                  const String& region) {
     // Configure client
     AWS_LOGSTREAM_INFO("S3Upload", "Creating S3 client configuration...");
     Aws::S3::S3ClientConfiguration clientConfig;
@@ -105,6 +489,28 @@ Aws::S3::S3Client createS3Client(const String& accessKey,
     clientConfig.requestTimeoutMs = 30000;
     clientConfig.connectTimeoutMs = 10000;
     // 10 seconds connect timeout
+    // Cached clients are shared by all workers and their multipart parts
+    clientConfig.maxConnections = 64;
+    // Sign with UNSIGNED-PAYLOAD over HTTPS: the SDK no longer reads every body once to
+    // SHA-256 it before sending. Integrity comes from the CRC32C trailer set on each request,
+    // computed in the same pass as the send (hardware-accelerated by aws-checksums).
+    clientConfig.payloadSigningPolicy = Aws::Client::AWSAuthV4Signer::PayloadSigningPolicy::Never;
+    // Every client draws from the one process-wide bandwidth budget
+    clientConfig.writeRateLimiter = BandwidthGovernor::getInstance();
+    // No retries inside the SDK: RetryController retries transient errors with a rewound
+    // body, jittered backoff and the shared retry budget, and reports them per upload
+    clientConfig.retryStrategy = Aws::MakeShared<Aws::Client::DefaultRetryStrategy>("S3Upload", 0);
+    // S3-compatible endpoint (SetS3Endpoint), e.g. the local stand-in of the benchmark suite;
+    // such servers rarely have per-bucket DNS names, so address buckets path-style
+    String endpoint = getS3EndpointOverride();
+    if (!endpoint.empty()) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Using S3 endpoint " << endpoint);
+        clientConfig.endpointOverride = endpoint;
+        if (endpoint.compare(0, 7, "http://") == 0) {
+            clientConfig.scheme = Aws::Http::Scheme::HTTP;
+        }
+        clientConfig.useVirtualAddressing = false;
+    }
 
     // Create AWS credentials (with Session Token)
     AWS_LOGSTREAM_INFO("S3Upload", "Creating AWS credentials...");
@@ -125,5 +531,5 @@ Aws::S3::S3Client createS3Client(const String& accessKey,
     
     // Create S3 client - using credentials provider constructor
     AWS_LOGSTREAM_INFO("S3Upload", "Creating S3 client...");
-    return Aws::S3::S3Client(credentialsProvider, nullptr, clientConfig);
+    return Aws::MakeShared<Aws::S3::S3Client>("S3Upload", credentialsProvider, nullptr, clientConfig);
 }
@@ -16,56 +16,41 @@
 #include <iostream>
 #include <chrono>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <condition_variable>
+// For std::min, std::max
+#include <algorithm>
 // For strlen
 #include <cstring>
 // For std::quoted
 #include <iomanip>
-// For Windows API types
-#include <windows.h>
 #include <regex>
+// Windows API, or its POSIX stand-ins on other platforms
+#include "S3Platform.h"
 // Type aliases for cleaner code
 using String = std::string;
 
-// MinGW compatibility fix: define missing byte order conversion functions
-#ifdef __MINGW32__
-// Define MinGW missing byte order conversion functions
-// Use GCC built-in functions, no need to include intrin.h
-inline unsigned long _byteswap_ulong(unsigned long x) {
-    return __builtin_bswap32(x);
-}
-
-inline unsigned short _byteswap_ushort(unsigned short x) {
-    return __builtin_bswap16(x);
-}
-
-inline unsigned __int64 _byteswap_uint64(unsigned __int64 x) {
-    return __builtin_bswap64(x);
-}
-#endif
-
 // AWS SDK headers
 #include <aws/core/Aws.h>
+#include <aws/core/AmazonWebServiceRequest.h>
 #include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/auth/AWSAuthSigner.h>
+#include <aws/core/client/DefaultRetryStrategy.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/model/PutObjectRequest.h>
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/core/utils/stream/PreallocatedStreamBuf.h>
 
-// DLL export macro definition
-#ifdef S3UPLOAD_EXPORTS
-#define S3UPLOAD_API __declspec(dllexport)
-#else
-#define S3UPLOAD_API __declspec(dllimport)
-#endif
-
 // Async upload retry configuration
-// Maximum number of retry attempts for failed uploads
+// Maximum number of retry attempts for a failed request (see S3RetryPolicy.h)
 static const int MAX_UPLOAD_RETRIES = 3;
 
-// Maximum number of concurrent uploads allowed
+// Maximum number of queued and running uploads (finished uploads do not count)
+// Further submissions wait in the upload backlog (see S3UploadBacklog.h)
 static const size_t MAX_UPLOAD_LIMIT = 100;
 
 // Upload ID separator constant (used in uploadId = dataId + "_" + timestamp)
@@ -81,6 +66,7 @@ namespace ErrorMessage {
     const String INVALID_PARAMETERS = "Invalid parameters: one or more required parameters are null";
     const String SDK_NOT_INITIALIZED = "AWS SDK not initialized. Call InitializeAwsSDK() first";
     const String LOCAL_FILE_NOT_EXIST = "Local file does not exist";
+    const String LOCAL_FOLDER_NOT_EXIST = "Local folder does not exist";
     const String CANNOT_READ_FILE_SIZE = "Cannot read file size";
     const String CANNOT_OPEN_FILE = "Cannot open file for reading";
     const String UPLOAD_EXCEPTION = "Upload failed with exception";
@@ -108,43 +94,870 @@ enum UploadStatus {
     SDK_CLEAN_SUCCESS = 6
 };
 
+// Check whether an upload status is final (succeeded, failed or cancelled)
+inline bool isFinishedStatus(int status) {
+    return status == UPLOAD_SUCCESS || status == UPLOAD_FAILED || status == UPLOAD_CANCELLED;
+}
+
+// Upload error code enumeration - why an upload failed (UPLOAD_ERROR_NONE otherwise)
+enum UploadErrorCode {
+    // No error
+    UPLOAD_ERROR_NONE = 0,
+    // Missing or invalid parameters
+    UPLOAD_ERROR_INVALID_PARAMETERS = 1,
+    // InitializeAwsSDK was not called
+    UPLOAD_ERROR_SDK_NOT_INITIALIZED = 2,
+    // Local file missing, unreadable or changed during the upload
+    UPLOAD_ERROR_LOCAL_FILE = 3,
+    // Credentials rejected or not allowed to write the object
+    UPLOAD_ERROR_ACCESS_DENIED = 4,
+    // Session token expired; new credentials are needed
+    UPLOAD_ERROR_CREDENTIALS_EXPIRED = 5,
+    // Network, timeout, throttling or server errors that outlasted the retries
+    UPLOAD_ERROR_NETWORK = 6,
+    // S3 rejected the request for another reason (missing bucket, bad request)
+    UPLOAD_ERROR_S3_REJECTED = 7,
+    // Exception or other internal error
+    UPLOAD_ERROR_INTERNAL = 8
+};
+
+// Phases of an async upload in the order they happen (see AsyncUploadProgress::getPhaseMs)
+enum UploadPhase {
+    // Waiting in the worker pool queue
+    UPLOAD_PHASE_QUEUE = 0,
+    // Validation, deduplication check and compression
+    UPLOAD_PHASE_PREPARE = 1,
+    // Getting the S3 client from the cache (built on a miss)
+    UPLOAD_PHASE_CLIENT = 2,
+    // Opening the request body (mapping the file, setting up a bundle)
+    UPLOAD_PHASE_OPEN = 3,
+    // Sending requests, including connects, retries and backoff
+    UPLOAD_PHASE_TRANSFER = 4,
+    // Queued until finished
+    UPLOAD_PHASE_TOTAL = 5
+};
+
+// Number of values in UploadPhase
+static const int UPLOAD_PHASE_COUNT = UPLOAD_PHASE_TOTAL + 1;
+
+// User metadata attached to uploaded objects (sent as x-amz-meta-<name>)
+using ObjectMetadata = std::map<String, String>;
+
+// Tar bundle of small folder files uploaded as one object (see S3UploadBundle.h)
+struct UploadBundle;
+
+// Steady clock time point set by one thread while others read it
+// Stored as ticks in an atomic, so a reader sees either the old or the new value
+class AtomicTimePoint {
+private:
+    std::atomic<std::chrono::steady_clock::rep> ticks_;
+
+public:
+    AtomicTimePoint() : ticks_(0) {}
+
+    AtomicTimePoint& operator=(const std::chrono::steady_clock::time_point& timePoint) {
+        ticks_.store(timePoint.time_since_epoch().count());
+        return *this;
+    }
+
+    std::chrono::steady_clock::time_point load() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks_.load()));
+    }
+
+    operator std::chrono::steady_clock::time_point() const { return load(); }
+};
+
+// Text set by one thread while others read it
+// Every value is an immutable string swapped in whole, so a reader never copies a
+// string that is being overwritten
+class AtomicString {
+private:
+    std::shared_ptr<const String> value_;  // nullptr for the empty string
+
+public:
+    AtomicString() {}
+
+    AtomicString& operator=(const String& value) {
+        store(value.empty() ? nullptr : std::shared_ptr<const String>(std::make_shared<String>(value)));
+        return *this;
+    }
+
+    void store(const std::shared_ptr<const String>& value) {
+        std::atomic_store(&value_, value);
+    }
+
+    // Get the current value without copying the text (nullptr when empty)
+    std::shared_ptr<const String> get() const {
+        return std::atomic_load(&value_);
+    }
+
+    String load() const {
+        std::shared_ptr<const String> value = get();
+        return value ? *value : String();
+    }
+
+    operator String() const { return load(); }
+};
+
 // Async upload progress information structure
 // Contains all tracking data for a single upload operation
+// Identity fields (uploadId to localFilePath, bundle) are set before the record is
+// registered and never change; everything else may be read while a worker updates it.
 struct AsyncUploadProgress {
     // Unique identifier for this upload
     String uploadId;
-    // Current status of the upload
-    UploadStatus status;
+    // Data ID the upload belongs to (uploadId = dataId + "_" + timestamp)
+    String dataId;
+    // Current status of the upload (changed by AsyncUploadManager only)
+    std::atomic<UploadStatus> status;
     // Total size of file being uploaded (in bytes)
-    long long totalSize;
+    std::atomic<long long> totalSize;
     // Error message if upload failed
-    String errorMessage;
+    AtomicString errorMessage;
+    // Base64 CRC32C verified by S3 (composite "<crc>-<parts>" for multipart), set on success
+    AtomicString checksumCRC32C;
+    // Bucket the object is uploaded to
+    String bucketName;
     // Local file path
     String s3ObjectKey;
     // Local file path
     String localFilePath;
+    // When upload was queued
+    AtomicTimePoint queuedTime;
     // When upload started
-    std::chrono::steady_clock::time_point startTime;
-    // When upload completed
-    std::chrono::steady_clock::time_point endTime;
-     // Atomic flag for cancellation requests
+    AtomicTimePoint startTime;
+    // When preparation ended and the S3 client was requested
+    AtomicTimePoint clientStartTime;
+    // When the client was ready and the request body was opened
+    AtomicTimePoint openStartTime;
+    // When the first request was sent
+    AtomicTimePoint transferStartTime;
+    // When upload completed (or failed, or was cancelled)
+    AtomicTimePoint endTime;
+    // Set by CancelUpload; checked between steps and polled by requests in flight
     std::atomic<bool> shouldCancel;
+    // Set with shouldCancel when the upload stops for CleanupAwsSDK: a journaled multipart
+    // upload is then left resumable instead of being aborted on S3
+    std::atomic<bool> cancelledForShutdown;
+    // Number of parts for multipart uploads (0 for single PutObject uploads)
+    std::atomic<int> totalParts;
+    // Number of parts already stored on S3
+    std::atomic<int> completedParts;
+    // Bytes handed to the network so far (fed by the SDK data-sent callback)
+    std::atomic<long long> bytesSent;
+    // Throughput sampling state, updated lock-free from the data-sent callback
+    std::atomic<long long> lastSampleTimeMs;
+    std::atomic<long long> lastSampleBytes;
+    // Smoothed throughput in bytes per second
+    std::atomic<double> throughputBytesPerSec;
+    // Time spent waiting on the bandwidth limit (milliseconds)
+    std::atomic<long long> throttledMs;
+    // Size of the local file before compression (0 when sent uncompressed)
+    std::atomic<long long> originalSize;
+    // Skipped because the object already holds this content (see SetUploadDeduplication)
+    std::atomic<bool> deduplicated;
+    // Requests sent again after a transient error (all parts together)
+    std::atomic<int> retryCount;
+    // Time spent backing off before retries (milliseconds, all parts together)
+    std::atomic<long long> backoffMs;
+    // Time spent in the worker pool queue before starting (milliseconds)
+    std::atomic<long long> queueWaitMs;
+    // Time the HTTP client spent resolving and connecting, TLS included (milliseconds, all requests)
+    std::atomic<long long> connectMs;
+    // HTTP requests sent for this upload, retries included
+    std::atomic<int> requestCount;
+    // Why the upload failed (UploadErrorCode), recorded by the request that gave up
+    std::atomic<int> errorCode;
+    // Trace generation (high 32 bits) and id of this upload in that trace (see S3UploadTrace.h)
+    std::atomic<long long> traceKey;
+    // Manager change version of the last update to this record (see GetAsyncUploadStatusDelta)
+    std::atomic<unsigned long long> changeVersion;
+    // Small files sent together as one tar bundle (nullptr for single-file uploads)
+    std::shared_ptr<const UploadBundle> bundle;
 
     // Constructor - initialize with default values
-    AsyncUploadProgress() : status(UPLOAD_PENDING), totalSize(0), shouldCancel(false) {}
+    AsyncUploadProgress() : status(UPLOAD_PENDING), totalSize(0), shouldCancel(false), cancelledForShutdown(false),
+                            totalParts(0), completedParts(0), bytesSent(0),
+                            lastSampleTimeMs(0), lastSampleBytes(0), throughputBytesPerSec(0.0),
+                            throttledMs(0), originalSize(0), deduplicated(false),
+                            retryCount(0), backoffMs(0), queueWaitMs(0), connectMs(0), requestCount(0),
+                            errorCode(UPLOAD_ERROR_NONE), traceKey(0), changeVersion(0) {}
+
+    // Add bytes reported by the SDK and refresh the smoothed throughput
+    // Called from HTTP send callbacks; never takes the AsyncUploadManager mutex
+    void addBytesSent(long long bytes);
+
+    // Remove bytes of a failed attempt that will be sent again
+    void rollbackBytesSent(long long bytes);
+
+    // Get bytes sent, capped at totalSize
+    long long getBytesSent() const;
+
+    // Get smoothed throughput in bytes per second (0 when not sending)
+    double getThroughput() const;
+
+    // Get estimated seconds until this upload finishes, -1 if unknown
+    long long getEtaSeconds() const;
+
+    // Get the duration of a phase in milliseconds, -1 if the upload never reached it
+    // A phase still in progress counts up to now; skipped phases (a deduplicated upload
+    // opens no body) end where the next recorded phase starts
+    long long getPhaseMs(UploadPhase phase) const;
+
+    // Stamp the record with a new manager change version after a lock-free update
+    // (status transitions and size changes are stamped by AsyncUploadManager itself)
+    void markChanged();
+};
+
+// Add a finished upload to the process-wide metrics (see S3UploadMetrics.h)
+void recordUploadMetrics(const AsyncUploadProgress& progress);
+
+// Start backlogged uploads while fewer than MAX_UPLOAD_LIMIT are active (see S3UploadBacklog.h)
+void admitBackloggedUploads();
+
+// Throughput sample window for AsyncUploadProgress (milliseconds)
+static const long long THROUGHPUT_SAMPLE_WINDOW_MS = 1000;
+// Weight of the newest sample in the smoothed throughput
+static const double THROUGHPUT_SMOOTHING_FACTOR = 0.3;
+
+// Feeds the bytes one request sends into an upload's counters and stops the request
+// once the upload is cancelled (the HTTP client polls the continue handler while the
+// body streams, so a cancelled transfer ends within one chunk instead of after the file)
+// Attach to each request; call rollback() when an attempt fails so the
+// bytes are not counted twice when the body is sent again.
+class RequestBytesTracker {
+private:
+    std::shared_ptr<AsyncUploadProgress> progress_;
+    std::shared_ptr<std::atomic<long long>> attemptBytes_;
+
+public:
+    explicit RequestBytesTracker(const std::shared_ptr<AsyncUploadProgress>& progress)
+        : progress_(progress), attemptBytes_(std::make_shared<std::atomic<long long>>(0)) {}
+
+    // Register the data-sent and continue handlers on the request (no-op without progress)
+    void attach(Aws::AmazonWebServiceRequest& request) {
+        if (!progress_) {
+            return;
+        }
+        auto progress = progress_;
+        auto attemptBytes = attemptBytes_;
+        request.SetDataSentEventHandler([progress, attemptBytes](const Aws::Http::HttpRequest*, long long amount) {
+            *attemptBytes += amount;
+            progress->addBytesSent(amount);
+        });
+        request.SetContinueRequestHandler([progress](const Aws::Http::HttpRequest*) {
+            return !progress->shouldCancel.load();
+        });
+    }
+
+    // Forget the bytes of the attempt that just succeeded
+    void commit() {
+        attemptBytes_->store(0);
+    }
+
+    // Remove the bytes of the attempt that just failed
+    void rollback() {
+        long long bytes = attemptBytes_->exchange(0);
+        if (progress_ && bytes > 0) {
+            progress_->rollbackBytesSent(bytes);
+        }
+    }
+};
+
+// Number of values in UploadStatus, used to size per-status counters
+static const int UPLOAD_STATUS_COUNT = SDK_CLEAN_SUCCESS + 1;
+
+// Aggregate counters for all uploads of one dataId
+// Maintained incrementally so status queries do not scan every upload
+struct DataIdSummary {
+    // Number of uploads registered for the dataId
+    size_t uploadCount;
+    // Number of uploads in each UploadStatus
+    size_t statusCounts[UPLOAD_STATUS_COUNT];
+    // Sum of totalSize over all uploads
+    long long totalSize;
+    // Sum of totalSize per UploadStatus
+    long long statusSizes[UPLOAD_STATUS_COUNT];
+    // Error message and code of the first upload that failed
+    String firstErrorMessage;
+    int firstErrorCode;
+    // Bumped on every status transition of an upload in this dataId
+    unsigned long long statusChangeCount;
+    // Uploads still in the submission backlog (see S3UploadBacklog.h)
+    // Counted as pending in the fields above but not listed until they are admitted
+    size_t backlogCount;
+    // Files carried by the backlogged uploads (each bundled file counts)
+    size_t backlogFileCount;
+
+    DataIdSummary() : uploadCount(0), totalSize(0), firstErrorCode(UPLOAD_ERROR_NONE), statusChangeCount(0),
+                      backlogCount(0), backlogFileCount(0) {
+        for (int i = 0; i < UPLOAD_STATUS_COUNT; i++) {
+            statusCounts[i] = 0;
+            statusSizes[i] = 0;
+        }
+    }
+
+    // Get overall status for the dataId
+    // Any failure fails the batch; success needs every upload to succeed
+    int getOverallStatus() const {
+        if (statusCounts[UPLOAD_FAILED] > 0) {
+            return UPLOAD_FAILED;
+        }
+        if (uploadCount > 0 && statusCounts[UPLOAD_SUCCESS] == uploadCount) {
+            return UPLOAD_SUCCESS;
+        }
+        return UPLOAD_UPLOADING;
+    }
+
+    // Check whether every upload has reached a final state (success, failure or cancel)
+    bool isComplete() const {
+        return uploadCount > 0 && statusCounts[UPLOAD_PENDING] == 0 && statusCounts[UPLOAD_UPLOADING] == 0;
+    }
+};
+
+// Live totals of a dataId summed over the uploads of one published view
+// Complements DataIdSummary with values that change without a status transition
+struct DataIdProgressTotals {
+    // Bytes of finished uploads plus bytes already sent by the others
+    long long uploadedSize;
+    // Bytes still to send by pending and running uploads
+    long long remainingSize;
+    // Combined smoothed throughput of running uploads in bytes per second
+    double throughput;
+    // Files of the dataId (each bundled file counts) and how many of them were uploaded
+    int totalFileCount;
+    int uploadedFileCount;
+
+    DataIdProgressTotals() : uploadedSize(0), remainingSize(0), throughput(0),
+                             totalFileCount(0), uploadedFileCount(0) {}
+
+    // Get estimated seconds until the dataId finishes, -1 if unknown
+    long long getEtaSeconds(int overallStatus) const {
+        if (remainingSize == 0 && overallStatus == UPLOAD_SUCCESS) {
+            return 0;
+        }
+        if (throughput > 0) {
+            return static_cast<long long>(static_cast<double>(remainingSize) / throughput + 0.5);
+        }
+        return -1;
+    }
+};
+
+// Binary status snapshot filled by GetAsyncUploadStatusRecords
+// Packed to 4 bytes so VB6 user-defined types map onto it directly: 32-bit fields are
+// Long, 64-bit fields are Currency (VB6 shows value / 10000). Times use the same clock
+// as startTime/endTime in the status JSON (milliseconds, 0 when not reached yet).
+// Bytes reserved for the NUL-terminated upload ID in UploadStatusRecord (longer IDs are truncated)
+static const int UPLOAD_STATUS_ID_SIZE = 64;
+
+#pragma pack(push, 4)
+// Summary of one dataId
+struct UploadStatusSummaryRecord {
+    // sizeof(UploadStatusSummaryRecord), to check the layout the host was built against
+    int structSize;
+    // sizeof(UploadStatusRecord)
+    int recordSize;
+    // Overall status of the dataId (UploadStatus)
+    int status;
+    // Error code of the first failed upload (UploadErrorCode)
+    int errorCode;
+    // Number of uploads of the dataId; may exceed the records written
+    int uploadCount;
+    // Uploads in each status
+    int pendingCount;
+    int uploadingCount;
+    int uploadedCount;
+    int failedCount;
+    int cancelledCount;
+    // Size of all uploads and bytes already uploaded (finished files plus bytes in flight)
+    long long totalSize;
+    long long uploadedSize;
+    // Combined throughput of running uploads in bytes per second
+    long long throughputBytesPerSec;
+    // Estimated seconds until the dataId finishes, -1 if unknown
+    long long etaSeconds;
+};
+
+// Status of one upload
+struct UploadStatusRecord {
+    char uploadId[UPLOAD_STATUS_ID_SIZE];
+    // UploadStatus and UploadErrorCode
+    int status;
+    int errorCode;
+    // Requests sent again after transient errors
+    int retryCount;
+    // Parts of a multipart upload (0 for single PutObject uploads)
+    int totalParts;
+    int completedParts;
+    long long totalSize;
+    long long bytesSent;
+    long long startTimeMs;
+    long long endTimeMs;
+};
+#pragma pack(pop)
+
+// Milliseconds of a progress time point as reported in status snapshots (0 if unset)
+inline long long getStatusTimeMs(const std::chrono::steady_clock::time_point& timePoint) {
+    if (timePoint.time_since_epoch().count() <= 0) {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timePoint.time_since_epoch()).count();
+}
+
+// Upload history retention (see SetUploadHistoryRetention)
+// Finished uploads are compacted into a fixed-capacity history and evicted, oldest first,
+// when it is full or when they finished longer ago than the age limit
+static const size_t DEFAULT_UPLOAD_HISTORY_ENTRIES = 10000;
+static const size_t MAX_UPLOAD_HISTORY_ENTRIES = 1000000;
+static const long long DEFAULT_UPLOAD_HISTORY_AGE_MINUTES = 24 * 60;
+static const long long MAX_UPLOAD_HISTORY_AGE_MINUTES = 30 * 24 * 60;
+
+// Interned strings of compacted upload records, with reference counts
+// Values repeated across records (dataIds, buckets, error messages) are stored once and
+// dropped from the pool when the last record using it is evicted. The strings are shared
+// and immutable, so status snapshots that still hold an evicted record keep them alive.
+// The empty string is never pooled.
+class UploadStringPool {
+private:
+    struct Slot {
+        std::shared_ptr<const String> value;
+        size_t references;
+    };
+
+    // Keyed by the pooled string itself so every value is held once
+    struct KeyHash {
+        size_t operator()(const String* value) const { return std::hash<String>()(*value); }
+    };
+    struct KeyEqual {
+        bool operator()(const String* left, const String* right) const { return *left == *right; }
+    };
+
+    std::unordered_map<const String*, Slot, KeyHash, KeyEqual> index_;
+
+public:
+    // Get the shared copy of value, adding a reference (nullptr for the empty string)
+    std::shared_ptr<const String> acquire(const String& value);
+
+    // Drop a reference taken by acquire
+    void release(const std::shared_ptr<const String>& value);
+
+    // Number of distinct strings held
+    size_t size() const { return index_.size(); }
+};
+
+// Finished upload compacted out of AsyncUploadProgress
+// Keeps what status queries report. Entries never change once pushed, so status readers
+// share them without a lock; empty strings are nullptr.
+struct UploadHistoryEntry {
+    std::shared_ptr<const String> uploadId;
+    std::shared_ptr<const String> dataId;
+    std::shared_ptr<const String> localFilePath;
+    std::shared_ptr<const String> s3ObjectKey;
+    std::shared_ptr<const String> bucketName;
+    std::shared_ptr<const String> errorMessage;
+    std::shared_ptr<const String> checksumCRC32C;
+    // Position in the history ring (see UploadHistory)
+    unsigned long long sequence;
+    int status;
+    int errorCode;
+    int retryCount;
+    int totalParts;
+    int completedParts;
+    int requestCount;
+    bool deduplicated;
+    long long totalSize;
+    long long bytesSent;
+    long long originalSize;
+    long long throttledMs;
+    long long backoffMs;
+    long long queueWaitMs;
+    long long connectMs;
+    // Steady clock ticks of queuedTime, startTime, clientStartTime, openStartTime,
+    // transferStartTime and endTime (0 = not reached)
+    std::chrono::steady_clock::rep timeTicks[UPLOAD_PHASE_TOTAL + 1];
+    unsigned long long changeVersion;
+    std::shared_ptr<const UploadBundle> bundle;
+
+    // Rebuild a progress record for status queries (not registered with the manager)
+    std::shared_ptr<AsyncUploadProgress> restore() const;
+
+    // Fill a binary status record (GetAsyncUploadStatusRecords) without allocating
+    void fillStatusRecord(UploadStatusRecord& record) const;
+};
+
+// Fixed-capacity ring of finished uploads
+// Entries are addressed by a sequence number that grows with every push; an entry stays
+// in the ring until it is evicted with popOldest (or the capacity shrinks past it).
+class UploadHistory {
+private:
+    // Ring slot; entry is nullptr once removed ahead of its eviction
+    struct Slot {
+        std::shared_ptr<const UploadHistoryEntry> entry;
+    };
+
+    std::vector<Slot> slots_;
+    // Sequence numbers of the oldest entry and of the next push; slots_[sequence % capacity]
+    unsigned long long first_;
+    unsigned long long next_;
+    UploadStringPool strings_;
+
+    // Drop the string references of an entry
+    void releaseStrings(const UploadHistoryEntry& entry);
+
+public:
+    explicit UploadHistory(size_t capacity);
+
+    size_t getCapacity() const { return slots_.size(); }
+    size_t size() const { return static_cast<size_t>(next_ - first_); }
+    bool isFull() const { return size() >= slots_.size(); }
+    size_t getStringCount() const { return strings_.size(); }
+
+    // Compact a finished upload into the ring (the caller evicts first when it is full)
+    std::shared_ptr<const UploadHistoryEntry> push(const AsyncUploadProgress& progress);
+
+    // Get the oldest entry, nullptr if it was removed (history must not be empty)
+    const std::shared_ptr<const UploadHistoryEntry>& getOldest() const { return slots_[first_ % slots_.size()].entry; }
+
+    // Evict the oldest entry (history must not be empty)
+    void popOldest();
+
+    // Remove an entry and free its strings ahead of its eviction
+    void remove(const UploadHistoryEntry& entry);
+
+    // Resize the ring, keeping all entries (the caller evicts down to the new capacity first)
+    void setCapacity(size_t capacity);
 };
 
+// One upload of a dataId: live while queued or running, then a history entry
+struct UploadSlot {
+    // nullptr once the upload finished and was compacted
+    std::shared_ptr<AsyncUploadProgress> progress;
+    // The compacted record once finished
+    std::shared_ptr<const UploadHistoryEntry> entry;
+};
+
+// Slots per chunk of an UploadSlotList
+static const size_t UPLOAD_SLOT_CHUNK_SIZE = 256;
+
+// Uploads of a dataId in registration order
+// Slots are stored in chunks that are never modified once built: a change copies the
+// chunk it touches and the chunk table, so copies of the list handed to status readers
+// stay valid, and copying a list for a large batch copies only the chunk table.
+class UploadSlotList {
+private:
+    typedef std::vector<UploadSlot> Chunk;
+
+    std::vector<std::shared_ptr<const Chunk>> chunks_;  // No chunk is empty
+    size_t size_;
+
+    // Locate the first slot matching isSlot
+    template <typename SlotMatch>
+    bool find(SlotMatch isSlot, size_t& chunkIndex, size_t& slotIndex) const {
+        for (chunkIndex = 0; chunkIndex < chunks_.size(); chunkIndex++) {
+            const Chunk& chunk = *chunks_[chunkIndex];
+            for (slotIndex = 0; slotIndex < chunk.size(); slotIndex++) {
+                if (isSlot(chunk[slotIndex])) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+public:
+    UploadSlotList() : size_(0) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // First slot (the list must not be empty)
+    const UploadSlot& front() const { return chunks_.front()->front(); }
+
+    // Call visit for every slot in order until it returns false
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const auto& chunk : chunks_) {
+            for (const auto& slot : *chunk) {
+                if (!visit(slot)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    void push_back(const UploadSlot& slot);
+
+    // Replace the first slot matching isSlot; returns false if there is none
+    template <typename SlotMatch>
+    bool replace(SlotMatch isSlot, const UploadSlot& slot) {
+        size_t chunkIndex = 0;
+        size_t slotIndex = 0;
+        if (!find(isSlot, chunkIndex, slotIndex)) {
+            return false;
+        }
+        auto chunk = std::make_shared<Chunk>(*chunks_[chunkIndex]);
+        (*chunk)[slotIndex] = slot;
+        chunks_[chunkIndex] = chunk;
+        return true;
+    }
+
+    // Remove the first slot matching isSlot; returns false if there is none
+    template <typename SlotMatch>
+    bool erase(SlotMatch isSlot) {
+        size_t chunkIndex = 0;
+        size_t slotIndex = 0;
+        if (!find(isSlot, chunkIndex, slotIndex)) {
+            return false;
+        }
+        if (chunks_[chunkIndex]->size() == 1) {
+            chunks_.erase(chunks_.begin() + chunkIndex);
+        } else {
+            auto chunk = std::make_shared<Chunk>(*chunks_[chunkIndex]);
+            chunk->erase(chunk->begin() + slotIndex);
+            chunks_[chunkIndex] = chunk;
+        }
+        size_--;
+        return true;
+    }
+};
+
+// State of one dataId as published to status readers
+// Never modified once published; AsyncUploadManager publishes a new view after each change
+struct DataIdView {
+    DataIdSummary summary;
+    UploadSlotList uploads;
+};
+
+// Host callback invoked on every upload status transition
+// Runs outside any library lock on the thread that made the change: an upload worker while
+// uploads run, or the host thread inside CancelUpload, CancelUploadsByDataId, CleanupAwsSDK
+// and the submit calls for uploads cancelled or failed before a worker picked them up
+typedef void (__stdcall *UploadStatusCallback)(const char* uploadId, const char* dataId, int status);
+
 // Async upload manager class - thread-safe singleton for managing multiple uploads
 // Provides centralized tracking and status management for concurrent file uploads
+// Changes are made under mutex_. Status queries take no lock: the registry publishes
+// immutable snapshots (uploads_, directory_ and one DataIdView per dataId) that readers
+// load with std::atomic_load, and live records are read through their atomic fields.
+// A snapshot is freed when the last reader holding it lets go.
 class AsyncUploadManager {
 private:
-    mutable std::mutex mutex_;  // Mutex for thread-safe operations
-    std::unordered_map<String, std::shared_ptr<AsyncUploadProgress>> uploads_;  // Map of upload ID to progress info
+    // Where the current view of a dataId is published (replaced with std::atomic_store)
+    struct DataIdViewCell {
+        std::shared_ptr<const DataIdView> view;
+    };
+
+    // All uploads of one dataId in registration order, plus their aggregates
+    struct DataIdGroup {
+        UploadSlotList uploads;
+        DataIdSummary summary;
+        std::shared_ptr<DataIdViewCell> cell;
+        // The published view is out of date (listed in changedGroups_)
+        bool changed;
+
+        DataIdGroup() : cell(std::make_shared<DataIdViewCell>()), changed(false) {}
+    };
+
+    typedef std::unordered_map<String, std::shared_ptr<AsyncUploadProgress>> UploadMap;
+    typedef std::unordered_map<String, std::shared_ptr<DataIdViewCell>> DataIdDirectory;
+
+    // Publishes the views changed while it is alive
+    // Declared right after taking mutex_ in every method that changes dataId groups
+    class ChangeScope {
+    private:
+        AsyncUploadManager& manager_;
+
+    public:
+        explicit ChangeScope(AsyncUploadManager& manager) : manager_(manager) {
+            manager_.publishing_ = true;
+        }
+
+        ~ChangeScope() {
+            manager_.publishChangesLocked();
+            manager_.publishing_ = false;
+        }
+    };
+
+    mutable std::mutex mutex_;  // Serializes changes; status queries do not take it
+    std::shared_ptr<const UploadMap> uploads_;  // Upload ID to progress of queued and running uploads, replaced on every change
+    UploadHistory history_;  // Finished uploads, compacted (see SetUploadHistoryRetention)
+    long long historyMaxAgeMinutes_;  // Finished uploads older than this are evicted from history_
+    std::unordered_map<String, DataIdGroup> dataIdGroups_;  // Secondary index: dataId to its uploads
+    std::shared_ptr<const DataIdDirectory> directory_;  // dataId to its published view, replaced when dataIds come and go
+    bool directoryChanged_;  // A group was added or dropped since directory_ was published
+    std::vector<String> changedGroups_;  // dataIds whose view is out of date
+    std::atomic<size_t> statusCounts_[UPLOAD_STATUS_COUNT];  // Number of uploads in each status across all dataIds
+    std::atomic<size_t> historySize_;  // Size of history_ as of the last publish
+    std::condition_variable statusChanged_;  // Signalled on every status transition and removal
+    std::unordered_map<String, HANDLE> completionEvents_;  // dataId to host event set when its batch completes
+    std::atomic<UploadStatusCallback> statusCallback_;  // Optional host callback for status transitions
+    std::atomic<unsigned long long> changeVersion_;  // Bumped on every change to any upload record
+    std::atomic<bool> publishing_;  // A ChangeScope is open: views may lag changeVersion_
+    std::atomic<unsigned long long> publishedVersion_;  // changeVersion_ when the last ChangeScope closed
+
+    // Publish the views of changed groups, then the directory (mutex_ must be held)
+    void publishChangesLocked();
+
+    // Get the group of a dataId, creating it if needed (mutex_ must be held)
+    DataIdGroup& getGroupLocked(const String& dataId) {
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end()) {
+            groupIt = dataIdGroups_.emplace(dataId, DataIdGroup()).first;
+            directoryChanged_ = true;
+        }
+        markChangedLocked(groupIt->first, groupIt->second);
+        return groupIt->second;
+    }
+
+    // Note that a group's view is out of date (mutex_ must be held)
+    void markChangedLocked(const String& dataId, DataIdGroup& group) {
+        if (!group.changed) {
+            group.changed = true;
+            changedGroups_.push_back(dataId);
+        }
+    }
+
+    // Drop a group and take it out of the directory (mutex_ must be held)
+    void dropGroupLocked(std::unordered_map<String, DataIdGroup>::iterator groupIt) {
+        dataIdGroups_.erase(groupIt);
+        directoryChanged_ = true;
+    }
+
+    // Replace uploads_ with a copy changed by change (mutex_ must be held)
+    template <typename Change>
+    void changeUploadsLocked(Change change) {
+        auto uploads = std::make_shared<UploadMap>(*uploads_);
+        change(*uploads);
+        std::atomic_store(&uploads_, std::shared_ptr<const UploadMap>(uploads));
+    }
+
+    // Get a queued or running upload while holding mutex_ (nullptr if not found)
+    std::shared_ptr<AsyncUploadProgress> findUploadLocked(const String& uploadId) const {
+        auto it = uploads_->find(uploadId);
+        return it != uploads_->end() ? it->second : nullptr;
+    }
+
+    // Get the published view of a dataId without locking (nullptr if the dataId is unknown)
+    std::shared_ptr<const DataIdView> loadView(const String& dataId) const {
+        std::shared_ptr<const DataIdDirectory> directory = std::atomic_load(&directory_);
+        auto it = directory->find(dataId);
+        return it != directory->end() ? std::atomic_load(&it->second->view) : nullptr;
+    }
+
+    // Sum the live totals of a published view
+    // Live uploads are read as they are now, so the totals may be a moment ahead of the view
+    static void sumProgress(const DataIdView& view, DataIdProgressTotals& totals);
+
+    // Move one upload between status/size buckets of its group (mutex_ must be held)
+    void applyStatusChangeLocked(AsyncUploadProgress& progress, UploadStatus newStatus) {
+        UploadStatus oldStatus = progress.status;
+        auto groupIt = dataIdGroups_.find(progress.dataId);
+        if (groupIt != dataIdGroups_.end()) {
+            DataIdSummary& summary = groupIt->second.summary;
+            summary.statusCounts[oldStatus]--;
+            summary.statusSizes[oldStatus] -= progress.totalSize;
+            summary.statusCounts[newStatus]++;
+            summary.statusSizes[newStatus] += progress.totalSize;
+            summary.statusChangeCount++;
+            markChangedLocked(groupIt->first, groupIt->second);
+        }
+        statusCounts_[oldStatus]--;
+        statusCounts_[newStatus]++;
+        progress.status = newStatus;
+        progress.changeVersion = ++changeVersion_;
+    }
+
+    // Remove the slot matching isSlot from a group and the global counters (mutex_ must be held)
+    // Returns true if the group became empty and was dropped
+    template <typename SlotMatch>
+    bool unlinkSlotLocked(const String& dataId, int status, long long totalSize, SlotMatch isSlot) {
+        statusCounts_[status]--;
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end()) {
+            return false;
+        }
+        DataIdGroup& group = groupIt->second;
+        group.uploads.erase(isSlot);
+        group.summary.uploadCount--;
+        group.summary.statusCounts[status]--;
+        group.summary.statusSizes[status] -= totalSize;
+        group.summary.totalSize -= totalSize;
+        if (group.uploads.empty() && group.summary.backlogCount == 0) {
+            dropGroupLocked(groupIt);
+            return true;
+        }
+        markChangedLocked(groupIt->first, group);
+        return false;
+    }
+
+    // Remove one live upload from its group and the global counters (mutex_ must be held)
+    void unlinkFromGroupLocked(const AsyncUploadProgress& progress) {
+        const AsyncUploadProgress* record = &progress;
+        unlinkSlotLocked(progress.dataId, progress.status, progress.totalSize, [record](const UploadSlot& slot) {
+            return slot.progress.get() == record;
+        });
+    }
+
+    // Move a finished upload from uploads_ into history_ (mutex_ must be held)
+    // Its group keeps the slot, so dataId counts and listings still include it
+    void compactLocked(const std::shared_ptr<AsyncUploadProgress>& progress);
+
+    // Evict history entries beyond maxEntries or past the age limit, oldest first (mutex_ must be held)
+    void evictHistoryLocked(size_t maxEntries);
+
+    // Get the progress of a slot, rebuilding finished uploads from their history entry
+    static std::shared_ptr<AsyncUploadProgress> getSlotProgress(const UploadSlot& slot) {
+        return slot.progress ? slot.progress : slot.entry->restore();
+    }
+
+    // Register a pending upload in uploads_ and its group (mutex_ must be held)
+    std::shared_ptr<AsyncUploadProgress> addUploadLocked(const String& uploadId, const String& dataId,
+                                                         const String& localFilePath, const String& s3ObjectKey,
+                                                         const String& bucketName,
+                                                         const std::shared_ptr<const UploadBundle>& bundle) {
+        evictHistoryLocked(history_.getCapacity());
+        auto existing = findUploadLocked(uploadId);
+        if (existing) {
+            unlinkFromGroupLocked(*existing);
+        }
+
+        auto progress = std::make_shared<AsyncUploadProgress>();
+        progress->uploadId = uploadId;
+        progress->dataId = dataId;
+        progress->localFilePath = localFilePath;
+        progress->s3ObjectKey = s3ObjectKey;
+        progress->bucketName = bucketName;
+        progress->bundle = bundle;
+        progress->queuedTime = std::chrono::steady_clock::now();
+        progress->status = UPLOAD_PENDING;  // Set to pending initially
+        progress->changeVersion = ++changeVersion_;
+        changeUploadsLocked([&](UploadMap& uploads) {
+            uploads[uploadId] = progress;
+        });
+
+        DataIdGroup& group = getGroupLocked(dataId);
+        UploadSlot slot;
+        slot.progress = progress;
+        group.uploads.push_back(slot);
+        group.summary.uploadCount++;
+        group.summary.statusCounts[UPLOAD_PENDING]++;
+        statusCounts_[UPLOAD_PENDING]++;
+        return progress;
+    }
 
 public:
     // Constructor
-    AsyncUploadManager() = default;
-    
+    AsyncUploadManager() : uploads_(std::make_shared<UploadMap>()),
+                           history_(DEFAULT_UPLOAD_HISTORY_ENTRIES),
+                           historyMaxAgeMinutes_(DEFAULT_UPLOAD_HISTORY_AGE_MINUTES),
+                           directory_(std::make_shared<DataIdDirectory>()), directoryChanged_(false),
+                           historySize_(0), statusCallback_(nullptr), changeVersion_(0),
+                           publishing_(false), publishedVersion_(0) {
+        for (int i = 0; i < UPLOAD_STATUS_COUNT; i++) {
+            statusCounts_[i] = 0;
+        }
+    }
+
     // Destructor
     ~AsyncUploadManager() = default;
 
@@ -156,89 +969,511 @@ public:
 
     // Add a new upload to tracking system
     // Returns the upload ID for reference
-    String addUpload(const String& uploadId, const String& localFilePath, const String& s3ObjectKey) {
+    String addUpload(const String& uploadId, const String& dataId,
+                     const String& localFilePath, const String& s3ObjectKey,
+                     const String& bucketName = "",
+                     const std::shared_ptr<const UploadBundle>& bundle = nullptr) {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto progress = std::make_shared<AsyncUploadProgress>();
-        progress->uploadId = uploadId;
-        progress->localFilePath = localFilePath;
-        progress->s3ObjectKey = s3ObjectKey;
-        progress->status = UPLOAD_PENDING;  // Set to pending initially
-        uploads_[uploadId] = progress;
+        ChangeScope change(*this);
+        addUploadLocked(uploadId, dataId, localFilePath, s3ObjectKey, bucketName, bundle);
         return uploadId;
     }
 
-    // Get upload progress information by ID
-    // Returns shared_ptr to progress info or nullptr if not found
-    std::shared_ptr<AsyncUploadProgress> getUpload(const String& uploadId) {
+    // Count an upload waiting in the submission backlog as pending in its dataId
+    // totalSize is the size known at submission (-1 if unknown)
+    void addBackloggedUpload(const String& dataId, long long totalSize, size_t fileCount) {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = uploads_.find(uploadId);
-        return it != uploads_.end() ? it->second : nullptr;
+        ChangeScope change(*this);
+        DataIdSummary& summary = getGroupLocked(dataId).summary;
+        long long size = totalSize > 0 ? totalSize : 0;
+        summary.uploadCount++;
+        summary.backlogCount++;
+        summary.backlogFileCount += fileCount;
+        summary.statusCounts[UPLOAD_PENDING]++;
+        summary.statusSizes[UPLOAD_PENDING] += size;
+        summary.totalSize += size;
+        changeVersion_++;
     }
 
-    // Get upload progress information by dataId
-    // Returns shared_ptr to progress info or nullptr if not found
-    std::shared_ptr<AsyncUploadProgress> getUploadByDataId(const String& dataId) {
+    // Register a backlogged upload now that there is room for it
+    // Replaces the backlog count added by addBackloggedUpload with a pending upload.
+    // Returns nullptr if the dataId was cleaned up while the upload waited.
+    std::shared_ptr<AsyncUploadProgress> admitBackloggedUpload(const String& uploadId, const String& dataId,
+                                                               const String& localFilePath, const String& s3ObjectKey,
+                                                               const String& bucketName,
+                                                               const std::shared_ptr<const UploadBundle>& bundle,
+                                                               long long totalSize, size_t fileCount,
+                                                               std::chrono::steady_clock::time_point queuedTime) {
         std::lock_guard<std::mutex> lock(mutex_);
-        String prefix = getUploadIdPrefixByDataId(dataId);
-        for (auto& pair : uploads_) {
-            if (pair.first.find(prefix) == 0) {
-                return pair.second;
+        ChangeScope change(*this);
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end() || groupIt->second.summary.backlogCount == 0) {
+            return nullptr;
+        }
+        DataIdSummary& summary = groupIt->second.summary;
+        long long size = totalSize > 0 ? totalSize : 0;
+        summary.uploadCount--;
+        summary.backlogCount--;
+        summary.backlogFileCount -= std::min(fileCount, summary.backlogFileCount);
+        summary.statusCounts[UPLOAD_PENDING]--;
+        summary.statusSizes[UPLOAD_PENDING] -= size;
+        summary.totalSize -= size;
+        auto progress = addUploadLocked(uploadId, dataId, localFilePath, s3ObjectKey, bucketName, bundle);
+        progress->queuedTime = queuedTime;
+        return progress;
+    }
+
+    // Finish backlogged uploads that will never be started: UPLOAD_FAILED when their spill
+    // file was lost (error is reported as the dataId's first error), UPLOAD_CANCELLED when
+    // the host cancelled them. They stay in the dataId counts without a record of their own.
+    void finishBackloggedUploads(const String& dataId, size_t count, long long totalSize, size_t fileCount,
+                                 UploadStatus status, const String& error = "") {
+        HANDLE completionEvent = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ChangeScope change(*this);
+            auto groupIt = dataIdGroups_.find(dataId);
+            if (groupIt == dataIdGroups_.end()) {
+                return;
+            }
+            DataIdSummary& summary = groupIt->second.summary;
+            count = std::min(count, summary.backlogCount);
+            if (count == 0) {
+                return;
             }
+            summary.backlogCount -= count;
+            summary.backlogFileCount -= std::min(fileCount, summary.backlogFileCount);
+            summary.statusCounts[UPLOAD_PENDING] -= count;
+            summary.statusCounts[status] += count;
+            summary.statusSizes[UPLOAD_PENDING] -= totalSize;
+            summary.statusSizes[status] += totalSize;
+            summary.statusChangeCount++;
+            if (status == UPLOAD_FAILED && summary.firstErrorMessage.empty()) {
+                summary.firstErrorMessage = error;
+                summary.firstErrorCode = UPLOAD_ERROR_INTERNAL;
+            }
+            markChangedLocked(groupIt->first, groupIt->second);
+            changeVersion_++;
+            if (summary.isComplete()) {
+                auto eventIt = completionEvents_.find(dataId);
+                if (eventIt != completionEvents_.end()) {
+                    completionEvent = eventIt->second;
+                }
+            }
+        }
+        statusChanged_.notify_all();
+        if (completionEvent) {
+            SetEvent(completionEvent);
         }
-        return nullptr;
     }
 
-    // Get all uploads that start with the given dataId
-    // Returns a vector of all matching upload progress info
-    std::vector<std::shared_ptr<AsyncUploadProgress>> getAllUploadsByDataId(const String& dataId) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // Get upload progress information of a queued or running upload by ID
+    // Returns shared_ptr to progress info or nullptr if not found (or already finished)
+    std::shared_ptr<AsyncUploadProgress> getUpload(const String& uploadId) const {
+        std::shared_ptr<const UploadMap> uploads = std::atomic_load(&uploads_);
+        auto it = uploads->find(uploadId);
+        return it != uploads->end() ? it->second : nullptr;
+    }
+
+    // Get upload progress information by dataId
+    // Returns the first upload registered for the dataId or nullptr if not found
+    std::shared_ptr<AsyncUploadProgress> getUploadByDataId(const String& dataId) const {
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view || view->uploads.empty()) {
+            return nullptr;
+        }
+        return getSlotProgress(view->uploads.front());
+    }
+
+    // Get all uploads registered for the given dataId
+    // Returns a vector of all matching upload progress info in registration order
+    // (finished uploads are copies rebuilt from the history)
+    std::vector<std::shared_ptr<AsyncUploadProgress>> getAllUploadsByDataId(const String& dataId) const {
         std::vector<std::shared_ptr<AsyncUploadProgress>> result;
-        String prefix = getUploadIdPrefixByDataId(dataId);
-        for (auto& pair : uploads_) {
-            if (pair.first.find(prefix) == 0) {
-                result.push_back(pair.second);
-            }
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view) {
+            return result;
         }
+        result.reserve(view->uploads.size());
+        view->uploads.forEach([&result](const UploadSlot& slot) {
+            result.push_back(getSlotProgress(slot));
+            return true;
+        });
         return result;
     }
 
+    // Get the queued and running uploads of a dataId in registration order
+    std::vector<std::shared_ptr<AsyncUploadProgress>> getActiveUploadsByDataId(const String& dataId) const {
+        std::vector<std::shared_ptr<AsyncUploadProgress>> result;
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view) {
+            return result;
+        }
+        view->uploads.forEach([&result](const UploadSlot& slot) {
+            if (slot.progress && !isFinishedStatus(slot.progress->status)) {
+                result.push_back(slot.progress);
+            }
+            return true;
+        });
+        return result;
+    }
+
+    // Find a queued or running upload of localFilePath to bucketName/objectKey in the dataId
+    // Returns nullptr if there is none
+    std::shared_ptr<AsyncUploadProgress> findInFlightUpload(const String& dataId, const String& bucketName,
+                                                            const String& objectKey, const String& localFilePath) const {
+        std::shared_ptr<AsyncUploadProgress> found;
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view) {
+            return found;
+        }
+        view->uploads.forEach([&](const UploadSlot& slot) {
+            const auto& progress = slot.progress;
+            if (progress && (progress->status == UPLOAD_PENDING || progress->status == UPLOAD_UPLOADING) &&
+                progress->s3ObjectKey == objectKey && progress->localFilePath == localFilePath &&
+                progress->bucketName == bucketName) {
+                found = progress;
+                return false;
+            }
+            return true;
+        });
+        return found;
+    }
+
+    // Get aggregate counters for the given dataId
+    // Returns false if no uploads are registered for the dataId
+    bool getDataIdSummary(const String& dataId, DataIdSummary& summary) const {
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view) {
+            return false;
+        }
+        summary = view->summary;
+        return true;
+    }
+
+    // Get a new change version for a record updated outside the lock
+    unsigned long long nextChangeVersion() {
+        return ++changeVersion_;
+    }
+
+    // Get aggregates of a dataId and its uploads changed after sinceVersion from one view
+    // sinceVersion 0 returns every upload. version receives the change version the snapshot
+    // is current to; passing it as the next sinceVersion returns only later changes.
+    // Returns false if no uploads are registered for the dataId
+    bool getDataIdChanges(const String& dataId, unsigned long long sinceVersion,
+                          DataIdSummary& summary, DataIdProgressTotals& totals,
+                          std::vector<std::shared_ptr<AsyncUploadProgress>>& changedUploads,
+                          unsigned long long& version) const {
+        // Read the version before the view: a lock-free update racing with the scan
+        // stamps a later version, so the next query reports it again rather than missing it.
+        // While a locked change is being published the view may not hold the versions it
+        // stamped yet, so the version the last publish covered is used instead.
+        version = changeVersion_.load();
+        if (publishing_.load()) {
+            version = publishedVersion_.load();
+        }
+        std::shared_ptr<const DataIdView> view = loadView(dataId);
+        if (!view) {
+            return false;
+        }
+
+        summary = view->summary;
+        sumProgress(*view, totals);
+        changedUploads.clear();
+        view->uploads.forEach([&](const UploadSlot& slot) {
+            if (slot.progress) {
+                if (slot.progress->changeVersion.load() > sinceVersion) {
+                    changedUploads.push_back(slot.progress);
+                }
+            } else if (slot.entry->changeVersion > sinceVersion) {
+                changedUploads.push_back(slot.entry->restore());
+            }
+            return true;
+        });
+        return true;
+    }
+
+    // Fill a binary status snapshot of a dataId (GetAsyncUploadStatusRecords)
+    // Writes at most maxRecords records in registration order and never allocates once
+    // the per-thread lookup key has grown, so hosts can poll it at a high rate.
+    // Returns the number of records written, -1 if the dataId is unknown
+    int fillStatusRecords(const char* dataId, UploadStatusSummaryRecord& summaryRecord,
+                          UploadStatusRecord* records, int maxRecords) const {
+        static thread_local String lookupKey;
+        lookupKey.assign(dataId);
+
+        std::shared_ptr<const DataIdView> view = loadView(lookupKey);
+        if (!view) {
+            return -1;
+        }
+        const DataIdSummary& summary = view->summary;
+
+        // Step 1: Per-upload records in registration order
+        int written = 0;
+        view->uploads.forEach([&](const UploadSlot& slot) {
+            if (written >= maxRecords) {
+                return false;
+            }
+
+            const auto& progress = slot.progress;
+            if (!progress) {
+                slot.entry->fillStatusRecord(records[written++]);
+                return true;
+            }
+            UploadStatusRecord& record = records[written++];
+            size_t idLength = std::min(progress->uploadId.size(), static_cast<size_t>(UPLOAD_STATUS_ID_SIZE - 1));
+            memcpy(record.uploadId, progress->uploadId.data(), idLength);
+            memset(record.uploadId + idLength, 0, UPLOAD_STATUS_ID_SIZE - idLength);
+            record.status = progress->status.load();
+            record.errorCode = progress->errorCode.load();
+            record.retryCount = progress->retryCount.load();
+            record.totalParts = progress->totalParts.load();
+            record.completedParts = progress->completedParts.load();
+            record.totalSize = progress->totalSize.load();
+            record.bytesSent = progress->getBytesSent();
+            record.startTimeMs = getStatusTimeMs(progress->startTime);
+            record.endTimeMs = getStatusTimeMs(progress->endTime);
+            return true;
+        });
+
+        // Step 2: Summary from the dataId aggregates and the live totals
+        DataIdProgressTotals totals;
+        sumProgress(*view, totals);
+        int overallStatus = summary.getOverallStatus();
+        summaryRecord.structSize = sizeof(UploadStatusSummaryRecord);
+        summaryRecord.recordSize = sizeof(UploadStatusRecord);
+        summaryRecord.status = overallStatus;
+        summaryRecord.errorCode = summary.firstErrorCode;
+        summaryRecord.uploadCount = static_cast<int>(summary.uploadCount);
+        summaryRecord.pendingCount = static_cast<int>(summary.statusCounts[UPLOAD_PENDING]);
+        summaryRecord.uploadingCount = static_cast<int>(summary.statusCounts[UPLOAD_UPLOADING]);
+        summaryRecord.uploadedCount = static_cast<int>(summary.statusCounts[UPLOAD_SUCCESS]);
+        summaryRecord.failedCount = static_cast<int>(summary.statusCounts[UPLOAD_FAILED]);
+        summaryRecord.cancelledCount = static_cast<int>(summary.statusCounts[UPLOAD_CANCELLED]);
+        summaryRecord.totalSize = summary.totalSize;
+        summaryRecord.uploadedSize = totals.uploadedSize;
+        summaryRecord.throughputBytesPerSec = static_cast<long long>(totals.throughput);
+        summaryRecord.etaSeconds = totals.getEtaSeconds(overallStatus);
+        return written;
+    }
+
     // Remove upload from tracking system (cleanup)
     void removeUpload(const String& uploadId) {
         std::lock_guard<std::mutex> lock(mutex_);
-        uploads_.erase(uploadId);
+        ChangeScope change(*this);
+        auto progress = findUploadLocked(uploadId);
+        if (!progress) {
+            return;
+        }
+        unlinkFromGroupLocked(*progress);
+        changeUploadsLocked([&uploadId](UploadMap& uploads) {
+            uploads.erase(uploadId);
+        });
+        statusChanged_.notify_all();
+    }
+
+    // Remove all uploads of a dataId from tracking system
+    // Returns the number of uploads removed
+    size_t removeUploadsByDataId(const String& dataId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ChangeScope change(*this);
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end()) {
+            return 0;
+        }
+        const UploadSlotList& slots = groupIt->second.uploads;
+        size_t removedCount = slots.size() + groupIt->second.summary.backlogCount;
+        changeUploadsLocked([&](UploadMap& uploads) {
+            slots.forEach([&](const UploadSlot& slot) {
+                if (slot.progress) {
+                    statusCounts_[slot.progress->status]--;
+                    uploads.erase(slot.progress->uploadId);
+                } else {
+                    statusCounts_[slot.entry->status]--;
+                    history_.remove(*slot.entry);
+                }
+                return true;
+            });
+        });
+        dropGroupLocked(groupIt);
+        completionEvents_.erase(dataId);
+        statusChanged_.notify_all();
+        return removedCount;
     }
 
     // Update upload status and error message
-    // Thread-safe status updates for progress tracking
+    // Thread-safe status updates for progress tracking; wakes waiters and notifies the host
+    // A failed status keeps the error code recorded by the request that gave up unless
+    // errorCode names one; without either it is UPLOAD_ERROR_INTERNAL
     void updateProgress(const String& uploadId, UploadStatus status,
-                       const String& error = "") {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = uploads_.find(uploadId);
-        if (it != uploads_.end()) {
-            it->second->status = status;
+                       const String& error = "", UploadErrorCode errorCode = UPLOAD_ERROR_NONE) {
+        String dataId;
+        HANDLE completionEvent = nullptr;
+        std::shared_ptr<AsyncUploadProgress> finishedUpload;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ChangeScope change(*this);
+            auto record = findUploadLocked(uploadId);
+            if (!record) {
+                return;
+            }
+            AsyncUploadProgress& progress = *record;
+            // The first terminal status ends the upload's timeline
+            if (isFinishedStatus(status) && !isFinishedStatus(progress.status)) {
+                if (progress.endTime.load().time_since_epoch().count() == 0) {
+                    progress.endTime = std::chrono::steady_clock::now();
+                }
+                finishedUpload = record;
+            }
+            // Error details are set before the status so a reader that sees the new
+            // status also sees why it failed
             if (!error.empty()) {
-                it->second->errorMessage = error;
+                progress.errorMessage = error;
+            }
+            if (status == UPLOAD_FAILED) {
+                if (errorCode != UPLOAD_ERROR_NONE) {
+                    progress.errorCode = errorCode;
+                } else if (progress.errorCode == UPLOAD_ERROR_NONE) {
+                    progress.errorCode = UPLOAD_ERROR_INTERNAL;
+                }
+            }
+            applyStatusChangeLocked(progress, status);
+            dataId = progress.dataId;
+            auto groupIt = dataIdGroups_.find(dataId);
+            if (groupIt != dataIdGroups_.end()) {
+                DataIdSummary& summary = groupIt->second.summary;
+                if (status == UPLOAD_FAILED && summary.firstErrorMessage.empty()) {
+                    summary.firstErrorMessage = progress.errorMessage.load();
+                    summary.firstErrorCode = progress.errorCode.load();
+                }
+                if (summary.isComplete()) {
+                    auto eventIt = completionEvents_.find(dataId);
+                    if (eventIt != completionEvents_.end()) {
+                        completionEvent = eventIt->second;
+                    }
+                }
+            }
+            if (finishedUpload) {
+                compactLocked(finishedUpload);
+            }
+        }
+
+        // Notify outside the lock so host code can call back into the library
+        if (finishedUpload) {
+            recordUploadMetrics(*finishedUpload);
+            admitBackloggedUploads();
+        }
+        statusChanged_.notify_all();
+        if (completionEvent) {
+            SetEvent(completionEvent);
+        }
+        UploadStatusCallback callback = statusCallback_.load();
+        if (callback) {
+            callback(uploadId.c_str(), dataId.c_str(), status);
+        }
+    }
+
+    // Block until the dataId batch is complete, any of its uploads changes status,
+    // or timeoutMs expires. Returns the overall status, or -1 if the dataId is unknown
+    int waitForDataId(const String& dataId, long timeoutMs) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end()) {
+            return -1;
+        }
+        if (groupIt->second.summary.isComplete()) {
+            return groupIt->second.summary.getOverallStatus();
+        }
+
+        unsigned long long seenChangeCount = groupIt->second.summary.statusChangeCount;
+        statusChanged_.wait_for(lock, std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0), [&] {
+            auto it = dataIdGroups_.find(dataId);
+            return it == dataIdGroups_.end() || it->second.summary.statusChangeCount != seenChangeCount;
+        });
+
+        groupIt = dataIdGroups_.find(dataId);
+        if (groupIt == dataIdGroups_.end()) {
+            return -1;
+        }
+        return groupIt->second.summary.getOverallStatus();
+    }
+
+    // Register a host event set (SetEvent) when the dataId batch completes
+    // Passing nullptr removes the registration; the event is set right away if already complete
+    void setCompletionEvent(const String& dataId, HANDLE completionEvent) {
+        bool alreadyComplete = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!completionEvent) {
+                completionEvents_.erase(dataId);
+                return;
             }
+            completionEvents_[dataId] = completionEvent;
+            auto groupIt = dataIdGroups_.find(dataId);
+            alreadyComplete = groupIt != dataIdGroups_.end() && groupIt->second.summary.isComplete();
+        }
+        if (alreadyComplete) {
+            SetEvent(completionEvent);
         }
     }
 
+    // Register the host status callback (nullptr to remove)
+    void setStatusCallback(UploadStatusCallback callback) {
+        statusCallback_ = callback;
+    }
+
+    // Set total size of an upload and keep dataId byte totals in step
+    void setTotalSize(const String& uploadId, long long totalSize) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ChangeScope change(*this);
+        auto record = findUploadLocked(uploadId);
+        if (!record) {
+            return;
+        }
+        AsyncUploadProgress& progress = *record;
+        long long previousSize = progress.totalSize;
+        auto groupIt = dataIdGroups_.find(progress.dataId);
+        if (groupIt != dataIdGroups_.end()) {
+            DataIdSummary& summary = groupIt->second.summary;
+            summary.totalSize += totalSize - previousSize;
+            summary.statusSizes[progress.status] += totalSize - previousSize;
+            markChangedLocked(groupIt->first, groupIt->second);
+        }
+        progress.totalSize = totalSize;
+        progress.changeVersion = ++changeVersion_;
+    }
+
+    // Change history retention; maxEntries <= 0 or maxAgeMinutes <= 0 keeps that setting
+    // Entries beyond the new limits are evicted right away
+    void setHistoryRetention(long long maxEntries, long long maxAgeMinutes);
+
+    // Get the history capacity and age limit in effect
+    void getHistoryRetention(size_t& maxEntries, long long& maxAgeMinutes) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxEntries = history_.getCapacity();
+        maxAgeMinutes = historyMaxAgeMinutes_;
+    }
+
 public:
-    // Get total number of uploads
+    // Get number of uploads queued or running (finished uploads are kept in the history)
+    // This is the number MAX_UPLOAD_LIMIT applies to
     size_t getTotalUploads() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return uploads_.size();
+        return std::atomic_load(&uploads_)->size();
     }
-    
+
+    // Get number of finished uploads kept in the history
+    size_t getHistorySize() const {
+        return historySize_.load();
+    }
+
     // Get number of pending uploads
     size_t getPendingUploads() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        size_t count = 0;
-        for (const auto& pair : uploads_) {
-            if (pair.second->status == UPLOAD_PENDING) {
-                count++;
-            }
-        }
-        return count;
+        return statusCounts_[UPLOAD_PENDING].load();
+    }
+
+    // Check whether any upload is registered for the dataId
+    bool hasDataId(const String& dataId) const {
+        return loadView(dataId) != nullptr;
     }
 };
 
@@ -249,9 +1484,50 @@ extern Aws::SDKOptions g_options;
 // Common utility functions
 String create_response(int code, const String& message);
 
+// Escape text for use inside a JSON string literal
+// Quotes, backslashes (Windows paths) and control characters are escaped; other bytes pass through
+String escapeJson(const String& value);
+
 // Upload ID helper functions
 String getUploadId(const String& dataId, long long timestamp);
 
+// Generate a unique upload ID for the dataId
+// Uses the current time in microseconds, bumped when several uploads are queued within the same microsecond
+String generateUploadId(const String& dataId);
+
+// 64-bit FNV-1a hash, stable across builds and processes (unlike std::hash)
+// Used to derive file names for journals and staged files
+unsigned long long hashString64(const String& value);
+
+// One regular file found by listFilesRecursive
+struct LocalFileEntry {
+    // Full local path
+    String fullPath;
+    // Path relative to the walked folder, '/' separated (used for object keys)
+    String relativePath;
+    // File size in bytes
+    long long size;
+    // Last write time (FILETIME as 64-bit value)
+    long long lastWriteTime;
+};
+
+// Walk a folder recursively and collect all regular files
+// Reparse points (junctions, symlinks) are skipped to avoid loops
+// Returns false if the folder cannot be opened
+bool listFilesRecursive(const String& rootDir, std::vector<LocalFileEntry>& files);
+
+// Get local file size as 64-bit value (GetS3FileSize is limited to 2 GB by VB6 Long)
+// Returns -1 if the file cannot be read
+long long getFileSize64(const String& filePath);
+
+// Get local file size and last write time (FILETIME as 64-bit value)
+// Returns false if the path does not exist or is a directory
+bool getFileInfo64(const String& filePath, long long& fileSize, long long& lastWriteTime);
+
+// Create a directory and any missing parent directories
+// Returns true if the directory exists afterwards
+bool createDirectories(const String& dirPath);
+
 // AWS SDK management functions (extern "C" declarations)
 extern "C" {
     S3UPLOAD_API int __stdcall FileExists(const char* filePath);
@@ -259,13 +1535,17 @@ extern "C" {
     S3UPLOAD_API const char* __stdcall InitializeAwsSDK();
     S3UPLOAD_API const char* __stdcall CleanupAwsSDK();
     S3UPLOAD_API const char* __stdcall CleanupUploadsByDataId(const char* dataId);
+    S3UPLOAD_API const char* __stdcall CancelUpload(const char* uploadId);
+    S3UPLOAD_API const char* __stdcall CancelUploadsByDataId(const char* dataId);
+    S3UPLOAD_API const char* __stdcall SetUploadHistoryRetention(long maxEntries, long maxAgeMinutes);
 }
 
 // S3 client creation helper
-Aws::S3::S3Client createS3Client(const String& accessKey,
-                                const String& secretKey,
-                                const String& sessionToken,
-                                const String& region);
+// Builds a new client; uploads should go through acquireS3Client (S3ClientCache.h) instead
+std::shared_ptr<Aws::S3::S3Client> createS3Client(const String& accessKey,
+                                                  const String& secretKey,
+                                                  const String& sessionToken,
+                                                  const String& region);
 
 // S3COMMON_H
 #endif
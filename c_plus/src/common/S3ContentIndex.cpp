@@ -0,0 +1,248 @@
+#include "S3ContentIndex.h"
+
+// Deduplication switches (SetUploadDeduplication)
+static std::atomic<bool> g_deduplicationEnabled(false);
+static std::atomic<bool> g_remoteCheckEnabled(false);
+
+static const char* const CONTENT_INDEX_HEADER = "S3UploadContentIndex 1";
+
+// Index location: %LOCALAPPDATA%\S3UploadLib\content.index
+static String getContentIndexPath() {
+    String localAppData = getLocalAppDataDirectory();
+    if (localAppData.empty()) {
+        return "";
+    }
+    return localAppData + PATH_SEPARATOR + "S3UploadLib" + PATH_SEPARATOR + CONTENT_INDEX_FILE_NAME;
+}
+
+// Fields are tab separated; values containing tabs or line breaks are not indexed
+static bool isIndexableValue(const String& value) {
+    return value.find_first_of("\t\r\n") == String::npos;
+}
+
+static String makeObjectKey(const String& bucketName, const String& objectKey) {
+    return bucketName + "\n" + objectKey;
+}
+
+ContentIndex& ContentIndex::getInstance() {
+    static ContentIndex instance;
+    return instance;
+}
+
+void ContentIndex::loadLocked() {
+    if (loaded_) {
+        return;
+    }
+    loaded_ = true;
+    indexPath_ = getContentIndexPath();
+    if (indexPath_.empty()) {
+        return;
+    }
+
+    std::ifstream file(indexPath_.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+
+    // Later lines supersede earlier ones for the same file or object
+    String line;
+    size_t lineCount = 0;
+    bool headerSeen = false;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!headerSeen) {
+            if (line != CONTENT_INDEX_HEADER) {
+                AWS_LOGSTREAM_WARN("S3Upload", "Ignoring content index with unknown format: " << indexPath_);
+                return;
+            }
+            headerSeen = true;
+            continue;
+        }
+
+        std::vector<String> fields;
+        std::istringstream lineStream(line);
+        String field;
+        while (std::getline(lineStream, field, '\t')) {
+            fields.push_back(field);
+        }
+
+        try {
+            if (fields.size() == 5 && fields[0] == "file") {
+                // file <size> <mtime> <sha256> <path>
+                FileEntry entry;
+                entry.fileSize = std::stoll(fields[1]);
+                entry.fileMtime = std::stoll(fields[2]);
+                entry.sha256 = fields[3];
+                files_[fields[4]] = entry;
+                lineCount++;
+            } else if (fields.size() == 4 && fields[0] == "object") {
+                // object <sha256> <bucket> <key>
+                objects_[makeObjectKey(fields[2], fields[3])] = fields[1];
+                lineCount++;
+            }
+        } catch (const std::exception&) {
+            // A crash during an append can leave a partial last line
+        }
+    }
+
+    if (lineCount - (files_.size() + objects_.size()) > CONTENT_INDEX_COMPACT_THRESHOLD) {
+        compactLocked();
+    }
+}
+
+void ContentIndex::appendLocked(const String& line) {
+    if (indexPath_.empty()) {
+        return;
+    }
+
+    bool exists = getFileSize64(indexPath_) > 0;
+    if (!exists) {
+        size_t separator = indexPath_.find_last_of(PATH_SEPARATOR);
+        createDirectories(indexPath_.substr(0, separator));
+    }
+
+    std::ofstream file(indexPath_.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        AWS_LOGSTREAM_WARN("S3Upload", "Cannot write content index: " << indexPath_);
+        return;
+    }
+    if (!exists) {
+        file << CONTENT_INDEX_HEADER << "\n";
+    }
+    file << line << "\n";
+}
+
+void ContentIndex::compactLocked() {
+    String tempPath = indexPath_ + ".tmp";
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file << CONTENT_INDEX_HEADER << "\n";
+        for (const auto& entry : files_) {
+            file << "file\t" << entry.second.fileSize << "\t" << entry.second.fileMtime << "\t"
+                 << entry.second.sha256 << "\t" << entry.first << "\n";
+        }
+        for (const auto& entry : objects_) {
+            size_t separator = entry.first.find('\n');
+            file << "object\t" << entry.second << "\t" << entry.first.substr(0, separator) << "\t"
+                 << entry.first.substr(separator + 1) << "\n";
+        }
+        if (!file.good()) {
+            return;
+        }
+    }
+    MoveFileExA(tempPath.c_str(), indexPath_.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
+
+bool ContentIndex::getContentHash(const String& filePath, String& sha256) {
+    long long fileSize = 0;
+    long long fileMtime = 0;
+    if (!getFileInfo64(filePath, fileSize, fileMtime)) {
+        return false;
+    }
+
+    // Step 1: An unchanged file reuses its recorded hash
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loadLocked();
+        auto it = files_.find(filePath);
+        if (it != files_.end() && it->second.fileSize == fileSize && it->second.fileMtime == fileMtime) {
+            sha256 = it->second.sha256;
+            return true;
+        }
+    }
+
+    // Step 2: Hash the file outside the lock (other uploads keep using the index)
+    Aws::FStream stream(filePath.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+    Aws::Utils::ByteBuffer digest = Aws::Utils::HashingUtils::CalculateSHA256(stream);
+    if (digest.GetLength() == 0) {
+        return false;
+    }
+    sha256 = Aws::Utils::HashingUtils::HexEncode(digest).c_str();
+
+    // Step 3: Record it for the next run
+    std::lock_guard<std::mutex> lock(mutex_);
+    FileEntry entry;
+    entry.fileSize = fileSize;
+    entry.fileMtime = fileMtime;
+    entry.sha256 = sha256;
+    files_[filePath] = entry;
+    if (isIndexableValue(filePath)) {
+        std::ostringstream oss;
+        oss << "file\t" << fileSize << "\t" << fileMtime << "\t" << sha256 << "\t" << filePath;
+        appendLocked(oss.str());
+    }
+    return true;
+}
+
+bool ContentIndex::isObjectUploaded(const String& bucketName, const String& objectKey, const String& sha256) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loadLocked();
+    auto it = objects_.find(makeObjectKey(bucketName, objectKey));
+    return it != objects_.end() && it->second == sha256;
+}
+
+void ContentIndex::recordObjectUploaded(const String& bucketName, const String& objectKey, const String& sha256) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loadLocked();
+    String key = makeObjectKey(bucketName, objectKey);
+    auto it = objects_.find(key);
+    if (it != objects_.end() && it->second == sha256) {
+        return;
+    }
+    objects_[key] = sha256;
+    if (isIndexableValue(bucketName) && isIndexableValue(objectKey)) {
+        appendLocked("object\t" + sha256 + "\t" + bucketName + "\t" + objectKey);
+    }
+}
+
+bool isUploadDeduplicationEnabled() {
+    return g_deduplicationEnabled.load();
+}
+
+bool isRemoteDeduplicationCheckEnabled() {
+    return g_remoteCheckEnabled.load();
+}
+
+bool isRemoteContentEqual(const Aws::S3::S3Client& s3Client,
+                          const String& bucketName,
+                          const String& objectKey,
+                          const String& sha256) {
+    Aws::S3::Model::HeadObjectRequest request;
+    request.SetBucket(bucketName);
+    request.SetKey(objectKey);
+
+    auto outcome = s3Client.HeadObject(request);
+    if (!outcome.IsSuccess()) {
+        // 404 is the normal case for a new object; anything else just means "upload it"
+        return false;
+    }
+    const auto& metadata = outcome.GetResult().GetMetadata();
+    auto it = metadata.find(METADATA_CONTENT_SHA256.c_str());
+    return it != metadata.end() && String(it->second.c_str()) == sha256;
+}
+
+// Enable or disable skipping of content that already reached its object
+// verifyRemote != 0 confirms with HeadObject (one request per file) instead of trusting
+// the local index, which cannot see objects deleted or replaced by someone else
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadDeduplication(long enabled, long verifyRemote) {
+    static std::string response;
+
+    g_deduplicationEnabled = enabled != 0;
+    g_remoteCheckEnabled = verifyRemote != 0;
+
+    std::ostringstream oss;
+    oss << "Upload deduplication " << (enabled ? "enabled" : "disabled");
+    if (enabled) {
+        oss << (verifyRemote ? ", verified with HeadObject" : ", using the local index");
+    }
+    response = create_response(UPLOAD_SUCCESS, oss.str());
+    return response.c_str();
+}
@@ -0,0 +1,79 @@
+#ifndef S3CONTENTINDEX_H
+#define S3CONTENTINDEX_H
+
+#include "S3Common.h"
+
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+
+// Content index configuration
+// File name of the index under %LOCALAPPDATA%\S3UploadLib
+static const String CONTENT_INDEX_FILE_NAME = "content.index";
+// Rewrite the index on load once it holds this many superseded lines
+static const size_t CONTENT_INDEX_COMPACT_THRESHOLD = 1000;
+
+// Object metadata key holding the SHA-256 (hex) of the local file content (x-amz-meta-*)
+static const String METADATA_CONTENT_SHA256 = "s3upload-sha256";
+
+// Persistent index of local file content and the objects it was uploaded to
+// File hashes are keyed by (path, size, mtime), so an unchanged file is never hashed twice.
+// Uploaded objects are keyed by (bucket, key) and hold the hash of the content last sent there.
+class ContentIndex {
+private:
+    struct FileEntry {
+        long long fileSize;
+        long long fileMtime;
+        String sha256;
+    };
+
+    mutable std::mutex mutex_;                          // Protects everything below
+    bool loaded_;                                       // Index file read into memory
+    String indexPath_;                                  // Empty when there is no index file
+    std::unordered_map<String, FileEntry> files_;       // Local path to content hash
+    std::unordered_map<String, String> objects_;        // bucket\nkey to content hash
+
+    // Read the index file once (mutex_ must be held)
+    void loadLocked();
+
+    // Append one line to the index file (mutex_ must be held)
+    void appendLocked(const String& line);
+
+    // Rewrite the index file from memory (mutex_ must be held)
+    void compactLocked();
+
+public:
+    ContentIndex() : loaded_(false) {}
+
+    // Get singleton instance of the index
+    static ContentIndex& getInstance();
+
+    // Get the SHA-256 (hex) of a file, hashing it only if it changed since last time
+    // Returns false if the file cannot be read
+    bool getContentHash(const String& filePath, String& sha256);
+
+    // Check whether this content was the last content uploaded to bucket/key
+    bool isObjectUploaded(const String& bucketName, const String& objectKey, const String& sha256);
+
+    // Record that content was uploaded to bucket/key
+    void recordObjectUploaded(const String& bucketName, const String& objectKey, const String& sha256);
+};
+
+// Check whether async uploads skip content that is already in S3 (SetUploadDeduplication)
+bool isUploadDeduplicationEnabled();
+
+// Check whether deduplication confirms content with HeadObject instead of trusting the index
+bool isRemoteDeduplicationCheckEnabled();
+
+// Check whether bucket/key already holds this content (by METADATA_CONTENT_SHA256)
+// Returns false when the object is missing, has other content, or the request fails
+bool isRemoteContentEqual(const Aws::S3::S3Client& s3Client,
+                          const String& bucketName,
+                          const String& objectKey,
+                          const String& sha256);
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetUploadDeduplication(long enabled, long verifyRemote);
+}
+
+// S3CONTENTINDEX_H
+#endif
@@ -0,0 +1,445 @@
+#include "S3EegCompression.h"
+
+#include <zstd.h>
+
+// Runtime compression settings, changed through SetUploadCompression
+static std::atomic<bool> g_compressionEnabled(false);
+static std::atomic<int> g_compressionLevel(DEFAULT_COMPRESSION_LEVEL);
+
+// Size of the fixed EDF/BDF header and of each per-signal header block
+static const long long EEG_FIXED_HEADER_BYTES = 256;
+static const long long EEG_SIGNAL_HEADER_BYTES = 256;
+// Offset of the "samples per record" fields in the signal header area, in bytes per signal
+// (label 16, transducer 80, dimension 8, physical/digital min/max 4 x 8, prefiltering 80)
+static const long long EEG_SAMPLES_FIELD_OFFSET = 216;
+// Upper bound for the signal count we accept from a header
+static const int EEG_MAX_SIGNALS = 4096;
+// Filter and compress about this many bytes of data records at a time
+static const size_t COMPRESSION_BATCH_BYTES = 1024 * 1024;
+
+// Uploads using each staged file in this process (StagedFileCleanup)
+// The write mutex makes concurrent uploads of one file wait for a single compression
+struct StagedFileUsers {
+    int count;
+    bool keep;
+    std::shared_ptr<std::mutex> writeMutex;
+
+    StagedFileUsers() : count(0), keep(false), writeMutex(std::make_shared<std::mutex>()) {}
+};
+static std::mutex g_stagedFilesMutex;
+static std::unordered_map<String, StagedFileUsers> g_stagedFiles;
+
+// Extensions of formats that are already compressed (video-EEG, images, archives)
+static const char* const PRECOMPRESSED_EXTENSIONS[] = {
+    ".zst", ".gz", ".zip", ".7z", ".rar", ".jpg", ".jpeg", ".png",
+    ".mp4", ".avi", ".mkv", ".mov", ".wmv", ".asf", ".m4v"
+};
+
+bool isUploadCompressionEnabled() {
+    return g_compressionEnabled.load();
+}
+
+// Parse a fixed-width ASCII number field from the header
+static bool parseHeaderNumber(const char* field, size_t width, long long& value) {
+    String text(field, width);
+    try {
+        value = std::stoll(text);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseEegRecordLayout(const String& filePath, long long fileSize, EegRecordLayout& layout) {
+    if (fileSize <= EEG_FIXED_HEADER_BYTES) {
+        return false;
+    }
+    std::ifstream file(filePath.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Step 1: Identify EDF ("0" version) or BDF (0xFF "BIOSEMI") by the version field
+    char fixedHeader[256];
+    if (!file.read(fixedHeader, sizeof(fixedHeader))) {
+        return false;
+    }
+    EegRecordLayout parsed;
+    if (std::memcmp(fixedHeader, "0       ", 8) == 0) {
+        parsed.sampleBytes = 2;
+    } else if (static_cast<unsigned char>(fixedHeader[0]) == 0xFF && std::memcmp(fixedHeader + 1, "BIOSEMI", 7) == 0) {
+        parsed.sampleBytes = 3;
+    } else {
+        return false;
+    }
+
+    // Step 2: Header size and signal count must agree with each other and the file
+    long long headerBytes = 0;
+    long long signalCount = 0;
+    if (!parseHeaderNumber(fixedHeader + 184, 8, headerBytes) ||
+        !parseHeaderNumber(fixedHeader + 252, 4, signalCount) ||
+        signalCount <= 0 || signalCount > EEG_MAX_SIGNALS ||
+        headerBytes != EEG_FIXED_HEADER_BYTES + signalCount * EEG_SIGNAL_HEADER_BYTES ||
+        headerBytes > fileSize) {
+        return false;
+    }
+    parsed.headerBytes = headerBytes;
+
+    // Step 3: Read samples per data record for each signal
+    std::vector<char> signalHeader(static_cast<size_t>(signalCount * EEG_SIGNAL_HEADER_BYTES));
+    if (!file.read(signalHeader.data(), signalHeader.size())) {
+        return false;
+    }
+    const char* samplesField = signalHeader.data() + signalCount * EEG_SAMPLES_FIELD_OFFSET;
+    for (long long i = 0; i < signalCount; i++) {
+        long long samples = 0;
+        if (!parseHeaderNumber(samplesField + i * 8, 8, samples) || samples <= 0) {
+            return false;
+        }
+        parsed.samplesPerRecord.push_back(static_cast<int>(samples));
+        parsed.recordBytes += samples * parsed.sampleBytes;
+    }
+
+    layout = parsed;
+    return true;
+}
+
+// Mark which signals get the delta filter
+// EDF+/BDF+ annotation signals hold text, not samples, and are passed through unchanged
+static std::vector<char> getFilteredSignals(const String& filePath, const EegRecordLayout& layout) {
+    size_t signalCount = layout.samplesPerRecord.size();
+    std::vector<char> filtered(signalCount, 1);
+
+    std::ifstream file(filePath.c_str(), std::ios::in | std::ios::binary);
+    std::vector<char> labels(signalCount * 16);
+    file.seekg(EEG_FIXED_HEADER_BYTES, std::ios::beg);
+    if (!file.read(labels.data(), labels.size())) {
+        return filtered;
+    }
+    for (size_t i = 0; i < signalCount; i++) {
+        String label(labels.data() + i * 16, 16);
+        if (label.find("Annotations") != String::npos) {
+            filtered[i] = 0;
+        }
+    }
+    return filtered;
+}
+
+// Replace each sample with its difference to the previous sample of the same signal
+// (little-endian, modulo 2^16 or 2^24). previous carries the last sample across records.
+static void applyDeltaFilter(unsigned char* data, size_t recordCount, const EegRecordLayout& layout,
+                             const std::vector<char>& filtered, std::vector<unsigned int>& previous) {
+    const int sampleBytes = layout.sampleBytes;
+    const unsigned int mask = sampleBytes == 2 ? 0xFFFFu : 0xFFFFFFu;
+
+    unsigned char* position = data;
+    for (size_t record = 0; record < recordCount; record++) {
+        for (size_t signal = 0; signal < layout.samplesPerRecord.size(); signal++) {
+            int samples = layout.samplesPerRecord[signal];
+            if (!filtered[signal]) {
+                position += static_cast<size_t>(samples) * sampleBytes;
+                continue;
+            }
+            unsigned int last = previous[signal];
+            for (int i = 0; i < samples; i++) {
+                unsigned int value = position[0] | (position[1] << 8);
+                if (sampleBytes == 3) {
+                    value |= position[2] << 16;
+                }
+                unsigned int delta = (value - last) & mask;
+                position[0] = static_cast<unsigned char>(delta);
+                position[1] = static_cast<unsigned char>(delta >> 8);
+                if (sampleBytes == 3) {
+                    position[2] = static_cast<unsigned char>(delta >> 16);
+                }
+                last = value;
+                position += sampleBytes;
+            }
+            previous[signal] = last;
+        }
+    }
+}
+
+// Streams input through a zstd compression context into a file
+class ZstdFileWriter {
+private:
+    ZSTD_CCtx* context_;
+    std::ofstream& output_;
+    std::vector<char> outBuffer_;
+
+public:
+    ZstdFileWriter(std::ofstream& output, int level, long long sourceSize)
+        : context_(ZSTD_createCCtx()), output_(output), outBuffer_(ZSTD_CStreamOutSize()) {
+        if (context_ != nullptr) {
+            ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel, level);
+            // Frame checksum lets the backend detect a corrupted decompression
+            ZSTD_CCtx_setParameter(context_, ZSTD_c_checksumFlag, 1);
+            ZSTD_CCtx_setPledgedSrcSize(context_, static_cast<unsigned long long>(sourceSize));
+        }
+    }
+
+    ~ZstdFileWriter() {
+        if (context_ != nullptr) {
+            ZSTD_freeCCtx(context_);
+        }
+    }
+
+    bool isValid() const { return context_ != nullptr; }
+
+    // Compress size bytes; last = true ends the frame
+    bool write(const void* data, size_t size, bool last, String& errorMessage) {
+        ZSTD_inBuffer input = { data, size, 0 };
+        ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        bool finished = false;
+        while (!finished) {
+            ZSTD_outBuffer output = { outBuffer_.data(), outBuffer_.size(), 0 };
+            size_t remaining = ZSTD_compressStream2(context_, &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                errorMessage = formatErrorMessage("zstd compression failed", ZSTD_getErrorName(remaining));
+                return false;
+            }
+            output_.write(outBuffer_.data(), static_cast<std::streamsize>(output.pos));
+            finished = last ? (remaining == 0) : (input.pos == input.size);
+        }
+        return output_.good();
+    }
+};
+
+// Lower-case extension of a path including the dot ("" if none)
+static String getLowerExtension(const String& filePath) {
+    size_t dot = filePath.find_last_of('.');
+    size_t separator = filePath.find_last_of("\\/");
+    if (dot == String::npos || (separator != String::npos && dot < separator)) {
+        return "";
+    }
+    String extension = filePath.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+static String getCompressionTempDirectory() {
+    char buffer[MAX_PATH + 1];
+    DWORD length = GetTempPathA(sizeof(buffer), buffer);
+    if (length == 0 || length > MAX_PATH) {
+        return "";
+    }
+    return String(buffer, length);
+}
+
+bool isCompressionTempFile(const String& filePath) {
+    size_t separator = filePath.find_last_of("\\/");
+    String fileName = separator == String::npos ? filePath : filePath.substr(separator + 1);
+    return fileName.compare(0, COMPRESSION_TEMP_PREFIX.size(), COMPRESSION_TEMP_PREFIX) == 0 &&
+           getLowerExtension(fileName) == COMPRESSION_TEMP_EXTENSION;
+}
+
+// Write the compressed form of localFilePath to outputPath
+static bool writeCompressedFile(const String& localFilePath,
+                                long long fileSize,
+                                const String& outputPath,
+                                const EegRecordLayout* layout,
+                                const std::shared_ptr<AsyncUploadProgress>& progress,
+                                String& errorMessage) {
+    std::ifstream input(localFilePath.c_str(), std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        errorMessage = formatErrorMessage(ErrorMessage::CANNOT_OPEN_FILE, localFilePath);
+        return false;
+    }
+    std::ofstream output(outputPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        errorMessage = formatErrorMessage("Cannot create compressed file", outputPath);
+        return false;
+    }
+
+    ZstdFileWriter writer(output, g_compressionLevel.load(), fileSize);
+    if (!writer.isValid()) {
+        errorMessage = "Cannot create zstd context";
+        return false;
+    }
+
+    // Step 1: Header (or nothing for unknown formats) goes in unchanged
+    long long headerBytes = layout ? layout->headerBytes : 0;
+    std::vector<unsigned char> buffer;
+    if (headerBytes > 0) {
+        buffer.resize(static_cast<size_t>(headerBytes));
+        if (!input.read(reinterpret_cast<char*>(buffer.data()), headerBytes)) {
+            errorMessage = formatErrorMessage("Cannot read EEG header", localFilePath);
+            return false;
+        }
+        if (!writer.write(buffer.data(), buffer.size(), headerBytes == fileSize, errorMessage)) {
+            return false;
+        }
+    }
+
+    // Step 2: Data in batches of whole records, delta-filtered per signal when the layout is known
+    size_t batchBytes = COMPRESSION_BATCH_BYTES;
+    std::vector<char> filtered;
+    std::vector<unsigned int> previous;
+    if (layout) {
+        size_t recordsPerBatch = std::max<size_t>(1, COMPRESSION_BATCH_BYTES / static_cast<size_t>(layout->recordBytes));
+        batchBytes = recordsPerBatch * static_cast<size_t>(layout->recordBytes);
+        filtered = getFilteredSignals(localFilePath, *layout);
+        previous.assign(layout->samplesPerRecord.size(), 0);
+    }
+    buffer.resize(batchBytes);
+
+    long long remaining = fileSize - headerBytes;
+    while (remaining > 0) {
+        if (progress && progress->shouldCancel.load()) {
+            errorMessage = "Upload cancelled";
+            return false;
+        }
+
+        size_t chunk = static_cast<size_t>(std::min<long long>(remaining, static_cast<long long>(batchBytes)));
+        if (!input.read(reinterpret_cast<char*>(buffer.data()), chunk)) {
+            errorMessage = formatErrorMessage("Cannot read file", localFilePath);
+            return false;
+        }
+        if (layout) {
+            // A trailing partial record (recording still being written) is passed through unchanged
+            applyDeltaFilter(buffer.data(), chunk / static_cast<size_t>(layout->recordBytes), *layout, filtered, previous);
+        }
+        remaining -= chunk;
+        if (!writer.write(buffer.data(), chunk, remaining == 0, errorMessage)) {
+            return false;
+        }
+    }
+
+    output.close();
+    return !output.fail();
+}
+
+bool compressFileForUpload(const String& localFilePath,
+                           const std::shared_ptr<AsyncUploadProgress>& progress,
+                           CompressedUpload& result,
+                           StagedFileCleanup& stagedFile,
+                           String& errorMessage) {
+    // Step 1: Skip formats that are already compressed
+    String extension = getLowerExtension(localFilePath);
+    for (const char* precompressed : PRECOMPRESSED_EXTENSIONS) {
+        if (extension == precompressed) {
+            errorMessage = "File format is already compressed";
+            return false;
+        }
+    }
+
+    long long fileSize = 0;
+    long long fileMtime = 0;
+    if (!getFileInfo64(localFilePath, fileSize, fileMtime) || fileSize <= 0) {
+        errorMessage = formatErrorMessage(ErrorMessage::CANNOT_READ_FILE_SIZE, localFilePath);
+        return false;
+    }
+
+    // Step 2: EDF/BDF get the delta filter, everything else plain zstd
+    EegRecordLayout layout;
+    bool isEeg = parseEegRecordLayout(localFilePath, fileSize, layout);
+    String filter = isEeg ? (layout.sampleBytes == 2 ? "delta-edf16" : "delta-bdf24") : "none";
+
+    // Step 3: Name the staged file after the source version and settings so a retry or resume reuses it
+    String tempDirectory = getCompressionTempDirectory();
+    if (tempDirectory.empty()) {
+        errorMessage = "Cannot get temp directory";
+        return false;
+    }
+    std::ostringstream nameStream;
+    nameStream << localFilePath << "\n" << fileSize << "\n" << fileMtime << "\n"
+               << filter << "\n" << g_compressionLevel.load();
+    std::ostringstream pathStream;
+    pathStream << tempDirectory << COMPRESSION_TEMP_PREFIX << std::hex << std::setw(16) << std::setfill('0')
+               << hashString64(nameStream.str()) << COMPRESSION_TEMP_EXTENSION;
+    String compressedPath = pathStream.str();
+
+    // Step 4: Use the staged file; while it is in use no other upload of this process deletes it
+    stagedFile.setPath(compressedPath);
+    std::shared_ptr<std::mutex> writeMutex;
+    {
+        std::lock_guard<std::mutex> lock(g_stagedFilesMutex);
+        writeMutex = g_stagedFiles[compressedPath].writeMutex;
+    }
+
+    // Step 5: Compress into a partial file of this upload and rename, so an existing staged file is
+    // always complete; another upload compressing the same file meanwhile is waited for and reused
+    long long compressedSize = 0;
+    {
+        std::lock_guard<std::mutex> writeLock(*writeMutex);
+        compressedSize = getFileSize64(compressedPath);
+        if (compressedSize <= 0) {
+            AWS_LOGSTREAM_INFO("S3Upload", "Compressing " << localFilePath << " (filter " << filter << ")");
+            std::ostringstream partialStream;
+            partialStream << compressedPath << "." << std::hex << std::setw(16) << std::setfill('0')
+                          << hashString64(progress ? progress->uploadId : localFilePath) << ".partial";
+            String partialPath = partialStream.str();
+            if (!writeCompressedFile(localFilePath, fileSize, partialPath, isEeg ? &layout : nullptr, progress, errorMessage) ||
+                !MoveFileExA(partialPath.c_str(), compressedPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                DeleteFileA(partialPath.c_str());
+                if (errorMessage.empty()) {
+                    errorMessage = formatErrorMessage("Cannot stage compressed file", compressedPath);
+                }
+                stagedFile.reset();
+                return false;
+            }
+            compressedSize = getFileSize64(compressedPath);
+        }
+    }
+
+    // Step 6: Only worth sending if it actually saves bytes on the wire
+    if (compressedSize <= 0 || compressedSize > static_cast<long long>(fileSize * (1.0 - MIN_COMPRESSION_SAVING))) {
+        stagedFile.reset();
+        errorMessage = "Compression saves too little";
+        return false;
+    }
+
+    result.compressedPath = compressedPath;
+    result.originalSize = fileSize;
+    result.compressedSize = compressedSize;
+    result.metadata.clear();
+    result.metadata[METADATA_ENCODING] = "zstd";
+    result.metadata[METADATA_FILTER] = filter;
+    result.metadata[METADATA_ORIGINAL_SIZE] = std::to_string(fileSize);
+    AWS_LOGSTREAM_INFO("S3Upload", "Compressed " << localFilePath << ": " << fileSize << " -> " << compressedSize << " bytes");
+    return true;
+}
+
+void StagedFileCleanup::setPath(const String& filePath) {
+    reset();
+    std::lock_guard<std::mutex> lock(g_stagedFilesMutex);
+    g_stagedFiles[filePath].count++;
+    filePath_ = filePath;
+}
+
+void StagedFileCleanup::reset() {
+    if (filePath_.empty()) {
+        return;
+    }
+
+    // Delete under the lock so a new user never sees the file just before it goes away
+    std::lock_guard<std::mutex> lock(g_stagedFilesMutex);
+    auto usersIt = g_stagedFiles.find(filePath_);
+    if (usersIt != g_stagedFiles.end()) {
+        usersIt->second.keep = usersIt->second.keep || keep_;
+        if (--usersIt->second.count == 0) {
+            if (!usersIt->second.keep) {
+                DeleteFileA(filePath_.c_str());
+            }
+            g_stagedFiles.erase(usersIt);
+        }
+    }
+    filePath_.clear();
+    keep_ = false;
+}
+
+// Enable or disable compression of async uploads (delta filter for EDF/BDF, then zstd)
+// level <= 0 keeps the current zstd level
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadCompression(long enabled, long level) {
+    static std::string response;
+
+    if (level > 0) {
+        g_compressionLevel = static_cast<int>(std::min<long>(level, ZSTD_maxCLevel()));
+    }
+    g_compressionEnabled = enabled != 0;
+
+    std::ostringstream oss;
+    oss << "Upload compression " << (enabled ? "enabled" : "disabled") << ", zstd level " << g_compressionLevel.load();
+    response = create_response(UPLOAD_SUCCESS, oss.str());
+    return response.c_str();
+}
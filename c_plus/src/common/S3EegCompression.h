@@ -0,0 +1,101 @@
+#ifndef S3EEGCOMPRESSION_H
+#define S3EEGCOMPRESSION_H
+
+#include "S3Common.h"
+
+// Compression configuration
+// zstd level used when compression is enabled (3 keeps up with a few Mbit/s uplinks on one core)
+static const int DEFAULT_COMPRESSION_LEVEL = 3;
+// Compressed output must save at least this share of the file, otherwise the original is sent
+static const double MIN_COMPRESSION_SAVING = 0.05;
+// Prefix of staged compressed files in the temp directory
+static const String COMPRESSION_TEMP_PREFIX = "s3upload_";
+// Extension of staged compressed files
+static const String COMPRESSION_TEMP_EXTENSION = ".zst";
+
+// Object metadata keys describing the transform (x-amz-meta-*)
+// The backend reverses it by zstd-decompressing, then undoing the delta filter
+// per channel using the unchanged EDF/BDF header in the decompressed stream.
+static const String METADATA_ENCODING = "s3upload-encoding";
+static const String METADATA_FILTER = "s3upload-filter";
+static const String METADATA_ORIGINAL_SIZE = "s3upload-original-size";
+
+// Data layout of an EDF (16-bit) or BDF (24-bit) recording
+struct EegRecordLayout {
+    // Bytes of the fixed plus per-signal header
+    long long headerBytes;
+    // Bytes per sample: 2 for EDF, 3 for BDF
+    int sampleBytes;
+    // Samples per data record for each signal, in storage order
+    std::vector<int> samplesPerRecord;
+    // Bytes of one data record (all signals)
+    long long recordBytes;
+
+    EegRecordLayout() : headerBytes(0), sampleBytes(0), recordBytes(0) {}
+};
+
+// A file staged for upload in compressed form
+struct CompressedUpload {
+    // Path of the compressed file to upload instead of the original
+    String compressedPath;
+    long long originalSize;
+    long long compressedSize;
+    // Metadata for the uploaded object
+    ObjectMetadata metadata;
+
+    CompressedUpload() : originalSize(0), compressedSize(0) {}
+};
+
+// Check whether uploads should be compressed (SetUploadCompression)
+bool isUploadCompressionEnabled();
+
+// Parse the EDF/BDF header and return the data record layout
+// Returns false for files that are not EDF/BDF or have an inconsistent header
+bool parseEegRecordLayout(const String& filePath, long long fileSize, EegRecordLayout& layout);
+
+// Check whether a path is a compressed file staged by compressFileForUpload
+bool isCompressionTempFile(const String& filePath);
+
+// Holds one upload's use of a staged compressed file
+// Uploads of the same file share its staged copy; the last one to finish deletes it,
+// unless one of them called keep() for a journaled upload that will be resumed later
+class StagedFileCleanup {
+public:
+    StagedFileCleanup() : keep_(false) {}
+    ~StagedFileCleanup() { reset(); }
+
+    // Start using filePath (registers this upload as one of its users)
+    void setPath(const String& filePath);
+    const String& getPath() const { return filePath_; }
+    bool hasPath() const { return !filePath_.empty(); }
+    void keep() { keep_ = true; }
+    // Stop using the file now instead of when this object goes away
+    void reset();
+
+private:
+    String filePath_;
+    bool keep_;
+
+    StagedFileCleanup(const StagedFileCleanup&) = delete;
+    StagedFileCleanup& operator=(const StagedFileCleanup&) = delete;
+};
+
+// Compress a file for upload: delta-per-channel filter for EDF/BDF, then zstd
+// Staged output is named after (path, size, mtime), so an interrupted upload reuses it
+// and its resume journal. Each upload compresses into its own partial file that is renamed
+// into place; concurrent uploads of the same file in this process compress it once.
+// On success stagedFile holds the staged copy for the caller's upload. Returns false when
+// the file should be sent as is (already compressed formats, too little saving, cancellation
+// or errors; errorMessage says why).
+bool compressFileForUpload(const String& localFilePath,
+                           const std::shared_ptr<AsyncUploadProgress>& progress,
+                           CompressedUpload& result,
+                           StagedFileCleanup& stagedFile,
+                           String& errorMessage);
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetUploadCompression(long enabled, long level);
+}
+
+// S3EEGCOMPRESSION_H
+#endif
@@ -0,0 +1,82 @@
+#include "S3MappedFileBody.h"
+
+// Mapped views must start on the system allocation granularity (64 KB on Windows)
+static long long getAllocationGranularity() {
+    static const long long granularity = []() {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return static_cast<long long>(systemInfo.dwAllocationGranularity);
+    }();
+    return granularity;
+}
+
+MappedFileBody::MappedFileBody()
+    : fileHandle_(INVALID_HANDLE_VALUE),
+      mappingHandle_(nullptr),
+      view_(nullptr),
+      length_(0) {}
+
+MappedFileBody::~MappedFileBody() {
+    close();
+}
+
+bool MappedFileBody::open(const String& filePath, long long offset, long long length) {
+    close();
+    if (length <= 0 || offset < 0 || length > MAX_MAPPED_VIEW_SIZE) {
+        return false;
+    }
+
+    // Step 1: Open the file; sharing matches FStream so files still being written can be uploaded
+    fileHandle_ = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // Step 2: Create a read-only mapping of the whole file
+    mappingHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle_ == nullptr) {
+        close();
+        return false;
+    }
+
+    // Step 3: Map only the requested range, starting at the granularity boundary below offset
+    long long viewOffset = offset - offset % getAllocationGranularity();
+    long long delta = offset - viewOffset;
+    view_ = MapViewOfFile(mappingHandle_, FILE_MAP_READ,
+                          static_cast<DWORD>(viewOffset >> 32),
+                          static_cast<DWORD>(viewOffset & 0xFFFFFFFF),
+                          static_cast<size_t>(delta + length));
+    if (view_ == nullptr) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Cannot map " << length << " bytes of " << filePath
+                           << ", falling back to stream reads");
+        close();
+        return false;
+    }
+
+    // Step 4: Expose the range as a stream; the SDK only reads from request bodies,
+    // so handing the read-only pages to PreallocatedStreamBuf is safe
+    unsigned char* data = static_cast<unsigned char*>(view_) + delta;
+    length_ = length;
+    streamBuf_.reset(new Aws::Utils::Stream::PreallocatedStreamBuf(data, static_cast<uint64_t>(length)));
+    stream_ = Aws::MakeShared<Aws::IOStream>("MappedFileBody", streamBuf_.get());
+    return true;
+}
+
+void MappedFileBody::close() {
+    stream_.reset();
+    streamBuf_.reset();
+    if (view_ != nullptr) {
+        UnmapViewOfFile(view_);
+        view_ = nullptr;
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(mappingHandle_);
+        mappingHandle_ = nullptr;
+    }
+    if (fileHandle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle_);
+        fileHandle_ = INVALID_HANDLE_VALUE;
+    }
+    length_ = 0;
+}
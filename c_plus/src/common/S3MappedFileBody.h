@@ -0,0 +1,45 @@
+#ifndef S3MAPPEDFILEBODY_H
+#define S3MAPPEDFILEBODY_H
+
+#include "S3Common.h"
+
+// Largest view we map at once; the DLL is a 32-bit process, so keep views well
+// below the fragmented 2 GB address space. Larger ranges fall back to stream reads.
+static const long long MAX_MAPPED_VIEW_SIZE = 256LL * 1024 * 1024;
+
+// Request body backed by a read-only memory-mapped view of a file range
+// The HTTP client reads straight from the mapped pages: no FStream buffering and no
+// intermediate copy, and a second pass over the body (payload hashing, retries) is
+// served from the same pages. The view stays valid until the object is destroyed,
+// so it must outlive every request that uses getStream().
+class MappedFileBody {
+private:
+    HANDLE fileHandle_;
+    HANDLE mappingHandle_;
+    void* view_;
+    long long length_;
+    std::unique_ptr<Aws::Utils::Stream::PreallocatedStreamBuf> streamBuf_;
+    std::shared_ptr<Aws::IOStream> stream_;
+
+    MappedFileBody(const MappedFileBody&);
+    MappedFileBody& operator=(const MappedFileBody&);
+
+public:
+    MappedFileBody();
+    ~MappedFileBody();
+
+    // Map length bytes starting at offset
+    // Returns false for empty ranges, ranges above MAX_MAPPED_VIEW_SIZE or mapping errors;
+    // callers then fall back to reading the file through a stream
+    bool open(const String& filePath, long long offset, long long length);
+
+    // Unmap the view and close the handles
+    void close();
+
+    bool isOpen() const { return view_ != nullptr; }
+    long long size() const { return length_; }
+    const std::shared_ptr<Aws::IOStream>& getStream() const { return stream_; }
+};
+
+// S3MAPPEDFILEBODY_H
+#endif
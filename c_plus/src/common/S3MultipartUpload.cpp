@@ -0,0 +1,719 @@
+#include "S3MultipartUpload.h"
+#include "S3MappedFileBody.h"
+#include "S3BandwidthGovernor.h"
+#include "S3RetryPolicy.h"
+#include "S3UploadTrace.h"
+
+#include <functional>
+
+// Runtime multipart settings, changed through ConfigureMultipartUpload
+static std::atomic<long long> g_multipartThreshold(DEFAULT_MULTIPART_THRESHOLD);
+static std::atomic<int> g_multipartConcurrency(DEFAULT_MULTIPART_CONCURRENCY);
+
+long long getMultipartThreshold() {
+    return g_multipartThreshold.load();
+}
+
+int getMultipartConcurrency() {
+    return g_multipartConcurrency.load();
+}
+
+bool shouldUseMultipartUpload(long long fileSize) {
+    return fileSize > getMultipartThreshold();
+}
+
+long long chooseMultipartPartSize(long long fileSize) {
+    const long long oneMB = 1024LL * 1024;
+    long long partSize = MIN_MULTIPART_PART_SIZE;
+
+    // Grow part size for very large files so we stay below the part limit
+    long long minimumForLimit = (fileSize + MAX_MULTIPART_PARTS - 1) / MAX_MULTIPART_PARTS;
+    if (minimumForLimit > partSize) {
+        partSize = ((minimumForLimit + oneMB - 1) / oneMB) * oneMB;
+    }
+
+    // Larger files get larger parts to cut per-request overhead (aim for ~1000 parts)
+    long long preferred = ((fileSize / 1000 + oneMB - 1) / oneMB) * oneMB;
+    if (preferred > partSize) {
+        partSize = preferred;
+    }
+
+    // Keep parts a reasonable size for memory, unless the part limit forces more
+    const long long preferredMax = 64LL * 1024 * 1024;
+    if (partSize > preferredMax && minimumForLimit <= preferredMax) {
+        partSize = preferredMax;
+    }
+
+    if (partSize > MAX_MULTIPART_PART_SIZE) {
+        partSize = MAX_MULTIPART_PART_SIZE;
+    }
+    return partSize;
+}
+
+// Part threads shared by every multipart upload in the process, so the thread count stays at
+// MAX_MULTIPART_HELPER_THREADS however many files are uploaded at once. Threads start on demand
+// and then wait for more work; a caller always sends parts itself, so it never waits on them.
+class PartHelperPool {
+public:
+    // Never destroyed: idle helpers may still wait on it while static objects go away
+    static PartHelperPool& getInstance() {
+        static PartHelperPool* instance = new PartHelperPool();
+        return *instance;
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+            if (tasks_.size() > idleHelpers_ && helpers_.size() < static_cast<size_t>(MAX_MULTIPART_HELPER_THREADS)) {
+                helpers_.emplace_back(&PartHelperPool::helperLoop, this);
+            }
+        }
+        taskAvailable_.notify_one();
+    }
+
+    // Join all helpers; a later submit starts new ones
+    void stop() {
+        std::vector<std::thread> helpersToJoin;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            helpersToJoin.swap(helpers_);
+        }
+        taskAvailable_.notify_all();
+        for (auto& helper : helpersToJoin) {
+            if (helper.joinable()) {
+                helper.join();
+            }
+        }
+
+        // Tasks left over belong to callers that send those parts themselves
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.clear();
+        idleHelpers_ = 0;
+        stopping_ = false;
+    }
+
+private:
+    PartHelperPool() : idleHelpers_(0), stopping_(false) {}
+
+    void helperLoop() {
+        setUploadTraceThreadName("multipart part worker");
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            idleHelpers_++;
+            taskAvailable_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            idleHelpers_--;
+            if (stopping_) {
+                return;
+            }
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            try {
+                task();
+            } catch (...) {
+                AWS_LOGSTREAM_ERROR("S3Upload", "Unhandled exception in multipart part worker");
+            }
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable taskAvailable_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> helpers_;
+    size_t idleHelpers_;
+    bool stopping_;
+};
+
+void stopMultipartPartHelpers() {
+    PartHelperPool::getInstance().stop();
+}
+
+// Helpers lent to one upload; closed once the calling thread ran out of parts, so a helper
+// that starts later leaves without touching the caller's frame
+struct PartHelperGroup {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool closed = false;
+    int running = 0;
+};
+
+// Abort a multipart upload so S3 discards the parts already stored
+static void abortMultipartUpload(const Aws::S3::S3Client& s3Client,
+                                 const String& bucketName,
+                                 const String& objectKey,
+                                 const String& multipartUploadId) {
+    Aws::S3::Model::AbortMultipartUploadRequest abortRequest;
+    abortRequest.SetBucket(bucketName);
+    abortRequest.SetKey(objectKey);
+    abortRequest.SetUploadId(multipartUploadId);
+
+    auto outcome = s3Client.AbortMultipartUpload(abortRequest);
+    if (!outcome.IsSuccess()) {
+        AWS_LOGSTREAM_WARN("S3Upload", "AbortMultipartUpload failed for " << objectKey << " - "
+                           << outcome.GetError().GetMessage());
+    }
+}
+
+// Upload a single part with retry
+// The part range is sent from a mapped view of the file (or read into memory once
+// when it cannot be mapped) and the body is rewound for each attempt
+static bool uploadSinglePart(const Aws::S3::S3Client& s3Client,
+                             const String& bucketName,
+                             const String& objectKey,
+                             const String& multipartUploadId,
+                             const String& localFilePath,
+                             int partNumber,
+                             long long offset,
+                             long long length,
+                             const std::shared_ptr<AsyncUploadProgress>& progress,
+                             Aws::S3::Model::CompletedPart& completedPart,
+                             String& errorMessage) {
+    // Step 1: Map the part range; the HTTP client reads straight from the mapped pages
+    MappedFileBody mappedBody;
+    std::vector<unsigned char> partBuffer;
+    std::unique_ptr<Aws::Utils::Stream::PreallocatedStreamBuf> bufferStreamBuf;
+    std::shared_ptr<Aws::IOStream> body;
+    UploadTraceSpan openSpan(TRACE_SPAN_OPEN, progress.get(), partNumber);
+
+    if (mappedBody.open(localFilePath, offset, length)) {
+        body = mappedBody.getStream();
+    } else {
+        // Fallback: read the part range into memory once
+        std::ifstream file(localFilePath.c_str(), std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            errorMessage = formatErrorMessage(ErrorMessage::CANNOT_OPEN_FILE, localFilePath);
+            return false;
+        }
+
+        partBuffer.resize(static_cast<size_t>(length));
+        file.seekg(offset, std::ios::beg);
+        file.read(reinterpret_cast<char*>(partBuffer.data()), length);
+        if (file.gcount() != length) {
+            errorMessage = formatErrorMessage("Cannot read part " + std::to_string(partNumber), localFilePath);
+            return false;
+        }
+        file.close();
+
+        // Wrap the buffer as the request body without copying it again
+        bufferStreamBuf.reset(new Aws::Utils::Stream::PreallocatedStreamBuf(partBuffer.data(), static_cast<uint64_t>(length)));
+        body = Aws::MakeShared<Aws::IOStream>("UploadPartBody", bufferStreamBuf.get());
+    }
+    openSpan.end();
+
+    // Step 2: Build the part request
+    Aws::S3::Model::UploadPartRequest request;
+    request.SetBucket(bucketName);
+    request.SetKey(objectKey);
+    request.SetUploadId(multipartUploadId);
+    request.SetPartNumber(partNumber);
+    request.SetContentLength(length);
+    request.SetBody(body);
+    // CRC32C is computed while the part streams out and sent as a trailer
+    request.SetChecksumAlgorithm(Aws::S3::Model::ChecksumAlgorithm::CRC32C);
+
+    // Feed bytes sent into the upload's progress counters
+    RequestBytesTracker bytesTracker(progress);
+    bytesTracker.attach(request);
+    BandwidthAccountingScope bandwidthScope(progress.get());
+
+    // Step 3: Send the part, retrying only this part on transient errors
+    RetryController retry(progress);
+    while (true) {
+        if (progress && progress->shouldCancel.load()) {
+            errorMessage = "Upload cancelled";
+            return false;
+        }
+
+        if (retry.getRetryCount() > 0) {
+            // Rewind body so the retry sends the full part again
+            body->clear();
+            body->seekg(0, std::ios::beg);
+        }
+
+        UploadTraceSpan attemptSpan(TRACE_SPAN_UPLOAD_PART, progress.get(), partNumber, retry.getRetryCount() + 1);
+        auto outcome = s3Client.UploadPart(request);
+        attemptSpan.end();
+        if (outcome.IsSuccess()) {
+            retry.recordSuccess();
+            bytesTracker.commit();
+            completedPart.SetPartNumber(partNumber);
+            completedPart.SetETag(outcome.GetResult().GetETag());
+            completedPart.SetChecksumCRC32C(outcome.GetResult().GetChecksumCRC32C());
+            return true;
+        }
+
+        bytesTracker.rollback();
+        errorMessage = "S3 part " + std::to_string(partNumber) + " upload failed (attempt " +
+                       std::to_string(retry.getRetryCount() + 1) + "): " + String(outcome.GetError().GetMessage().c_str());
+        AWS_LOGSTREAM_WARN("S3Upload", errorMessage);
+        if (!retry.shouldRetry(outcome.GetError())) {
+            return false;
+        }
+    }
+}
+
+// State of a journaled multipart upload on S3
+enum JournaledUploadState {
+    JOURNALED_UPLOAD_ACTIVE,      // Parts can still be added
+    JOURNALED_UPLOAD_GONE,        // Aborted elsewhere or removed by a bucket lifecycle rule
+    JOURNALED_UPLOAD_REJECTED,    // S3 refused the check for another reason
+    JOURNALED_UPLOAD_UNREACHABLE  // Not known right now: transient errors, credentials or cancel
+};
+
+// Check that a journaled multipart upload still exists on S3
+// Only NoSuchUpload means it is gone; transient errors are retried like any other request
+static JournaledUploadState checkJournaledUpload(const Aws::S3::S3Client& s3Client,
+                                                 const String& bucketName,
+                                                 const String& objectKey,
+                                                 const String& multipartUploadId,
+                                                 const std::shared_ptr<AsyncUploadProgress>& progress,
+                                                 String& errorMessage) {
+    Aws::S3::Model::ListPartsRequest listRequest;
+    listRequest.SetBucket(bucketName);
+    listRequest.SetKey(objectKey);
+    listRequest.SetUploadId(multipartUploadId);
+    listRequest.SetMaxParts(1);
+
+    // Step 1: Retry transient errors; permanent ones are classified below without counting as failures
+    RetryController retry(progress);
+    auto outcome = s3Client.ListParts(listRequest);
+    while (!outcome.IsSuccess() && isRetryableS3Error(outcome.GetError()) && retry.shouldRetry(outcome.GetError())) {
+        outcome = s3Client.ListParts(listRequest);
+    }
+    if (outcome.IsSuccess()) {
+        retry.recordSuccess();
+        return JOURNALED_UPLOAD_ACTIVE;
+    }
+
+    // Step 2: Classify the error
+    const auto& error = outcome.GetError();
+    if (error.GetErrorType() == Aws::S3::S3Errors::NO_SUCH_UPLOAD) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Journaled multipart upload of " << objectKey << " no longer exists");
+        return JOURNALED_UPLOAD_GONE;
+    }
+    if (progress && progress->shouldCancel.load()) {
+        errorMessage = "Upload cancelled";
+        return JOURNALED_UPLOAD_UNREACHABLE;
+    }
+    errorMessage = "Cannot check journaled multipart upload: " + String(error.GetMessage().c_str());
+    AWS_LOGSTREAM_WARN("S3Upload", errorMessage << " (" << objectKey << ")");
+    UploadErrorCode errorCode = getUploadErrorCode(error);
+    if (errorCode == UPLOAD_ERROR_NETWORK || errorCode == UPLOAD_ERROR_CREDENTIALS_EXPIRED ||
+        errorCode == UPLOAD_ERROR_ACCESS_DENIED) {
+        if (progress) {
+            progress->errorCode = errorCode;
+        }
+        return JOURNALED_UPLOAD_UNREACHABLE;
+    }
+    return JOURNALED_UPLOAD_REJECTED;
+}
+
+// Outcome of looking for a journal to resume
+enum JournalResumeResult {
+    JOURNAL_START_NEW,   // No usable journal; a stale one was discarded
+    JOURNAL_RESUMED,     // journal holds the upload to continue
+    JOURNAL_UNAVAILABLE  // The journaled upload could not be checked; the journal is kept
+};
+
+// Load the journal for this upload if it can be resumed
+// A journal for a changed file or a vanished multipart upload is discarded; a multipart upload
+// still on S3 is aborted first so its parts are not left behind
+static JournalResumeResult loadResumableJournal(const Aws::S3::S3Client& s3Client,
+                                                const String& journalPath,
+                                                const String& bucketName,
+                                                const String& objectKey,
+                                                const String& localFilePath,
+                                                long long fileSize,
+                                                long long fileMtime,
+                                                const std::shared_ptr<AsyncUploadProgress>& progress,
+                                                UploadJournal& journal,
+                                                String& errorMessage) {
+    UploadJournal existing;
+    if (!loadUploadJournal(journalPath, existing)) {
+        return JOURNAL_START_NEW;
+    }
+
+    bool matches = existing.bucketName == bucketName && existing.objectKey == objectKey &&
+                   existing.localFilePath == localFilePath && existing.fileSize == fileSize &&
+                   existing.fileMtime == fileMtime;
+    if (!matches) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Local file changed since journaled upload, restarting " << objectKey);
+        abortMultipartUpload(s3Client, existing.bucketName, existing.objectKey, existing.multipartUploadId);
+        removeUploadJournal(existing);
+        return JOURNAL_START_NEW;
+    }
+
+    switch (checkJournaledUpload(s3Client, bucketName, objectKey, existing.multipartUploadId, progress, errorMessage)) {
+        case JOURNALED_UPLOAD_ACTIVE:
+            journal = existing;
+            return JOURNAL_RESUMED;
+        case JOURNALED_UPLOAD_UNREACHABLE:
+            return JOURNAL_UNAVAILABLE;
+        case JOURNALED_UPLOAD_REJECTED:
+            // Best effort: drop the stored parts before forgetting the upload
+            abortMultipartUpload(s3Client, bucketName, objectKey, existing.multipartUploadId);
+            break;
+        case JOURNALED_UPLOAD_GONE:
+            break;
+    }
+    errorMessage.clear();
+    removeUploadJournal(existing);
+    return JOURNAL_START_NEW;
+}
+
+// What to do with a multipart upload whose CompleteMultipartUpload gave up
+enum CompleteFailure {
+    COMPLETE_FAILURE_KEEP,     // Transient, credential or shutdown failure: keep it resumable
+    COMPLETE_FAILURE_ABORT,    // The part list was refused or the user cancelled: abort it
+    COMPLETE_FAILURE_GONE      // NoSuchUpload: nothing left on S3 to keep or abort
+};
+
+// Classify the error that ended the CompleteMultipartUpload retries
+static CompleteFailure classifyCompleteFailure(const Aws::S3::S3Error& error,
+                                               const std::shared_ptr<AsyncUploadProgress>& progress) {
+    // Step 1: A user cancel aborts; CleanupAwsSDK leaves the upload for ResumeUploads
+    if (progress && progress->shouldCancel.load()) {
+        return progress->cancelledForShutdown.load() ? COMPLETE_FAILURE_KEEP : COMPLETE_FAILURE_ABORT;
+    }
+
+    // Step 2: Parts S3 will never accept in this list
+    String errorName = error.GetExceptionName().c_str();
+    if (errorName == "InvalidPart" || errorName == "InvalidPartOrder" || errorName == "EntityTooSmall") {
+        return COMPLETE_FAILURE_ABORT;
+    }
+
+    // Step 3: Network errors (retries or budget used up), expired or denied credentials and
+    // any other error leave the stored parts for the next attempt
+    UploadErrorCode errorCode = getUploadErrorCode(error);
+    if (progress) {
+        progress->errorCode = errorCode;
+    }
+    return COMPLETE_FAILURE_KEEP;
+}
+
+// Check whether the object already holds the completed multipart upload
+// Used when a retried CompleteMultipartUpload finds the upload gone: the size must match and
+// the composite CRC32C must cover the same number of parts. checksum receives that CRC32C.
+static bool isMultipartObjectComplete(const Aws::S3::S3Client& s3Client,
+                                      const String& bucketName,
+                                      const String& objectKey,
+                                      long long fileSize,
+                                      int partCount,
+                                      String& checksum) {
+    Aws::S3::Model::HeadObjectRequest headRequest;
+    headRequest.SetBucket(bucketName);
+    headRequest.SetKey(objectKey);
+    headRequest.SetChecksumMode(Aws::S3::Model::ChecksumMode::ENABLED);
+
+    auto outcome = s3Client.HeadObject(headRequest);
+    if (!outcome.IsSuccess() || outcome.GetResult().GetContentLength() != fileSize) {
+        return false;
+    }
+    String objectChecksum = outcome.GetResult().GetChecksumCRC32C().c_str();
+    String partsSuffix = "-" + std::to_string(partCount);
+    if (objectChecksum.size() <= partsSuffix.size() ||
+        objectChecksum.compare(objectChecksum.size() - partsSuffix.size(), partsSuffix.size(), partsSuffix) != 0) {
+        return false;
+    }
+    checksum = objectChecksum;
+    return true;
+}
+
+bool uploadFileMultipart(const Aws::S3::S3Client& s3Client,
+                         const String& bucketName,
+                         const String& objectKey,
+                         const String& localFilePath,
+                         long long fileSize,
+                         const std::shared_ptr<AsyncUploadProgress>& progress,
+                         const ObjectMetadata& metadata,
+                         String& checksum,
+                         String& errorMessage) {
+    // Step 1: Resume from an upload journal when one matches this file
+    // A journal held by another upload of the same file in this process is neither resumed
+    // nor written; this upload then runs unjournaled
+    UploadJournal journal;
+    UploadJournalLock journalLock;
+    bool resumed = false;
+    long long fileMtime = 0;
+    long long currentSize = 0;
+    String journalPath = isUploadJournalEnabled() ? getUploadJournalPath(bucketName, objectKey, localFilePath) : "";
+    if (!journalPath.empty() && !journalLock.acquire(journalPath)) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Journal for " << objectKey << " is used by another upload, not journaling this one");
+    } else if (!journalPath.empty() && getFileInfo64(localFilePath, currentSize, fileMtime)) {
+        JournalResumeResult resumeResult = loadResumableJournal(s3Client, journalPath, bucketName, objectKey,
+                                                                localFilePath, fileSize, fileMtime, progress,
+                                                                journal, errorMessage);
+        if (resumeResult == JOURNAL_UNAVAILABLE) {
+            // Keep the journal so a later attempt (or ResumeUploads) continues the stored parts
+            return false;
+        }
+        resumed = resumeResult == JOURNAL_RESUMED;
+        journal.journalPath = journalPath;
+    }
+
+    // Step 2: Plan parts (a resumed upload keeps its original part size)
+    long long partSize = resumed ? journal.partSize : chooseMultipartPartSize(fileSize);
+    int partCount = static_cast<int>((fileSize + partSize - 1) / partSize);
+    if (partCount < 1) {
+        partCount = 1;
+    }
+    if (progress) {
+        progress->totalParts = partCount;
+        progress->completedParts = 0;
+    }
+
+    // Step 3: Start a new multipart upload unless resuming one
+    String multipartUploadId;
+    if (resumed) {
+        multipartUploadId = journal.multipartUploadId;
+        AWS_LOGSTREAM_INFO("S3Upload", "Resuming multipart upload of " << objectKey << ": "
+                           << journal.completedParts.size() << " of " << partCount << " parts already stored");
+    } else {
+        AWS_LOGSTREAM_INFO("S3Upload", "Multipart upload: " << partCount << " parts of " << partSize << " bytes");
+
+        Aws::S3::Model::CreateMultipartUploadRequest createRequest;
+        createRequest.SetBucket(bucketName);
+        createRequest.SetKey(objectKey);
+        createRequest.SetContentType("application/octet-stream");
+        createRequest.SetChecksumAlgorithm(Aws::S3::Model::ChecksumAlgorithm::CRC32C);
+        for (const auto& entry : metadata) {
+            createRequest.AddMetadata(entry.first.c_str(), entry.second.c_str());
+        }
+
+        RetryController createRetry(progress);
+        UploadTraceSpan createSpan(TRACE_SPAN_CREATE_MULTIPART, progress.get(), 0, 1);
+        auto createOutcome = s3Client.CreateMultipartUpload(createRequest);
+        createSpan.end();
+        while (!createOutcome.IsSuccess() && createRetry.shouldRetry(createOutcome.GetError())) {
+            UploadTraceSpan retrySpan(TRACE_SPAN_CREATE_MULTIPART, progress.get(), 0, createRetry.getRetryCount() + 1);
+            createOutcome = s3Client.CreateMultipartUpload(createRequest);
+        }
+        if (!createOutcome.IsSuccess()) {
+            errorMessage = "CreateMultipartUpload failed: " + String(createOutcome.GetError().GetMessage().c_str());
+            return false;
+        }
+        createRetry.recordSuccess();
+        multipartUploadId = createOutcome.GetResult().GetUploadId().c_str();
+
+        // Record the new upload so it can be resumed after a crash or restart
+        if (!journal.journalPath.empty()) {
+            journal.bucketName = bucketName;
+            journal.objectKey = objectKey;
+            journal.localFilePath = localFilePath;
+            journal.dataId = progress ? progress->dataId : "";
+            journal.multipartUploadId = multipartUploadId;
+            journal.fileSize = fileSize;
+            journal.fileMtime = fileMtime;
+            journal.partSize = partSize;
+            journal.metadata = metadata;
+            if (!saveUploadJournal(journal)) {
+                journal.journalPath.clear();
+            }
+        }
+    }
+
+    // Step 4: Take over parts already stored by a previous run
+    std::vector<Aws::S3::Model::CompletedPart> completedParts(partCount);
+    std::vector<char> partDone(partCount, 0);
+    long long resumedBytes = 0;
+    for (const auto& part : journal.completedParts) {
+        int partIndex = part.first - 1;
+        if (!resumed || partIndex < 0 || partIndex >= partCount) {
+            continue;
+        }
+        completedParts[partIndex].SetPartNumber(part.first);
+        completedParts[partIndex].SetETag(part.second.etag);
+        completedParts[partIndex].SetChecksumCRC32C(part.second.checksumCRC32C);
+        partDone[partIndex] = 1;
+        resumedBytes += std::min(partSize, fileSize - static_cast<long long>(partIndex) * partSize);
+        if (progress) {
+            progress->completedParts++;
+        }
+    }
+    if (progress && resumedBytes > 0) {
+        progress->bytesSent += resumedBytes;
+        progress->markChanged();
+    }
+
+    // Step 5: Upload remaining parts concurrently; workers pull the next part number from a shared counter
+    std::atomic<int> nextPartIndex(0);
+    std::atomic<bool> anyPartFailed(false);
+    std::mutex errorMutex;
+    String firstPartError;
+
+    auto partWorker = [&]() {
+        while (!anyPartFailed.load()) {
+            int partIndex = nextPartIndex++;
+            if (partIndex >= partCount) {
+                return;
+            }
+            if (partDone[partIndex]) {
+                continue;
+            }
+
+            long long offset = static_cast<long long>(partIndex) * partSize;
+            long long length = std::min(partSize, fileSize - offset);
+            String partError;
+            bool partOk = false;
+            try {
+                partOk = uploadSinglePart(s3Client, bucketName, objectKey, multipartUploadId, localFilePath,
+                                          partIndex + 1, offset, length, progress,
+                                          completedParts[partIndex], partError);
+            } catch (const std::exception& e) {
+                partError = formatErrorMessage(ErrorMessage::UPLOAD_EXCEPTION, e.what());
+            } catch (...) {
+                partError = ErrorMessage::UNKNOWN_ERROR;
+            }
+
+            if (!partOk) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!anyPartFailed.exchange(true)) {
+                    firstPartError = partError;
+                }
+                return;
+            }
+            UploadJournalPart journalPart;
+            journalPart.etag = completedParts[partIndex].GetETag().c_str();
+            journalPart.checksumCRC32C = completedParts[partIndex].GetChecksumCRC32C().c_str();
+            appendUploadJournalPart(journal, partIndex + 1, journalPart);
+            if (progress) {
+                progress->completedParts++;
+                progress->markChanged();
+            }
+        }
+    };
+
+    // Up to workerCount-1 helpers come from the shared part pool; a busy pool only lowers
+    // this file's concurrency, as the calling thread takes part in the upload as well
+    int workerCount = std::min(getMultipartConcurrency(), partCount);
+    auto helpers = std::make_shared<PartHelperGroup>();
+    for (int i = 1; i < workerCount; i++) {
+        PartHelperPool::getInstance().submit([helpers, &partWorker]() {
+            {
+                std::lock_guard<std::mutex> lock(helpers->mutex);
+                if (helpers->closed) {
+                    return;
+                }
+                helpers->running++;
+            }
+            partWorker();
+            {
+                std::lock_guard<std::mutex> lock(helpers->mutex);
+                helpers->running--;
+            }
+            helpers->finished.notify_all();
+        });
+    }
+    partWorker();
+    {
+        std::unique_lock<std::mutex> lock(helpers->mutex);
+        helpers->closed = true;
+        helpers->finished.wait(lock, [&helpers] { return helpers->running == 0; });
+    }
+
+    if (anyPartFailed.load()) {
+        errorMessage = firstPartError;
+        // A cancel aborts the upload, except when CleanupAwsSDK stopped it: that stays resumable
+        bool cancelled = progress && progress->shouldCancel.load() && !progress->cancelledForShutdown.load();
+        if (journal.journalPath.empty() || cancelled) {
+            abortMultipartUpload(s3Client, bucketName, objectKey, multipartUploadId);
+            removeUploadJournal(journal);
+        } else {
+            // Keep stored parts; the next upload of this file (or ResumeUploads) continues from here
+            AWS_LOGSTREAM_INFO("S3Upload", "Multipart upload of " << objectKey << " left resumable in journal "
+                               << journal.journalPath);
+        }
+        return false;
+    }
+
+    // Step 6: An upload cancelled while its last parts were sent is aborted, not completed
+    if (progress && progress->shouldCancel.load()) {
+        errorMessage = "Upload cancelled";
+        if (journal.journalPath.empty() || !progress->cancelledForShutdown.load()) {
+            abortMultipartUpload(s3Client, bucketName, objectKey, multipartUploadId);
+            removeUploadJournal(journal);
+        }
+        return false;
+    }
+
+    // Step 7: Complete multipart upload with parts in order
+    Aws::S3::Model::CompletedMultipartUpload completedUpload;
+    completedUpload.SetParts(Aws::Vector<Aws::S3::Model::CompletedPart>(completedParts.begin(), completedParts.end()));
+
+    Aws::S3::Model::CompleteMultipartUploadRequest completeRequest;
+    completeRequest.SetBucket(bucketName);
+    completeRequest.SetKey(objectKey);
+    completeRequest.SetUploadId(multipartUploadId);
+    completeRequest.SetMultipartUpload(completedUpload);
+
+    RetryController retry(progress);
+    CompleteFailure failure = COMPLETE_FAILURE_KEEP;
+    while (true) {
+        UploadTraceSpan completeSpan(TRACE_SPAN_COMPLETE_MULTIPART, progress.get(), 0, retry.getRetryCount() + 1);
+        auto completeOutcome = s3Client.CompleteMultipartUpload(completeRequest);
+        completeSpan.end();
+        if (completeOutcome.IsSuccess()) {
+            retry.recordSuccess();
+            // Composite checksum ("<base64>-<parts>") over the per-part CRC32C values S3 verified
+            checksum = completeOutcome.GetResult().GetChecksumCRC32C().c_str();
+            AWS_LOGSTREAM_INFO("S3Upload", "Multipart upload completed for " << objectKey << " (CRC32C " << checksum << ")");
+            removeUploadJournal(journal);
+            return true;
+        }
+        const auto& error = completeOutcome.GetError();
+        errorMessage = "CompleteMultipartUpload failed: " + String(error.GetMessage().c_str());
+        AWS_LOGSTREAM_WARN("S3Upload", errorMessage);
+
+        // A retry may find the upload gone because an earlier attempt completed it after all
+        if (error.GetErrorType() == Aws::S3::S3Errors::NO_SUCH_UPLOAD) {
+            if (retry.getRetryCount() > 0 &&
+                isMultipartObjectComplete(s3Client, bucketName, objectKey, fileSize, partCount, checksum)) {
+                AWS_LOGSTREAM_INFO("S3Upload", "Multipart upload of " << objectKey << " was completed by an earlier attempt");
+                errorMessage.clear();
+                removeUploadJournal(journal);
+                return true;
+            }
+            failure = COMPLETE_FAILURE_GONE;
+            break;
+        }
+        if (!retry.shouldRetry(error)) {
+            failure = classifyCompleteFailure(error, progress);
+            break;
+        }
+    }
+
+    // Step 8: Only a part list S3 refused is thrown away; on anything else the stored parts
+    // stay for a later attempt or ResumeUploads, like a failed part in Step 5
+    if (failure == COMPLETE_FAILURE_KEEP && !journal.journalPath.empty()) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Multipart upload of " << objectKey << " left resumable in journal "
+                           << journal.journalPath);
+        return false;
+    }
+    if (failure != COMPLETE_FAILURE_GONE) {
+        abortMultipartUpload(s3Client, bucketName, objectKey, multipartUploadId);
+    }
+    removeUploadJournal(journal);
+    return false;
+}
+
+// Configure multipart upload threshold and per-file part concurrency
+// thresholdMB <= 0 keeps the current threshold, partConcurrency <= 0 keeps the current concurrency
+extern "C" S3UPLOAD_API const char* __stdcall ConfigureMultipartUpload(long thresholdMB, long partConcurrency) {
+    static std::string response;
+
+    if (thresholdMB > 0) {
+        g_multipartThreshold = static_cast<long long>(thresholdMB) * 1024 * 1024;
+    }
+    if (partConcurrency > 0) {
+        g_multipartConcurrency = static_cast<int>(std::min<long>(partConcurrency, MAX_MULTIPART_CONCURRENCY));
+    }
+
+    std::ostringstream oss;
+    oss << "Multipart threshold " << g_multipartThreshold.load() << " bytes, "
+        << g_multipartConcurrency.load() << " concurrent parts";
+    response = create_response(UPLOAD_SUCCESS, oss.str());
+    return response.c_str();
+}
@@ -0,0 +1,75 @@
+#ifndef S3MULTIPARTUPLOAD_H
+#define S3MULTIPARTUPLOAD_H
+
+#include "S3Common.h"
+#include "S3UploadJournal.h"
+
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/ListPartsRequest.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
+
+// Multipart upload configuration
+// Files larger than this are split into parts (default 16 MB)
+static const long long DEFAULT_MULTIPART_THRESHOLD = 16LL * 1024 * 1024;
+// Smallest part we will send; S3 rejects non-final parts below 5 MB
+static const long long MIN_MULTIPART_PART_SIZE = 8LL * 1024 * 1024;
+// Largest part S3 accepts
+static const long long MAX_MULTIPART_PART_SIZE = 5LL * 1024 * 1024 * 1024;
+// Maximum number of parts S3 accepts for one object
+static const int MAX_MULTIPART_PARTS = 10000;
+// Number of parts uploaded at the same time for one file
+static const int DEFAULT_MULTIPART_CONCURRENCY = 4;
+// Upper bound for the part concurrency setting
+static const int MAX_MULTIPART_CONCURRENCY = 16;
+// Part threads shared by all multipart uploads of the process
+static const int MAX_MULTIPART_HELPER_THREADS = 16;
+
+// Get the current multipart threshold in bytes
+long long getMultipartThreshold();
+
+// Get the current number of parts uploaded concurrently per file
+int getMultipartConcurrency();
+
+// Check whether a file of the given size should go through the multipart path
+bool shouldUseMultipartUpload(long long fileSize);
+
+// Choose a part size for the given file size
+// Keeps the part count under MAX_MULTIPART_PARTS and parts on a 1 MB boundary
+long long chooseMultipartPartSize(long long fileSize);
+
+// Join the part threads shared by all multipart uploads (CleanupAwsSDK)
+void stopMultipartPartHelpers();
+
+// Upload a file with CreateMultipartUpload / UploadPart / CompleteMultipartUpload
+// Parts are uploaded concurrently, with helper threads from a pool shared by all
+// multipart uploads, and each part is retried on its own.
+// progress may be nullptr (sync uploads); when set, part counters are updated
+// and shouldCancel stops the parts in flight and aborts the upload on S3.
+// When journaling is enabled, completed parts are recorded in an upload journal and a
+// matching journal from an earlier run is resumed instead of starting over.
+// Every part carries a CRC32C trailer that S3 verifies; checksum receives the
+// composite CRC32C of the completed object. metadata is stored on the object
+// (x-amz-meta-*) when the upload is created; a resumed upload keeps what it was created with.
+// Returns true on success, otherwise fills errorMessage. Failed uploads stay on S3 for
+// resuming when journaled; cancelled or unjournaled uploads are aborted.
+bool uploadFileMultipart(const Aws::S3::S3Client& s3Client,
+                         const String& bucketName,
+                         const String& objectKey,
+                         const String& localFilePath,
+                         long long fileSize,
+                         const std::shared_ptr<AsyncUploadProgress>& progress,
+                         const ObjectMetadata& metadata,
+                         String& checksum,
+                         String& errorMessage);
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall ConfigureMultipartUpload(long thresholdMB, long partConcurrency);
+}
+
+// S3MULTIPARTUPLOAD_H
+#endif
@@ -0,0 +1,472 @@
+#ifndef S3PLATFORM_H
+#define S3PLATFORM_H
+
+// Platform layer: the library is written against the Win32 API it ships on.
+// Windows builds include <windows.h>; other platforms (the portable CMake build used by
+// the benchmark suite) get POSIX implementations of the small Win32 subset the library
+// calls, so the upload code itself stays free of platform conditionals.
+
+#include <string>
+#include <cstdlib>
+
+// FILETIME ticks (100 ns since 1601) at the Unix epoch
+static const long long FILETIME_UNIX_EPOCH = 116444736000000000LL;
+
+#ifdef _WIN32
+
+// For Windows API types
+#include <windows.h>
+
+// MinGW compatibility fix: define missing byte order conversion functions
+#ifdef __MINGW32__
+// Define MinGW missing byte order conversion functions
+// Use GCC built-in functions, no need to include intrin.h
+inline unsigned long _byteswap_ulong(unsigned long x) {
+    return __builtin_bswap32(x);
+}
+
+inline unsigned short _byteswap_ushort(unsigned short x) {
+    return __builtin_bswap16(x);
+}
+
+inline unsigned __int64 _byteswap_uint64(unsigned __int64 x) {
+    return __builtin_bswap64(x);
+}
+#endif
+
+// DLL export macro definition
+#ifdef S3UPLOAD_EXPORTS
+#define S3UPLOAD_API __declspec(dllexport)
+#else
+#define S3UPLOAD_API __declspec(dllimport)
+#endif
+
+// Separator used when joining local paths
+static const char PATH_SEPARATOR = '\\';
+
+// Per-user application data directory (%LOCALAPPDATA%); empty if not set
+inline std::string getLocalAppDataDirectory() {
+    const char* localAppData = getenv("LOCALAPPDATA");
+    return localAppData == nullptr ? std::string() : std::string(localAppData);
+}
+
+#else
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// Exported functions use the default calling convention and symbol visibility
+#define __stdcall
+#define S3UPLOAD_API __attribute__((visibility("default")))
+
+// Separator used when joining local paths
+static const char PATH_SEPARATOR = '/';
+
+// Per-user application data directory ($XDG_DATA_HOME, else ~/.local/share); empty if unknown
+inline std::string getLocalAppDataDirectory() {
+    const char* dataHome = getenv("XDG_DATA_HOME");
+    if (dataHome != nullptr && dataHome[0] != '\0') {
+        return dataHome;
+    }
+    const char* home = getenv("HOME");
+    if (home == nullptr || home[0] == '\0') {
+        return "";
+    }
+    return std::string(home) + "/.local/share";
+}
+
+// Win32 types
+typedef int BOOL;
+typedef unsigned int DWORD;
+typedef unsigned short WORD;
+typedef void* HANDLE;
+typedef void* LPVOID;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define MAX_PATH 260
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1)))
+#define INVALID_FILE_ATTRIBUTES (static_cast<DWORD>(-1))
+
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_ACCESS_DENIED 5
+#define ERROR_ALREADY_EXISTS 183
+
+#define FILE_ATTRIBUTE_DIRECTORY 0x10
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_ATTRIBUTE_REPARSE_POINT 0x400
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 0x1
+#define FILE_SHARE_WRITE 0x2
+#define OPEN_EXISTING 3
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x4
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define CP_ACP 0
+#define CP_UTF8 65001
+
+struct FILETIME {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+struct SYSTEMTIME {
+    WORD wYear;
+    WORD wMonth;
+    WORD wDayOfWeek;
+    WORD wDay;
+    WORD wHour;
+    WORD wMinute;
+    WORD wSecond;
+    WORD wMilliseconds;
+};
+
+struct SYSTEM_INFO {
+    DWORD dwPageSize;
+    DWORD dwAllocationGranularity;
+    DWORD dwNumberOfProcessors;
+};
+
+struct WIN32_FIND_DATAA {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+    char cFileName[MAX_PATH];
+};
+
+struct WIN32_FILE_ATTRIBUTE_DATA {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS {
+    GetFileExInfoStandard
+};
+
+namespace S3Posix {
+    // Handle returned by CreateFileA and CreateFileMappingA
+    struct FileHandle {
+        int fd;
+    };
+
+    // State of a FindFirstFileA enumeration
+    struct FindHandle {
+        DIR* dir;
+        std::string directory;
+        std::string mask;
+    };
+
+    // Last error of the calling thread in Win32 terms
+    inline DWORD& lastError() {
+        static thread_local DWORD error = 0;
+        return error;
+    }
+
+    inline void setLastErrorFromErrno() {
+        switch (errno) {
+        case ENOENT:
+        case ENOTDIR:
+            lastError() = ERROR_FILE_NOT_FOUND;
+            break;
+        case EACCES:
+        case EPERM:
+            lastError() = ERROR_ACCESS_DENIED;
+            break;
+        case EEXIST:
+            lastError() = ERROR_ALREADY_EXISTS;
+            break;
+        default:
+            lastError() = static_cast<DWORD>(errno);
+            break;
+        }
+    }
+
+    // Mapped views and their lengths; munmap needs the length UnmapViewOfFile does not pass
+    inline std::mutex& viewMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    inline std::map<void*, size_t>& views() {
+        static std::map<void*, size_t> mappedViews;
+        return mappedViews;
+    }
+
+    inline FILETIME toFileTime(const struct timespec& time) {
+        // 100 ns ticks since 1601, the FILETIME epoch
+        unsigned long long ticks = static_cast<unsigned long long>(time.tv_sec) * 10000000ULL +
+                                   static_cast<unsigned long long>(time.tv_nsec) / 100 +
+                                   static_cast<unsigned long long>(FILETIME_UNIX_EPOCH);
+        FILETIME fileTime;
+        fileTime.dwLowDateTime = static_cast<DWORD>(ticks & 0xFFFFFFFF);
+        fileTime.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+        return fileTime;
+    }
+
+    inline DWORD toAttributes(const struct stat& status) {
+        if (S_ISLNK(status.st_mode)) {
+            return FILE_ATTRIBUTE_REPARSE_POINT;
+        }
+        return S_ISDIR(status.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+    }
+
+    inline void fillAttributeData(const struct stat& status, WIN32_FILE_ATTRIBUTE_DATA* data) {
+        data->dwFileAttributes = toAttributes(status);
+        data->ftCreationTime = toFileTime(status.st_ctim);
+        data->ftLastAccessTime = toFileTime(status.st_atim);
+        data->ftLastWriteTime = toFileTime(status.st_mtim);
+        unsigned long long size = S_ISREG(status.st_mode) ? static_cast<unsigned long long>(status.st_size) : 0;
+        data->nFileSizeHigh = static_cast<DWORD>(size >> 32);
+        data->nFileSizeLow = static_cast<DWORD>(size & 0xFFFFFFFF);
+    }
+
+    // Advance an enumeration to the next entry matching its mask
+    inline BOOL readNextEntry(FindHandle* find, WIN32_FIND_DATAA* findData) {
+        while (struct dirent* entry = readdir(find->dir)) {
+            if (fnmatch(find->mask.c_str(), entry->d_name, 0) != 0) {
+                continue;
+            }
+            struct stat status;
+            if (lstat((find->directory + "/" + entry->d_name).c_str(), &status) != 0) {
+                continue;
+            }
+            WIN32_FILE_ATTRIBUTE_DATA data;
+            fillAttributeData(status, &data);
+            findData->dwFileAttributes = data.dwFileAttributes;
+            findData->ftCreationTime = data.ftCreationTime;
+            findData->ftLastAccessTime = data.ftLastAccessTime;
+            findData->ftLastWriteTime = data.ftLastWriteTime;
+            findData->nFileSizeHigh = data.nFileSizeHigh;
+            findData->nFileSizeLow = data.nFileSizeLow;
+            strncpy(findData->cFileName, entry->d_name, MAX_PATH - 1);
+            findData->cFileName[MAX_PATH - 1] = '\0';
+            return TRUE;
+        }
+        lastError() = ERROR_FILE_NOT_FOUND;
+        return FALSE;
+    }
+}
+
+inline DWORD GetLastError() {
+    return S3Posix::lastError();
+}
+
+inline HANDLE CreateFileA(const char* fileName, DWORD, DWORD, void*, DWORD, DWORD, HANDLE) {
+    int fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        S3Posix::setLastErrorFromErrno();
+        return INVALID_HANDLE_VALUE;
+    }
+    return new S3Posix::FileHandle{fd};
+}
+
+// The mapping handle keeps its own descriptor, like a Win32 mapping outlives its file handle
+inline HANDLE CreateFileMappingA(HANDLE file, void*, DWORD, DWORD, DWORD, const char*) {
+    if (file == nullptr || file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    int fd = dup(static_cast<S3Posix::FileHandle*>(file)->fd);
+    if (fd < 0) {
+        S3Posix::setLastErrorFromErrno();
+        return nullptr;
+    }
+    return new S3Posix::FileHandle{fd};
+}
+
+inline LPVOID MapViewOfFile(HANDLE mapping, DWORD, DWORD offsetHigh, DWORD offsetLow, size_t length) {
+    if (mapping == nullptr || length == 0) {
+        return nullptr;
+    }
+    off_t offset = static_cast<off_t>((static_cast<unsigned long long>(offsetHigh) << 32) | offsetLow);
+    void* view = mmap(nullptr, length, PROT_READ, MAP_SHARED,
+                      static_cast<S3Posix::FileHandle*>(mapping)->fd, offset);
+    if (view == MAP_FAILED) {
+        S3Posix::setLastErrorFromErrno();
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(S3Posix::viewMutex());
+    S3Posix::views()[view] = length;
+    return view;
+}
+
+inline BOOL UnmapViewOfFile(const void* view) {
+    size_t length = 0;
+    {
+        std::lock_guard<std::mutex> lock(S3Posix::viewMutex());
+        auto it = S3Posix::views().find(const_cast<void*>(view));
+        if (it == S3Posix::views().end()) {
+            return FALSE;
+        }
+        length = it->second;
+        S3Posix::views().erase(it);
+    }
+    return munmap(const_cast<void*>(view), length) == 0;
+}
+
+inline BOOL CloseHandle(HANDLE handle) {
+    if (handle == nullptr || handle == INVALID_HANDLE_VALUE) {
+        return FALSE;
+    }
+    S3Posix::FileHandle* file = static_cast<S3Posix::FileHandle*>(handle);
+    int result = close(file->fd);
+    delete file;
+    return result == 0;
+}
+
+// There are no host events outside Windows; completion is observed with WaitForUploadsByDataId
+inline BOOL SetEvent(HANDLE) {
+    return FALSE;
+}
+
+inline void GetSystemInfo(SYSTEM_INFO* systemInfo) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    systemInfo->dwPageSize = static_cast<DWORD>(pageSize > 0 ? pageSize : 4096);
+    systemInfo->dwAllocationGranularity = systemInfo->dwPageSize;
+    systemInfo->dwNumberOfProcessors = static_cast<DWORD>(processors > 0 ? processors : 1);
+}
+
+inline void GetLocalTime(SYSTEMTIME* systemTime) {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    struct tm local;
+    localtime_r(&now.tv_sec, &local);
+    systemTime->wYear = static_cast<WORD>(local.tm_year + 1900);
+    systemTime->wMonth = static_cast<WORD>(local.tm_mon + 1);
+    systemTime->wDayOfWeek = static_cast<WORD>(local.tm_wday);
+    systemTime->wDay = static_cast<WORD>(local.tm_mday);
+    systemTime->wHour = static_cast<WORD>(local.tm_hour);
+    systemTime->wMinute = static_cast<WORD>(local.tm_min);
+    systemTime->wSecond = static_cast<WORD>(local.tm_sec);
+    systemTime->wMilliseconds = static_cast<WORD>(now.tv_usec / 1000);
+}
+
+// pattern is "<directory>/<mask>" with a shell-style mask such as "*" or "*.journal"
+inline HANDLE FindFirstFileA(const char* pattern, WIN32_FIND_DATAA* findData) {
+    std::string path = pattern;
+    size_t separator = path.find_last_of('/');
+    std::string directory = separator == std::string::npos ? "." : path.substr(0, separator);
+    std::string mask = separator == std::string::npos ? path : path.substr(separator + 1);
+    DIR* dir = opendir(directory.empty() ? "/" : directory.c_str());
+    if (dir == nullptr) {
+        S3Posix::setLastErrorFromErrno();
+        return INVALID_HANDLE_VALUE;
+    }
+    S3Posix::FindHandle* find = new S3Posix::FindHandle{dir, directory, mask};
+    if (!S3Posix::readNextEntry(find, findData)) {
+        closedir(dir);
+        delete find;
+        return INVALID_HANDLE_VALUE;
+    }
+    return find;
+}
+
+inline BOOL FindNextFileA(HANDLE findHandle, WIN32_FIND_DATAA* findData) {
+    return S3Posix::readNextEntry(static_cast<S3Posix::FindHandle*>(findHandle), findData);
+}
+
+inline BOOL FindClose(HANDLE findHandle) {
+    S3Posix::FindHandle* find = static_cast<S3Posix::FindHandle*>(findHandle);
+    closedir(find->dir);
+    delete find;
+    return TRUE;
+}
+
+inline DWORD GetFileAttributesA(const char* fileName) {
+    struct stat status;
+    if (stat(fileName, &status) != 0) {
+        S3Posix::setLastErrorFromErrno();
+        return INVALID_FILE_ATTRIBUTES;
+    }
+    return S3Posix::toAttributes(status);
+}
+
+inline BOOL GetFileAttributesExA(const char* fileName, GET_FILEEX_INFO_LEVELS, void* fileInformation) {
+    struct stat status;
+    if (stat(fileName, &status) != 0) {
+        S3Posix::setLastErrorFromErrno();
+        return FALSE;
+    }
+    S3Posix::fillAttributeData(status, static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(fileInformation));
+    return TRUE;
+}
+
+inline BOOL CreateDirectoryA(const char* pathName, void*) {
+    if (mkdir(pathName, 0755) != 0) {
+        S3Posix::setLastErrorFromErrno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+inline BOOL DeleteFileA(const char* fileName) {
+    if (unlink(fileName) != 0) {
+        S3Posix::setLastErrorFromErrno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// rename() always replaces an existing target, which is the only mode the library uses
+inline BOOL MoveFileExA(const char* existingFileName, const char* newFileName, DWORD) {
+    if (rename(existingFileName, newFileName) != 0) {
+        S3Posix::setLastErrorFromErrno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Temp directory with a trailing separator, like the Win32 call
+inline DWORD GetTempPathA(DWORD bufferLength, char* buffer) {
+    const char* tempDir = getenv("TMPDIR");
+    std::string path = tempDir != nullptr && tempDir[0] != '\0' ? tempDir : "/tmp";
+    if (path.back() != '/') {
+        path += '/';
+    }
+    if (path.size() + 1 > bufferLength) {
+        return static_cast<DWORD>(path.size() + 1);
+    }
+    memcpy(buffer, path.c_str(), path.size() + 1);
+    return static_cast<DWORD>(path.size());
+}
+
+inline DWORD GetCurrentProcessId() {
+    return static_cast<DWORD>(getpid());
+}
+
+// Local file names are UTF-8 already; reporting no conversion keeps text unchanged
+inline int MultiByteToWideChar(unsigned int, DWORD, const char*, int, wchar_t*, int) {
+    return 0;
+}
+
+inline int WideCharToMultiByte(unsigned int, DWORD, const wchar_t*, int, char*, int, const char*, BOOL*) {
+    return 0;
+}
+
+#endif
+
+// S3PLATFORM_H
+#endif
@@ -0,0 +1,175 @@
+#include "S3RetryPolicy.h"
+#include "S3UploadTrace.h"
+
+// Pick the backoff before retry number retryNumber + 1 (full jitter, per-thread generator)
+static long long getJitteredBackoffMs(int retryNumber) {
+    static thread_local std::mt19937_64 generator{
+        std::random_device{}() ^ std::hash<std::thread::id>{}(std::this_thread::get_id())};
+
+    long long ceiling = RETRY_BASE_BACKOFF_MS << std::min(retryNumber, 16);
+    ceiling = std::min(ceiling, RETRY_MAX_BACKOFF_MS);
+    std::uniform_int_distribution<long long> distribution(0, ceiling);
+    return distribution(generator);
+}
+
+// Timeouts and dropped connections cost more budget than an explicit throttle response
+static bool isTimeoutError(const Aws::S3::S3Error& error) {
+    return error.GetErrorType() == Aws::S3::S3Errors::REQUEST_TIMEOUT ||
+           error.GetErrorType() == Aws::S3::S3Errors::NETWORK_CONNECTION;
+}
+
+bool isRetryableS3Error(const Aws::S3::S3Error& error) {
+    // Step 1: Error types the SDK maps from throttling, server and transport failures
+    switch (error.GetErrorType()) {
+        case Aws::S3::S3Errors::NETWORK_CONNECTION:
+        case Aws::S3::S3Errors::REQUEST_TIMEOUT:
+        case Aws::S3::S3Errors::SERVICE_UNAVAILABLE:
+        case Aws::S3::S3Errors::SLOW_DOWN:
+        case Aws::S3::S3Errors::THROTTLING:
+        case Aws::S3::S3Errors::INTERNAL_FAILURE:
+            return true;
+        default:
+            break;
+    }
+
+    // Step 2: Without a response the request failed locally or the connection broke;
+    // the SDK marks the transport failures (resets, DNS, TLS) as retryable
+    int responseCode = static_cast<int>(error.GetResponseCode());
+    if (responseCode <= 0) {
+        return error.ShouldRetry();
+    }
+
+    // Step 3: Status codes for errors without a specific type
+    return responseCode == 408 || responseCode == 429 || (responseCode >= 500 && responseCode != 501);
+}
+
+RetryErrorClass getRetryErrorClass(const Aws::S3::S3Error& error) {
+    switch (error.GetErrorType()) {
+        case Aws::S3::S3Errors::SLOW_DOWN:
+        case Aws::S3::S3Errors::THROTTLING:
+            return RETRY_CLASS_THROTTLING;
+        case Aws::S3::S3Errors::REQUEST_TIMEOUT:
+            return RETRY_CLASS_TIMEOUT;
+        case Aws::S3::S3Errors::NETWORK_CONNECTION:
+            return RETRY_CLASS_CONNECTION;
+        default:
+            break;
+    }
+    int responseCode = static_cast<int>(error.GetResponseCode());
+    if (responseCode <= 0) {
+        return RETRY_CLASS_CONNECTION;
+    }
+    if (responseCode == 429) {
+        return RETRY_CLASS_THROTTLING;
+    }
+    return responseCode == 408 ? RETRY_CLASS_TIMEOUT : RETRY_CLASS_SERVER;
+}
+
+UploadErrorCode getUploadErrorCode(const Aws::S3::S3Error& error) {
+    switch (error.GetErrorType()) {
+        case Aws::S3::S3Errors::EXPIRED_TOKEN:
+            return UPLOAD_ERROR_CREDENTIALS_EXPIRED;
+        case Aws::S3::S3Errors::ACCESS_DENIED:
+        case Aws::S3::S3Errors::INVALID_ACCESS_KEY_ID:
+        case Aws::S3::S3Errors::INVALID_CLIENT_TOKEN_ID:
+        case Aws::S3::S3Errors::SIGNATURE_DOES_NOT_MATCH:
+            return UPLOAD_ERROR_ACCESS_DENIED;
+        default:
+            break;
+    }
+    if (isRetryableS3Error(error)) {
+        return UPLOAD_ERROR_NETWORK;
+    }
+    return static_cast<int>(error.GetResponseCode()) == 403 ? UPLOAD_ERROR_ACCESS_DENIED : UPLOAD_ERROR_S3_REJECTED;
+}
+
+RetryBudget& RetryBudget::getInstance() {
+    static RetryBudget instance;
+    return instance;
+}
+
+bool RetryBudget::tryAcquire(int cost) {
+    int available = available_.load();
+    while (available >= cost) {
+        if (available_.compare_exchange_weak(available, available - cost)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RetryBudget::release(int amount) {
+    int available = available_.load();
+    while (available < RETRY_BUDGET_CAPACITY) {
+        int updated = std::min(available + amount, RETRY_BUDGET_CAPACITY);
+        if (available_.compare_exchange_weak(available, updated)) {
+            return;
+        }
+    }
+}
+
+bool RetryController::shouldRetry(const Aws::S3::S3Error& error) {
+    // Step 1: Cancellation, permanent errors and exhausted attempts end the loop
+    // (a request stopped by its continue handler fails without being an S3 error)
+    if (progress_ && progress_->shouldCancel.load()) {
+        return false;
+    }
+    if (!isRetryableS3Error(error)) {
+        AWS_LOGSTREAM_INFO("S3Upload", "Not retrying permanent error: " << error.GetExceptionName()
+                           << " (HTTP " << static_cast<int>(error.GetResponseCode()) << ")");
+        recordFailure(error);
+        return false;
+    }
+    if (attempt_ >= MAX_UPLOAD_RETRIES) {
+        recordFailure(error);
+        return false;
+    }
+
+    // Step 2: Take budget; an empty budget means many requests are failing at once
+    int cost = isTimeoutError(error) ? RETRY_TIMEOUT_COST : RETRY_COST;
+    if (!RetryBudget::getInstance().tryAcquire(cost)) {
+        AWS_LOGSTREAM_WARN("S3Upload", "Retry budget exhausted, not retrying: " << error.GetMessage());
+        UploadMetrics::getInstance().recordRetryBudgetExhausted();
+        recordFailure(error);
+        return false;
+    }
+    lastRetryCost_ = cost;
+    attempt_++;
+
+    // Step 3: Back off with full jitter, waking up to notice cancellation
+    long long backoffMs = getJitteredBackoffMs(attempt_ - 1);
+    AWS_LOGSTREAM_INFO("S3Upload", "Retry " << attempt_ << " of " << MAX_UPLOAD_RETRIES << " in "
+                       << backoffMs << " ms after " << error.GetExceptionName() << ": " << error.GetMessage());
+    UploadMetrics::getInstance().recordRetry(getRetryErrorClass(error), backoffMs);
+    if (progress_) {
+        progress_->retryCount++;
+    }
+
+    UploadTraceSpan backoffSpan(TRACE_SPAN_BACKOFF, progress_.get(), 0, attempt_);
+    auto start = std::chrono::steady_clock::now();
+    long long remainingMs = backoffMs;
+    while (remainingMs > 0) {
+        if (progress_ && progress_->shouldCancel.load()) {
+            break;
+        }
+        long long sliceMs = std::min(remainingMs, RETRY_CANCEL_CHECK_MS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(sliceMs));
+        remainingMs -= sliceMs;
+    }
+    if (progress_) {
+        progress_->backoffMs += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        progress_->markChanged();
+    }
+    return !(progress_ && progress_->shouldCancel.load());
+}
+
+void RetryController::recordFailure(const Aws::S3::S3Error& error) {
+    if (progress_) {
+        progress_->errorCode = getUploadErrorCode(error);
+    }
+}
+
+void RetryController::recordSuccess() {
+    RetryBudget::getInstance().release(attempt_ > 0 ? lastRetryCost_ : 1);
+}
@@ -0,0 +1,87 @@
+#ifndef S3RETRYPOLICY_H
+#define S3RETRYPOLICY_H
+
+#include "S3Common.h"
+#include "S3UploadMetrics.h"
+
+#include <aws/s3/S3Errors.h>
+
+#include <random>
+
+// Retry configuration
+// Backoff before retry n is uniform in [0, min(RETRY_MAX_BACKOFF_MS, RETRY_BASE_BACKOFF_MS * 2^n)]
+static const long long RETRY_BASE_BACKOFF_MS = 500;
+static const long long RETRY_MAX_BACKOFF_MS = 20000;
+// Slice of a backoff sleep between cancellation checks
+static const long long RETRY_CANCEL_CHECK_MS = 100;
+// Process-wide retry budget shared by all uploads (same scheme as the SDK standard retry mode):
+// a retry takes RETRY_COST tokens (RETRY_TIMEOUT_COST after a timeout or reset), a first-attempt
+// success returns one, a retried success returns its cost. An outage drains the budget and
+// further failures fail fast instead of every part of every upload backing off in turn.
+static const int RETRY_BUDGET_CAPACITY = 500;
+static const int RETRY_COST = 5;
+static const int RETRY_TIMEOUT_COST = 10;
+
+// Check whether a failed S3 request may succeed if sent again
+// Throttling (429, 503 SlowDown), 5xx responses, timeouts and connection errors are transient;
+// other 4xx responses (bad request, denied, expired credentials) are not.
+bool isRetryableS3Error(const Aws::S3::S3Error& error);
+
+// Classify a retryable S3 error for the retry counters in GetUploadMetrics
+RetryErrorClass getRetryErrorClass(const Aws::S3::S3Error& error);
+
+// Map a failed S3 request to the error code reported for its upload
+UploadErrorCode getUploadErrorCode(const Aws::S3::S3Error& error);
+
+// Shared token bucket limiting how many retries run across all uploads
+class RetryBudget {
+private:
+    std::atomic<int> available_;
+
+public:
+    RetryBudget() : available_(RETRY_BUDGET_CAPACITY) {}
+
+    // Get singleton instance of the budget
+    static RetryBudget& getInstance();
+
+    // Take cost tokens; returns false (taking nothing) when the budget is short
+    bool tryAcquire(int cost);
+
+    // Return tokens, capped at RETRY_BUDGET_CAPACITY
+    void release(int amount);
+
+    int getAvailable() const { return available_.load(); }
+};
+
+// Drives the attempts of one request
+// Typical loop: send; on success call recordSuccess(); on failure call shouldRetry(), which
+// classifies the error, takes budget, sleeps the jittered backoff and returns whether to send
+// again (the caller rewinds or re-slices the body first). Retries and time spent backing off
+// are added to progress (may be nullptr), as is the error code of a request that gives up.
+class RetryController {
+private:
+    std::shared_ptr<AsyncUploadProgress> progress_;
+    int attempt_;
+    int lastRetryCost_;
+
+    // Record why the request gave up on the upload's progress
+    void recordFailure(const Aws::S3::S3Error& error);
+
+public:
+    explicit RetryController(const std::shared_ptr<AsyncUploadProgress>& progress)
+        : progress_(progress), attempt_(0), lastRetryCost_(0) {}
+
+    // Number of retries made so far (0 during the first attempt)
+    int getRetryCount() const { return attempt_; }
+
+    // Decide about a failed attempt and back off before the next one
+    // Returns false for permanent errors, after MAX_UPLOAD_RETRIES retries, when the
+    // budget is exhausted, or when the upload is cancelled during the backoff
+    bool shouldRetry(const Aws::S3::S3Error& error);
+
+    // Refund budget after a successful attempt
+    void recordSuccess();
+};
+
+// S3RETRYPOLICY_H
+#endif
@@ -0,0 +1,640 @@
+#include "S3UploadBacklog.h"
+#include "S3UploadBundle.h"
+
+size_t BacklogEntry::getFileCount() const {
+    return bundle ? bundle->fileCount : 1;
+}
+
+// Spill record layout: payload size (uint32), then the payload: uploadId, dataId, bucketName,
+// objectKey and localFilePath as length-prefixed strings, priority, sizeHint, queued time
+// (steady clock ticks), credentialsId and bundle id (0 if none). Credentials themselves
+// stay in memory; the file only names their slot in the credential table.
+
+template <typename T>
+static void appendSpillValue(String& record, T value) {
+    record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void appendSpillString(String& record, const String& value) {
+    appendSpillValue(record, static_cast<unsigned int>(value.size()));
+    record.append(value);
+}
+
+template <typename T>
+static bool readSpillValue(const String& record, size_t& offset, T& value) {
+    if (record.size() - offset < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, record.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+static bool readSpillString(const String& record, size_t& offset, String& value) {
+    unsigned int length = 0;
+    if (!readSpillValue(record, offset, length) || record.size() - offset < length) {
+        return false;
+    }
+    value.assign(record.data() + offset, length);
+    offset += length;
+    return true;
+}
+
+// Encode one entry as a spill record
+static void encodeSpillRecord(const BacklogEntry& entry, unsigned long long bundleId, String& record) {
+    record.assign(sizeof(unsigned int), '\0');
+    appendSpillString(record, entry.uploadId);
+    appendSpillString(record, entry.dataId);
+    appendSpillString(record, entry.bucketName);
+    appendSpillString(record, entry.objectKey);
+    appendSpillString(record, entry.localFilePath);
+    appendSpillValue(record, entry.priority);
+    appendSpillValue(record, entry.sizeHint);
+    appendSpillValue(record, static_cast<long long>(entry.queuedTime.time_since_epoch().count()));
+    appendSpillValue(record, entry.credentialsId);
+    appendSpillValue(record, bundleId);
+    unsigned int payloadSize = static_cast<unsigned int>(record.size() - sizeof(unsigned int));
+    memcpy(&record[0], &payloadSize, sizeof(payloadSize));
+}
+
+// Read the next spill record from file; returns false on a short read or a malformed record
+static bool readSpillRecord(std::fstream& file, String& record, BacklogEntry& entry, unsigned long long& bundleId) {
+    unsigned int payloadSize = 0;
+    if (!file.read(reinterpret_cast<char*>(&payloadSize), sizeof(payloadSize))) {
+        return false;
+    }
+    record.resize(payloadSize);
+    if (payloadSize > 0 && !file.read(&record[0], payloadSize)) {
+        return false;
+    }
+
+    size_t offset = 0;
+    long long queuedTicks = 0;
+    if (!readSpillString(record, offset, entry.uploadId) ||
+        !readSpillString(record, offset, entry.dataId) ||
+        !readSpillString(record, offset, entry.bucketName) ||
+        !readSpillString(record, offset, entry.objectKey) ||
+        !readSpillString(record, offset, entry.localFilePath) ||
+        !readSpillValue(record, offset, entry.priority) ||
+        !readSpillValue(record, offset, entry.sizeHint) ||
+        !readSpillValue(record, offset, queuedTicks) ||
+        !readSpillValue(record, offset, entry.credentialsId) ||
+        !readSpillValue(record, offset, bundleId)) {
+        return false;
+    }
+    entry.queuedTime = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(queuedTicks));
+    return true;
+}
+
+// System temp directory without its trailing separator ("" if unknown)
+static String getBacklogTempDirectory() {
+    char buffer[MAX_PATH + 1];
+    DWORD length = GetTempPathA(sizeof(buffer), buffer);
+    if (length == 0 || length > MAX_PATH) {
+        return "";
+    }
+    String directory(buffer, length);
+    while (!directory.empty() && (directory.back() == '\\' || directory.back() == '/')) {
+        directory.pop_back();
+    }
+    return directory;
+}
+
+UploadBacklog::UploadBacklog()
+    : memoryEntries_(0), spilledEntries_(0), maxMemoryEntries_(DEFAULT_BACKLOG_MEMORY_ENTRIES) {}
+
+UploadBacklog::~UploadBacklog() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& level : queues_) {
+        closeSpillFileLocked(level.second);
+    }
+}
+
+UploadBacklog& UploadBacklog::getInstance() {
+    static UploadBacklog instance;
+    return instance;
+}
+
+unsigned int UploadBacklog::acquireCredentialsLocked(const AsyncUploadJob& job) {
+    String key = job.accessKey + "\n" + job.region + "\n" + job.sessionToken + "\n" + job.secretKey;
+    auto it = credentialIds_.find(key);
+    if (it != credentialIds_.end()) {
+        credentials_[it->second].references++;
+        return it->second;
+    }
+
+    unsigned int credentialsId;
+    if (!freeCredentialIds_.empty()) {
+        credentialsId = freeCredentialIds_.back();
+        freeCredentialIds_.pop_back();
+    } else {
+        credentialsId = static_cast<unsigned int>(credentials_.size());
+        credentials_.push_back(Credentials());
+    }
+    Credentials& credentials = credentials_[credentialsId];
+    credentials.accessKey = job.accessKey;
+    credentials.secretKey = job.secretKey;
+    credentials.sessionToken = job.sessionToken;
+    credentials.region = job.region;
+    credentials.references = 1;
+    credentialIds_[key] = credentialsId;
+    return credentialsId;
+}
+
+void UploadBacklog::releaseCredentialsLocked(unsigned int credentialsId) {
+    if (credentialsId >= credentials_.size() || credentials_[credentialsId].references == 0) {
+        return;
+    }
+    Credentials& credentials = credentials_[credentialsId];
+    if (--credentials.references > 0) {
+        return;
+    }
+    credentialIds_.erase(credentials.accessKey + "\n" + credentials.region + "\n" +
+                         credentials.sessionToken + "\n" + credentials.secretKey);
+    credentials = Credentials();
+    credentials.references = 0;
+    freeCredentialIds_.push_back(credentialsId);
+}
+
+bool UploadBacklog::spillLocked(int priority, PriorityQueue& queue, BacklogEntry& entry) {
+    // Step 1: Create the queue's spill file on first use
+    if (!queue.spillFile.is_open()) {
+        String directory = spillDirectory_.empty() ? getBacklogTempDirectory() : spillDirectory_;
+        if (directory.empty()) {
+            return false;
+        }
+        String path = directory + PATH_SEPARATOR + BACKLOG_SPILL_PREFIX + std::to_string(GetCurrentProcessId()) +
+                      "_" + std::to_string(priority - MIN_UPLOAD_PRIORITY) + ".tmp";
+        queue.spillFile.open(path.c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!queue.spillFile.is_open()) {
+            AWS_LOGSTREAM_WARN("S3Upload", "Cannot create backlog spill file " << path << ", keeping uploads in memory");
+            return false;
+        }
+        queue.spillPath = path;
+        queue.readOffset = 0;
+        queue.writeOffset = 0;
+    }
+
+    // Step 2: Bundles stay in memory; the record refers to them by id
+    unsigned long long bundleId = 0;
+    if (entry.bundle) {
+        bundleId = queue.nextBundleId++;
+        queue.spilledBundles[bundleId] = entry.bundle;
+    }
+
+    // Step 3: Append the record after the last complete one (a failed write is overwritten next time)
+    static thread_local String record;
+    encodeSpillRecord(entry, bundleId, record);
+    queue.spillFile.seekp(queue.writeOffset);
+    queue.spillFile.write(record.data(), record.size());
+    if (!queue.spillFile) {
+        queue.spillFile.clear();
+        queue.spilledBundles.erase(bundleId);
+        AWS_LOGSTREAM_WARN("S3Upload", "Cannot write backlog spill file " << queue.spillPath << ", keeping upload in memory");
+        return false;
+    }
+    queue.writeOffset += static_cast<long long>(record.size());
+    queue.spilledCount++;
+    queue.spilledByDataId[entry.dataId].add(entry);
+    queue.spilledUploadIds[entry.uploadId] = entry.dataId;
+    spilledEntries_++;
+    return true;
+}
+
+void UploadBacklog::refillLocked(PriorityQueue& queue, std::unordered_map<String, BacklogTotals>& lostUploads) {
+    // Step 1: Position on the first unread record (this also ends the pending writes)
+    queue.spillFile.clear();
+    queue.spillFile.seekg(queue.readOffset);
+
+    static thread_local String record;
+    for (size_t i = 0; i < BACKLOG_REFILL_ENTRIES && queue.spilledCount > 0; i++) {
+        // Step 2: Give the file up if it cannot be read; its uploads are reported as failed
+        BacklogEntry entry;
+        unsigned long long bundleId = 0;
+        if (!readSpillRecord(queue.spillFile, record, entry, bundleId)) {
+            AWS_LOGSTREAM_ERROR("S3Upload", "Cannot read backlog spill file " << queue.spillPath << ", failing "
+                                << queue.spilledCount << " backlogged upload(s)");
+            for (const auto& spilled : queue.spilledByDataId) {
+                BacklogTotals remaining = spilled.second;
+                auto discardedIt = queue.discardedByDataId.find(spilled.first);
+                if (discardedIt != queue.discardedByDataId.end()) {
+                    remaining.subtract(discardedIt->second);
+                }
+                if (remaining.uploadCount > 0) {
+                    BacklogTotals& lost = lostUploads[spilled.first];
+                    lost.uploadCount += remaining.uploadCount;
+                    lost.totalSize += remaining.totalSize;
+                    lost.fileCount += remaining.fileCount;
+                }
+            }
+            // Credential references of the unread records cannot be released
+            for (const auto& spilledId : queue.spilledUploadIds) {
+                cancelledUploadIds_.erase(spilledId.first);
+            }
+            spilledEntries_ -= queue.spilledCount;
+            queue.spilledCount = 0;
+            break;
+        }
+        queue.readOffset = static_cast<long long>(queue.spillFile.tellg());
+        queue.spilledCount--;
+        spilledEntries_--;
+        queue.spilledUploadIds.erase(entry.uploadId);
+
+        // Step 3: Reattach the bundle and update the per-dataId counts
+        if (bundleId != 0) {
+            auto bundleIt = queue.spilledBundles.find(bundleId);
+            if (bundleIt != queue.spilledBundles.end()) {
+                entry.bundle = bundleIt->second;
+                queue.spilledBundles.erase(bundleIt);
+            }
+        }
+        auto totalsIt = queue.spilledByDataId.find(entry.dataId);
+        if (totalsIt != queue.spilledByDataId.end()) {
+            totalsIt->second.remove(entry);
+            if (totalsIt->second.uploadCount == 0) {
+                queue.spilledByDataId.erase(totalsIt);
+            }
+        }
+
+        // Step 4: Drop entries of dataIds cleaned up or cancelled while they were on disk
+        auto discardedIt = queue.discardedByDataId.find(entry.dataId);
+        if (discardedIt != queue.discardedByDataId.end()) {
+            discardedIt->second.remove(entry);
+            if (discardedIt->second.uploadCount == 0) {
+                queue.discardedByDataId.erase(discardedIt);
+            }
+            cancelledUploadIds_.erase(entry.uploadId);
+            releaseCredentialsLocked(entry.credentialsId);
+            continue;
+        }
+
+        // Step 5: Entries cancelled by ID while on disk are reported instead of queued
+        if (!cancelledUploadIds_.empty() && cancelledUploadIds_.erase(entry.uploadId) > 0) {
+            releaseCredentialsLocked(entry.credentialsId);
+            cancelledEntries_.push_back(std::move(entry));
+            continue;
+        }
+        queue.entries.push_back(std::move(entry));
+        memoryEntries_++;
+    }
+
+    if (queue.spilledCount == 0) {
+        closeSpillFileLocked(queue);
+    }
+}
+
+void UploadBacklog::forgetSpilledUploadIdsLocked(PriorityQueue& queue, const String& dataId) {
+    for (auto it = queue.spilledUploadIds.begin(); it != queue.spilledUploadIds.end();) {
+        if (it->second == dataId) {
+            cancelledUploadIds_.erase(it->first);
+            it = queue.spilledUploadIds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void UploadBacklog::closeSpillFileLocked(PriorityQueue& queue) {
+    if (queue.spillFile.is_open()) {
+        queue.spillFile.close();
+    }
+    queue.spillFile.clear();
+    if (!queue.spillPath.empty()) {
+        DeleteFileA(queue.spillPath.c_str());
+        queue.spillPath.clear();
+    }
+    queue.readOffset = 0;
+    queue.writeOffset = 0;
+    queue.spilledCount = 0;
+    queue.spilledBundles.clear();
+    queue.spilledByDataId.clear();
+    queue.discardedByDataId.clear();
+    queue.spilledUploadIds.clear();
+}
+
+bool UploadBacklog::popLocked(BacklogEntry& entry, std::unordered_map<String, BacklogTotals>& lostUploads) {
+    auto it = queues_.begin();
+    while (it != queues_.end()) {
+        PriorityQueue& queue = it->second;
+        // Each refill reads at least one record or gives the file up, so this ends
+        if (queue.entries.empty() && queue.spilledCount > 0) {
+            refillLocked(queue, lostUploads);
+            continue;
+        }
+        if (!queue.entries.empty()) {
+            entry = std::move(queue.entries.front());
+            queue.entries.pop_front();
+            memoryEntries_--;
+            return true;
+        }
+        closeSpillFileLocked(queue);
+        it = queues_.erase(it);
+    }
+    return false;
+}
+
+void UploadBacklog::failLostUploads(const std::unordered_map<String, BacklogTotals>& lostUploads) {
+    auto& manager = AsyncUploadManager::getInstance();
+    for (const auto& lost : lostUploads) {
+        manager.finishBackloggedUploads(lost.first, lost.second.uploadCount, lost.second.totalSize,
+                                        lost.second.fileCount, UPLOAD_FAILED, "Backlog spill file could not be read");
+    }
+}
+
+void UploadBacklog::reportCancelledEntries(const std::vector<BacklogEntry>& entries) {
+    auto& manager = AsyncUploadManager::getInstance();
+    for (const auto& entry : entries) {
+        if (manager.admitBackloggedUpload(entry.uploadId, entry.dataId, entry.localFilePath, entry.objectKey,
+                                          entry.bucketName, entry.bundle, entry.sizeHint,
+                                          entry.getFileCount(), entry.queuedTime)) {
+            manager.setTotalSize(entry.uploadId, std::max(0LL, entry.sizeHint));
+            manager.updateProgress(entry.uploadId, UPLOAD_CANCELLED);
+        }
+    }
+}
+
+bool UploadBacklog::submit(const AsyncUploadJob& job, long long knownSize, String& errorMessage) {
+    // Step 1: Refuse work the pool could never run
+    if (!UploadWorkerPool::getInstance().isRunning()) {
+        errorMessage = "Upload worker pool is not running";
+        return false;
+    }
+
+    // Step 2: Count the upload as pending in its dataId before admit() can see it
+    BacklogEntry entry;
+    entry.uploadId = job.uploadId;
+    entry.dataId = job.dataId;
+    entry.bucketName = job.bucketName;
+    entry.objectKey = job.objectKey;
+    entry.localFilePath = job.localFilePath;
+    entry.priority = job.priority;
+    entry.sizeHint = knownSize;
+    entry.queuedTime = std::chrono::steady_clock::now();
+    entry.bundle = job.bundle;
+    AsyncUploadManager::getInstance().addBackloggedUpload(job.dataId, knownSize, entry.getFileCount());
+
+    // Step 3: Keep it in memory, or spill it once memory is full; a queue that has
+    // spilled keeps spilling until it drains so the order within the priority holds
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry.credentialsId = acquireCredentialsLocked(job);
+        PriorityQueue& queue = queues_[job.priority];
+        bool spilled = (queue.spilledCount > 0 || memoryEntries_ >= maxMemoryEntries_) &&
+                       spillLocked(job.priority, queue, entry);
+        if (!spilled) {
+            queue.entries.push_back(std::move(entry));
+            memoryEntries_++;
+        }
+    }
+
+    // Step 4: Start it right away when fewer than MAX_UPLOAD_LIMIT uploads are active
+    admit();
+    return true;
+}
+
+void UploadBacklog::admit() {
+    auto& manager = AsyncUploadManager::getInstance();
+    auto& pool = UploadWorkerPool::getInstance();
+    std::unordered_map<String, BacklogTotals> lostUploads;
+    std::vector<String> unqueuedUploads;
+    std::vector<BacklogEntry> cancelledEntries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Step 1: Leave everything backlogged while the pool is stopped (takeAll collects it)
+        if (!pool.isRunning()) {
+            return;
+        }
+
+        // Step 2: Register and queue uploads until the active limit is reached
+        BacklogEntry entry;
+        while (manager.getTotalUploads() < MAX_UPLOAD_LIMIT && popLocked(entry, lostUploads)) {
+            const Credentials& credentials = credentials_[entry.credentialsId];
+            AsyncUploadJob job;
+            job.uploadId = entry.uploadId;
+            job.accessKey = credentials.accessKey;
+            job.secretKey = credentials.secretKey;
+            job.sessionToken = credentials.sessionToken;
+            job.region = credentials.region;
+            job.bucketName = entry.bucketName;
+            job.objectKey = entry.objectKey;
+            job.localFilePath = entry.localFilePath;
+            job.dataId = entry.dataId;
+            job.priority = entry.priority;
+            job.sizeHint = entry.sizeHint;
+            job.bundle = entry.bundle;
+            releaseCredentialsLocked(entry.credentialsId);
+
+            // A dataId cleaned up while the upload waited no longer expects it
+            auto progress = manager.admitBackloggedUpload(entry.uploadId, entry.dataId, entry.localFilePath,
+                                                          entry.objectKey, entry.bucketName, entry.bundle,
+                                                          entry.sizeHint, entry.getFileCount(), entry.queuedTime);
+            if (!progress) {
+                continue;
+            }
+            if (entry.sizeHint >= 0) {
+                manager.setTotalSize(entry.uploadId, entry.sizeHint);
+            }
+            if (!pool.submit(job)) {
+                unqueuedUploads.push_back(entry.uploadId);
+                break;
+            }
+        }
+        cancelledEntries.swap(cancelledEntries_);
+    }
+
+    // Step 3: Report failures and cancellations outside the lock (a status change calls back into admit)
+    failLostUploads(lostUploads);
+    for (const auto& uploadId : unqueuedUploads) {
+        manager.updateProgress(uploadId, UPLOAD_FAILED, "Upload worker pool is not running", UPLOAD_ERROR_INTERNAL);
+    }
+    reportCancelledEntries(cancelledEntries);
+}
+
+void UploadBacklog::discardDataId(const String& dataId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& level : queues_) {
+        PriorityQueue& queue = level.second;
+
+        // Step 1: Drop the entries in memory
+        auto& entries = queue.entries;
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->dataId == dataId) {
+                releaseCredentialsLocked(it->credentialsId);
+                it = entries.erase(it);
+                memoryEntries_--;
+            } else {
+                ++it;
+            }
+        }
+
+        // Step 2: Spilled entries are dropped when they are read back
+        auto totalsIt = queue.spilledByDataId.find(dataId);
+        if (totalsIt != queue.spilledByDataId.end()) {
+            queue.discardedByDataId[dataId] = totalsIt->second;
+            forgetSpilledUploadIdsLocked(queue, dataId);
+        }
+    }
+}
+
+bool UploadBacklog::cancelUpload(const String& uploadId) {
+    std::vector<BacklogEntry> cancelled;
+    bool spilled = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Step 1: Take the entry out of memory
+        for (auto& level : queues_) {
+            auto& entries = level.second.entries;
+            auto it = std::find_if(entries.begin(), entries.end(), [&uploadId](const BacklogEntry& entry) {
+                return entry.uploadId == uploadId;
+            });
+            if (it != entries.end()) {
+                releaseCredentialsLocked(it->credentialsId);
+                cancelled.push_back(std::move(*it));
+                entries.erase(it);
+                memoryEntries_--;
+                break;
+            }
+        }
+
+        // Step 2: Otherwise a spilled one is reported when its record is read back
+        if (cancelled.empty()) {
+            for (const auto& level : queues_) {
+                if (level.second.spilledUploadIds.count(uploadId) > 0) {
+                    spilled = cancelledUploadIds_.insert(uploadId).second;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Step 3: Report it outside the lock (a status change calls back into admit)
+    reportCancelledEntries(cancelled);
+    return spilled || !cancelled.empty();
+}
+
+size_t UploadBacklog::cancelDataId(const String& dataId) {
+    std::vector<BacklogEntry> cancelled;
+    BacklogTotals spilled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& level : queues_) {
+            PriorityQueue& queue = level.second;
+
+            // Step 1: Take the entries out of memory
+            auto& entries = queue.entries;
+            for (auto it = entries.begin(); it != entries.end();) {
+                if (it->dataId == dataId) {
+                    releaseCredentialsLocked(it->credentialsId);
+                    cancelled.push_back(std::move(*it));
+                    it = entries.erase(it);
+                    memoryEntries_--;
+                } else {
+                    ++it;
+                }
+            }
+
+            // Step 2: Spilled entries not already dropped are counted now and dropped when read back
+            auto totalsIt = queue.spilledByDataId.find(dataId);
+            if (totalsIt != queue.spilledByDataId.end()) {
+                BacklogTotals& discarded = queue.discardedByDataId[dataId];
+                BacklogTotals remaining = totalsIt->second;
+                remaining.subtract(discarded);
+                spilled.uploadCount += remaining.uploadCount;
+                spilled.totalSize += remaining.totalSize;
+                spilled.fileCount += remaining.fileCount;
+                discarded = totalsIt->second;
+                forgetSpilledUploadIdsLocked(queue, dataId);
+            }
+        }
+    }
+
+    // Step 3: Report them outside the lock (a status change calls back into admit)
+    reportCancelledEntries(cancelled);
+    if (spilled.uploadCount > 0) {
+        AsyncUploadManager::getInstance().finishBackloggedUploads(dataId, spilled.uploadCount, spilled.totalSize,
+                                                                  spilled.fileCount, UPLOAD_CANCELLED);
+    }
+    return cancelled.size() + spilled.uploadCount;
+}
+
+std::vector<BacklogEntry> UploadBacklog::takeAll() {
+    std::vector<BacklogEntry> entries;
+    std::vector<BacklogEntry> cancelledEntries;
+    std::unordered_map<String, BacklogTotals> lostUploads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        BacklogEntry entry;
+        while (popLocked(entry, lostUploads)) {
+            releaseCredentialsLocked(entry.credentialsId);
+            entries.push_back(std::move(entry));
+        }
+        cancelledEntries.swap(cancelledEntries_);
+    }
+    failLostUploads(lostUploads);
+    reportCancelledEntries(cancelledEntries);
+    return entries;
+}
+
+void UploadBacklog::configure(size_t maxMemoryEntries, const char* spillDirectory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (maxMemoryEntries > 0) {
+        maxMemoryEntries_ = std::min(maxMemoryEntries, MAX_BACKLOG_MEMORY_ENTRIES);
+    }
+    if (spillDirectory) {
+        spillDirectory_ = spillDirectory;
+        while (!spillDirectory_.empty() && (spillDirectory_.back() == '\\' || spillDirectory_.back() == '/')) {
+            spillDirectory_.pop_back();
+        }
+    }
+}
+
+void UploadBacklog::getConfiguration(size_t& maxMemoryEntries, String& spillDirectory) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxMemoryEntries = maxMemoryEntries_;
+    spillDirectory = spillDirectory_.empty() ? getBacklogTempDirectory() : spillDirectory_;
+}
+
+void UploadBacklog::getSizes(size_t& memoryEntries, size_t& spilledEntries) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memoryEntries = memoryEntries_;
+    spilledEntries = spilledEntries_;
+}
+
+// Start backlogged uploads once an active upload finishes (called by AsyncUploadManager)
+void admitBackloggedUploads() {
+    UploadBacklog::getInstance().admit();
+}
+
+// Configure the async submission backlog
+// Submissions beyond MAX_UPLOAD_LIMIT active uploads wait in the backlog; the first
+// maxMemoryEntries stay in memory and the rest spill to files in spillDirectory.
+// maxMemoryEntries <= 0 keeps the current limit (default 10000); spillDirectory NULL keeps
+// the current directory, "" uses the system temp directory (the default).
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadBacklog(long maxMemoryEntries, const char* spillDirectory) {
+    static std::string response;
+
+    try {
+        // Step 1: Make sure a configured spill directory exists
+        if (spillDirectory && spillDirectory[0] != '\0' && !createDirectories(spillDirectory)) {
+            response = create_response(UPLOAD_FAILED, formatErrorMessage("Cannot create backlog spill directory", spillDirectory));
+            return response.c_str();
+        }
+
+        // Step 2: Apply the settings and report the ones in effect
+        auto& backlog = UploadBacklog::getInstance();
+        backlog.configure(maxMemoryEntries > 0 ? static_cast<size_t>(maxMemoryEntries) : 0, spillDirectory);
+
+        size_t memoryLimit = 0;
+        String directory;
+        backlog.getConfiguration(memoryLimit, directory);
+        response = create_response(UPLOAD_SUCCESS, "Upload backlog keeps " + std::to_string(memoryLimit) +
+                                   " uploads in memory and spills the rest to " + directory);
+    }
+    catch (const std::exception& e) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to configure upload backlog", e.what()));
+    }
+    catch (...) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to configure upload backlog", ErrorMessage::UNKNOWN_ERROR));
+    }
+    return response.c_str();
+}
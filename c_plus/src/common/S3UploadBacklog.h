@@ -0,0 +1,196 @@
+#ifndef S3UPLOADBACKLOG_H
+#define S3UPLOADBACKLOG_H
+
+#include "S3UploadWorkerPool.h"
+
+// Backlogged uploads kept in memory before new ones spill to disk (default)
+static const size_t DEFAULT_BACKLOG_MEMORY_ENTRIES = 10000;
+// Upper bound for the in-memory backlog setting
+static const size_t MAX_BACKLOG_MEMORY_ENTRIES = 1000000;
+// Spilled uploads read back into memory at a time
+static const size_t BACKLOG_REFILL_ENTRIES = 256;
+// Spill files are named <prefix><process id>_<priority>.tmp in the spill directory
+static const String BACKLOG_SPILL_PREFIX = "s3upload_backlog_";
+
+// Upload accepted but not yet registered with AsyncUploadManager
+// Credentials are shared by id so repeated submissions store them once.
+struct BacklogEntry {
+    String uploadId;
+    String dataId;
+    String bucketName;
+    String objectKey;
+    String localFilePath;
+    int priority;
+    // Size known at submission (-1 if unknown)
+    long long sizeHint;
+    // When the upload was submitted; its queue wait starts here
+    std::chrono::steady_clock::time_point queuedTime;
+    // Index into UploadBacklog's credential table
+    unsigned int credentialsId;
+    // Small files uploaded as one tar bundle; localFilePath is then the folder
+    std::shared_ptr<const UploadBundle> bundle;
+
+    BacklogEntry() : priority(DEFAULT_UPLOAD_PRIORITY), sizeHint(-1), credentialsId(0) {}
+
+    // Files this upload carries (each bundled file counts)
+    size_t getFileCount() const;
+};
+
+// Backlogged uploads of one dataId counted together, as AsyncUploadManager reports them
+struct BacklogTotals {
+    size_t uploadCount;
+    // Sum of the known sizes
+    long long totalSize;
+    size_t fileCount;
+
+    BacklogTotals() : uploadCount(0), totalSize(0), fileCount(0) {}
+
+    void add(const BacklogEntry& entry) {
+        uploadCount++;
+        totalSize += std::max(0LL, entry.sizeHint);
+        fileCount += entry.getFileCount();
+    }
+
+    void remove(const BacklogEntry& entry) {
+        uploadCount--;
+        totalSize -= std::max(0LL, entry.sizeHint);
+        fileCount -= std::min(entry.getFileCount(), fileCount);
+    }
+
+    // Remove totals counted in other as well (a subset of these)
+    void subtract(const BacklogTotals& other) {
+        uploadCount -= std::min(other.uploadCount, uploadCount);
+        totalSize -= std::min(other.totalSize, totalSize);
+        fileCount -= std::min(other.fileCount, fileCount);
+    }
+};
+
+// Submission backlog in front of the worker pool - thread-safe singleton
+// Every async submission is accepted here in O(1). Uploads are registered with
+// AsyncUploadManager and queued on the worker pool while fewer than MAX_UPLOAD_LIMIT
+// are active; the rest wait here, highest priority first, FIFO within a priority.
+// Each priority keeps the front of its queue in memory. Once the in-memory limit is
+// reached, new entries are appended to a spill file and read back in chunks as the
+// front drains. Spill files never hold credentials and are deleted once read.
+class UploadBacklog {
+private:
+    // Backlog of one priority: entries in memory, then spilled entries in file order
+    struct PriorityQueue {
+        std::deque<BacklogEntry> entries;
+        String spillPath;                      // Empty until the first entry spills
+        std::fstream spillFile;
+        long long readOffset;                  // Next spilled record to read back
+        long long writeOffset;                 // End of the last complete record
+        size_t spilledCount;                   // Records between readOffset and the end of the file
+        unsigned long long nextBundleId;
+        std::unordered_map<unsigned long long, std::shared_ptr<const UploadBundle>> spilledBundles;  // Bundles of spilled entries
+        std::unordered_map<String, BacklogTotals> spilledByDataId;  // Spilled uploads per dataId
+        std::unordered_map<String, BacklogTotals> discardedByDataId;  // Spilled uploads of cleaned-up or cancelled dataIds to drop when read
+        std::unordered_map<String, String> spilledUploadIds;  // Upload ID to dataId of spilled uploads still to be started
+
+        PriorityQueue() : readOffset(0), writeOffset(0), spilledCount(0), nextBundleId(1) {}
+    };
+
+    // Credentials of backlogged uploads, kept in memory only
+    struct Credentials {
+        String accessKey;
+        String secretKey;
+        String sessionToken;
+        String region;
+        size_t references;
+    };
+
+    typedef std::map<int, PriorityQueue, std::greater<int>> PriorityQueues;
+
+    mutable std::mutex mutex_;                  // Protects all members below
+    PriorityQueues queues_;                     // Backlog by priority, highest first
+    std::vector<Credentials> credentials_;      // Credential table, indexed by BacklogEntry::credentialsId
+    std::unordered_map<String, unsigned int> credentialIds_;  // Credential key to index in credentials_
+    std::vector<unsigned int> freeCredentialIds_;  // Unused slots of credentials_
+    size_t memoryEntries_;                      // Entries held in memory across all priorities
+    size_t spilledEntries_;                     // Entries held in spill files across all priorities
+    size_t maxMemoryEntries_;                   // In-memory limit before entries spill
+    String spillDirectory_;                     // Directory of spill files (empty: system temp directory)
+    std::unordered_set<String> cancelledUploadIds_;  // Spilled uploads cancelled by ID, reported when read back
+    std::vector<BacklogEntry> cancelledEntries_;    // Cancelled uploads read back, reported by admit() or takeAll()
+
+    // Get the credential id for a job's credentials, adding a reference (mutex_ must be held)
+    unsigned int acquireCredentialsLocked(const AsyncUploadJob& job);
+
+    // Drop one reference to credentials (mutex_ must be held)
+    void releaseCredentialsLocked(unsigned int credentialsId);
+
+    // Append an entry to the spill file of a queue; returns false on I/O errors (mutex_ must be held)
+    bool spillLocked(int priority, PriorityQueue& queue, BacklogEntry& entry);
+
+    // Read up to BACKLOG_REFILL_ENTRIES spilled entries back into memory (mutex_ must be held)
+    // Entries of cleaned-up dataIds are dropped; if the file cannot be read its remaining
+    // uploads are added to lostUploads and the file is given up.
+    void refillLocked(PriorityQueue& queue, std::unordered_map<String, BacklogTotals>& lostUploads);
+
+    // Drop a dataId's uploads from the spilled-ID index once they are discarded as a whole
+    // (mutex_ must be held)
+    void forgetSpilledUploadIdsLocked(PriorityQueue& queue, const String& dataId);
+
+    // Close and delete the spill file of a queue (mutex_ must be held)
+    void closeSpillFileLocked(PriorityQueue& queue);
+
+    // Take the next entry, highest priority first (mutex_ must be held)
+    bool popLocked(BacklogEntry& entry, std::unordered_map<String, BacklogTotals>& lostUploads);
+
+    // Report uploads whose spill file was lost as failed (outside mutex_)
+    static void failLostUploads(const std::unordered_map<String, BacklogTotals>& lostUploads);
+
+    // Register cancelled uploads only to report them as cancelled (outside mutex_)
+    static void reportCancelledEntries(const std::vector<BacklogEntry>& entries);
+
+public:
+    UploadBacklog();
+    ~UploadBacklog();
+
+    // Get singleton instance of the backlog
+    static UploadBacklog& getInstance();
+
+    // Accept a job whose uploadId is already set, then start it right away if there is room
+    // knownSize (if >= 0) is reported in the dataId totals until the upload starts.
+    // Returns false if the worker pool is not running.
+    bool submit(const AsyncUploadJob& job, long long knownSize, String& errorMessage);
+
+    // Register and queue backlogged uploads while fewer than MAX_UPLOAD_LIMIT are active
+    void admit();
+
+    // Drop every backlogged upload of a dataId (CleanupUploadsByDataId)
+    void discardDataId(const String& dataId);
+
+    // Cancel one backlogged upload (CancelUpload); it is reported as cancelled without starting
+    // An upload in memory is reported right away, a spilled one once its record is read back.
+    // Returns false if the upload is not backlogged or already cancelled.
+    bool cancelUpload(const String& uploadId);
+
+    // Cancel every backlogged upload of a dataId (CancelUploadsByDataId)
+    // Uploads in memory are reported cancelled with a record each; spilled ones are counted
+    // as cancelled in the dataId right away and dropped when read back.
+    // Returns the number of uploads cancelled.
+    size_t cancelDataId(const String& dataId);
+
+    // Remove and return every backlogged upload, deleting the spill files
+    // Used when the SDK is cleaned up so the caller can mark them as cancelled
+    std::vector<BacklogEntry> takeAll();
+
+    // Change the in-memory limit (0 keeps it) and spill directory (nullptr keeps it, "" = temp)
+    // Entries already in memory or in a spill file stay where they are
+    void configure(size_t maxMemoryEntries, const char* spillDirectory);
+
+    // Get the in-memory limit and the spill directory in effect
+    void getConfiguration(size_t& maxMemoryEntries, String& spillDirectory) const;
+
+    // Get the number of backlogged uploads in memory and in spill files
+    void getSizes(size_t& memoryEntries, size_t& spilledEntries) const;
+};
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetUploadBacklog(long maxMemoryEntries, const char* spillDirectory);
+}
+
+// S3UPLOADBACKLOG_H
+#endif
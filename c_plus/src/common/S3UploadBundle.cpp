@@ -0,0 +1,484 @@
+#include "S3UploadBundle.h"
+
+// Runtime bundling settings, changed through SetFolderUploadBundling
+// Files smaller than the threshold are bundled; 0 disables bundling
+static std::atomic<long long> g_smallFileThreshold(0);
+static std::atomic<long long> g_bundleTargetSize(DEFAULT_BUNDLE_TARGET_SIZE);
+
+// End-of-archive marker: two zero blocks
+static const long long TAR_TRAILER_SIZE = 2 * TAR_BLOCK_SIZE;
+// Sizes of the ustar name and prefix fields
+static const size_t TAR_NAME_SIZE = 100;
+static const size_t TAR_PREFIX_SIZE = 155;
+// Archive bytes generated per refill of the stream buffer
+static const size_t BUNDLE_STREAM_BUFFER_SIZE = 64 * 1024;
+
+bool isFolderBundlingEnabled() {
+    return g_smallFileThreshold.load() > 0;
+}
+
+static long long roundUpToBlock(long long size) {
+    return (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+}
+
+static bool isAsciiText(const String& text) {
+    return std::all_of(text.begin(), text.end(), [](char c) {
+        return static_cast<unsigned char>(c) < 0x80;
+    });
+}
+
+// Convert a path from the ANSI code page (as returned by the A file APIs) to UTF-8,
+// the encoding PAX headers and JSON expect
+static String ansiToUtf8(const String& text) {
+    if (isAsciiText(text)) {
+        return text;
+    }
+    int textLength = static_cast<int>(text.size());
+    int wideLength = MultiByteToWideChar(CP_ACP, 0, text.c_str(), textLength, nullptr, 0);
+    if (wideLength <= 0) {
+        return text;
+    }
+    std::wstring wide(wideLength, L'\0');
+    MultiByteToWideChar(CP_ACP, 0, text.c_str(), textLength, &wide[0], wideLength);
+    int utf8Length = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), wideLength, nullptr, 0, nullptr, nullptr);
+    if (utf8Length <= 0) {
+        return text;
+    }
+    String utf8(utf8Length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), wideLength, &utf8[0], utf8Length, nullptr, nullptr);
+    return utf8;
+}
+
+// Write value as width - 1 zero-padded octal digits followed by a NUL
+static void writeOctalField(char* field, size_t width, long long value) {
+    snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+}
+
+// Fit an archive path into the ustar name and prefix fields
+// Returns false when the path only fits into a PAX header
+static bool splitUstarPath(const String& path, String& name, String& prefix) {
+    if (path.size() <= TAR_NAME_SIZE) {
+        name = path;
+        prefix.clear();
+        return true;
+    }
+    for (size_t slash = path.find('/'); slash != String::npos && slash <= TAR_PREFIX_SIZE;
+         slash = path.find('/', slash + 1)) {
+        if (slash > 0 && path.size() - slash - 1 <= TAR_NAME_SIZE) {
+            prefix = path.substr(0, slash);
+            name = path.substr(slash + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Build one 512-byte ustar header block
+static String buildUstarHeader(const String& name, const String& prefix, long long size,
+                               long long mtimeSeconds, char typeFlag) {
+    String block(static_cast<size_t>(TAR_BLOCK_SIZE), '\0');
+    char* header = &block[0];
+
+    // Step 1: Fill the fields (mode 0644, owner 0, regular file or PAX record)
+    memcpy(header, name.data(), std::min(name.size(), TAR_NAME_SIZE));
+    writeOctalField(header + 100, 8, 0644);
+    writeOctalField(header + 108, 8, 0);
+    writeOctalField(header + 116, 8, 0);
+    writeOctalField(header + 124, 12, size);
+    writeOctalField(header + 136, 12, mtimeSeconds);
+    header[156] = typeFlag;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memcpy(header + 345, prefix.data(), std::min(prefix.size(), TAR_PREFIX_SIZE));
+
+    // Step 2: The checksum is the byte sum with the checksum field taken as spaces,
+    // stored as six octal digits, a NUL and a space
+    memset(header + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (size_t i = 0; i < block.size(); i++) {
+        checksum += static_cast<unsigned char>(header[i]);
+    }
+    snprintf(header + 148, 7, "%06o", checksum);
+    return block;
+}
+
+// Build a PAX record "<length> <key>=<value>\n"; the length includes its own digits
+static String buildPaxRecord(const String& key, const String& value) {
+    size_t baseLength = key.size() + value.size() + 3;
+    size_t length = baseLength + 1;
+    while (std::to_string(length).size() + baseLength != length) {
+        length = std::to_string(length).size() + baseLength;
+    }
+    return std::to_string(length) + " " + key + "=" + value + "\n";
+}
+
+// Build the header blocks of a member: one ustar header, preceded by a PAX header
+// carrying the UTF-8 path when the path is not ASCII or too long for ustar
+static String buildMemberHeaders(const BundleMember& member) {
+    String name;
+    String prefix;
+    if (isAsciiText(member.archivePath) && splitUstarPath(member.archivePath, name, prefix)) {
+        return buildUstarHeader(name, prefix, member.size, member.mtimeSeconds, '0');
+    }
+
+    // Readers without PAX support fall back to the (truncated) file name
+    String fileName = member.archivePath.substr(member.archivePath.find_last_of('/') + 1);
+    fileName = fileName.substr(0, TAR_NAME_SIZE);
+    String records = buildPaxRecord("path", ansiToUtf8(member.archivePath));
+
+    String headers = buildUstarHeader("PaxHeaders/" + fileName.substr(0, TAR_NAME_SIZE - 11), "",
+                                      static_cast<long long>(records.size()), member.mtimeSeconds, 'x');
+    headers += records;
+    headers.resize(static_cast<size_t>(roundUpToBlock(static_cast<long long>(headers.size()))), '\0');
+    headers += buildUstarHeader(fileName, "", member.size, member.mtimeSeconds, '0');
+    return headers;
+}
+
+// Place a member at offset and advance offset past its padded data
+static void layoutMember(BundleMember& member, long long& offset) {
+    member.headerOffset = offset;
+    member.dataOffset = offset + static_cast<long long>(buildMemberHeaders(member).size());
+    member.endOffset = member.dataOffset + roundUpToBlock(member.size);
+    offset = member.endOffset;
+}
+
+// Manifest listing where each bundled file's data starts in the archive
+// { "version": 1, "files": [ { "path": "...", "key": "...", "offset": 512, "size": 100, "mtime": 1700000000 } ] }
+static String buildManifest(const UploadBundle& bundle) {
+    std::ostringstream oss;
+    oss << "{\"version\":1,\"files\":[";
+    for (size_t i = 0; i < bundle.fileCount; i++) {
+        const BundleMember& member = bundle.members[i];
+        if (i > 0) {
+            oss << ",";
+        }
+        oss << "{\"path\":\"" << escapeJson(ansiToUtf8(member.archivePath)) << "\""
+            << ",\"key\":\"" << escapeJson(ansiToUtf8(member.objectKey)) << "\""
+            << ",\"offset\":" << member.dataOffset
+            << ",\"size\":" << member.size
+            << ",\"mtime\":" << member.mtimeSeconds
+            << "}";
+    }
+    oss << "]}";
+    return oss.str();
+}
+
+// Lay out a group of files, followed by the manifest and the end-of-archive blocks
+static std::shared_ptr<const UploadBundle> buildBundle(const std::vector<LocalFileEntry>& files,
+                                                       const String& keyPrefix) {
+    auto bundle = std::make_shared<UploadBundle>();
+    long long offset = 0;
+
+    // Step 1: Files in folder order
+    for (const auto& file : files) {
+        BundleMember member;
+        member.localFilePath = file.fullPath;
+        member.archivePath = file.relativePath;
+        member.objectKey = keyPrefix + file.relativePath;
+        member.size = file.size;
+        member.mtimeSeconds = std::max(0LL, (file.lastWriteTime - FILETIME_UNIX_EPOCH) / 10000000);
+        layoutMember(member, offset);
+        bundle->members.push_back(member);
+        bundle->filesSize += file.size;
+    }
+    bundle->fileCount = files.size();
+
+    // Step 2: The manifest goes last, once every file offset is known
+    BundleMember manifest;
+    manifest.archivePath = BUNDLE_MANIFEST_NAME;
+    manifest.inlineData = buildManifest(*bundle);
+    manifest.size = static_cast<long long>(manifest.inlineData.size());
+    manifest.mtimeSeconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    layoutMember(manifest, offset);
+    bundle->members.push_back(manifest);
+
+    bundle->archiveSize = offset + TAR_TRAILER_SIZE;
+    return bundle;
+}
+
+void planFolderBundles(const std::vector<LocalFileEntry>& files,
+                       const String& keyPrefix,
+                       std::vector<std::shared_ptr<const UploadBundle>>& bundles,
+                       std::vector<LocalFileEntry>& remainingFiles) {
+    bundles.clear();
+    remainingFiles.clear();
+
+    long long threshold = g_smallFileThreshold.load();
+    long long targetSize = g_bundleTargetSize.load();
+    if (threshold <= 0) {
+        remainingFiles = files;
+        return;
+    }
+
+    // Step 1: Large files keep their own upload
+    std::vector<LocalFileEntry> smallFiles;
+    for (const auto& file : files) {
+        if (file.size < threshold) {
+            smallFiles.push_back(file);
+        } else {
+            remainingFiles.push_back(file);
+        }
+    }
+
+    // Step 2: Fill bundles up to the target size in folder order (the manifest comes on top);
+    // a group too small to be worth a bundle is uploaded file by file
+    std::vector<LocalFileEntry> group;
+    long long groupSize = 0;
+    auto flushGroup = [&]() {
+        if (group.size() >= MIN_FILES_PER_BUNDLE) {
+            bundles.push_back(buildBundle(group, keyPrefix));
+        } else {
+            remainingFiles.insert(remainingFiles.end(), group.begin(), group.end());
+        }
+        group.clear();
+        groupSize = 0;
+    };
+    for (const auto& file : smallFiles) {
+        long long memberSize = TAR_BLOCK_SIZE + roundUpToBlock(file.size);
+        if (!group.empty() && groupSize + memberSize > targetSize) {
+            flushGroup();
+        }
+        group.push_back(file);
+        groupSize += memberSize;
+    }
+    flushGroup();
+}
+
+String getBundleObjectKey(const String& keyPrefix, size_t bundleIndex) {
+    char name[32];
+    snprintf(name, sizeof(name), "bundle-%05u.tar", static_cast<unsigned int>(bundleIndex));
+    return keyPrefix + BUNDLE_KEY_FOLDER + name;
+}
+
+ObjectMetadata getBundleMetadata(const UploadBundle& bundle) {
+    ObjectMetadata metadata;
+    metadata[METADATA_BUNDLE_FORMAT] = "tar";
+    metadata[METADATA_BUNDLE_FILE_COUNT] = std::to_string(bundle.fileCount);
+    metadata[METADATA_BUNDLE_MANIFEST_OFFSET] = std::to_string(bundle.getManifest().dataOffset);
+    metadata[METADATA_BUNDLE_MANIFEST_SIZE] = std::to_string(bundle.getManifest().size);
+    return metadata;
+}
+
+// Stream buffer producing the archive bytes of a bundle on demand
+// Headers are rebuilt from the member layout, file data is read in place, and only
+// one member's file is open at a time. Seeking just moves the read position.
+class BundleBody::TarStreamBuf : public std::streambuf {
+private:
+    std::shared_ptr<const UploadBundle> bundle_;
+    std::vector<char> buffer_;
+    // Archive offset of the byte following the buffered range
+    long long position_;
+    // Member whose headers are cached and whose file is open
+    size_t memberIndex_;
+    String memberHeaders_;
+    std::ifstream file_;
+    long long filePosition_;
+    bool failed_;
+    String failure_;
+
+    void fail(const String& message) {
+        if (!failed_) {
+            failed_ = true;
+            failure_ = message;
+            AWS_LOGSTREAM_ERROR("S3Upload", "Bundle read failed: " << message);
+        }
+    }
+
+    // Make member index the current one, checking its file still matches the plan
+    bool selectMember(size_t index) {
+        if (index == memberIndex_) {
+            return !failed_;
+        }
+        file_.close();
+        file_.clear();
+        memberIndex_ = index;
+        filePosition_ = 0;
+
+        const BundleMember& member = bundle_->members[index];
+        memberHeaders_ = buildMemberHeaders(member);
+        if (member.localFilePath.empty()) {
+            return true;
+        }
+
+        long long fileSize = 0;
+        long long lastWriteTime = 0;
+        if (!getFileInfo64(member.localFilePath, fileSize, lastWriteTime)) {
+            fail(formatErrorMessage(ErrorMessage::LOCAL_FILE_NOT_EXIST, member.localFilePath));
+            return false;
+        }
+        if (fileSize != member.size) {
+            fail(formatErrorMessage("File size changed since the folder was listed", member.localFilePath));
+            return false;
+        }
+        file_.open(member.localFilePath.c_str(), std::ios::in | std::ios::binary);
+        if (!file_.is_open()) {
+            fail(formatErrorMessage("Cannot open file for reading", member.localFilePath));
+            return false;
+        }
+        return true;
+    }
+
+    // Copy length bytes of the current member's data, starting dataPosition bytes into it
+    bool readMemberData(const BundleMember& member, long long dataPosition, char* destination, size_t length) {
+        if (member.localFilePath.empty()) {
+            memcpy(destination, member.inlineData.data() + dataPosition, length);
+            return true;
+        }
+        if (filePosition_ != dataPosition) {
+            file_.clear();
+            file_.seekg(dataPosition, std::ios::beg);
+        }
+        file_.read(destination, static_cast<std::streamsize>(length));
+        if (static_cast<size_t>(file_.gcount()) != length) {
+            fail(formatErrorMessage("File shrank while it was uploaded", member.localFilePath));
+            return false;
+        }
+        filePosition_ = dataPosition + static_cast<long long>(length);
+        return true;
+    }
+
+    // Fill destination with the archive bytes starting at offset
+    bool readArchive(long long offset, char* destination, size_t length) {
+        const std::vector<BundleMember>& members = bundle_->members;
+        while (length > 0) {
+            // Step 1: Past the last member only the zero end-of-archive blocks remain
+            if (offset >= members.back().endOffset) {
+                memset(destination, 0, length);
+                return true;
+            }
+
+            // Step 2: Find the member covering offset (members are laid out back to back)
+            auto it = std::upper_bound(members.begin(), members.end(), offset,
+                                       [](long long value, const BundleMember& member) {
+                                           return value < member.endOffset;
+                                       });
+            size_t index = static_cast<size_t>(it - members.begin());
+            if (!selectMember(index)) {
+                return false;
+            }
+            const BundleMember& member = members[index];
+
+            // Step 3: Copy from the headers, the file data or the zero padding
+            long long dataEnd = member.dataOffset + member.size;
+            size_t chunk;
+            if (offset < member.dataOffset) {
+                chunk = static_cast<size_t>(std::min<long long>(length, member.dataOffset - offset));
+                memcpy(destination, memberHeaders_.data() + (offset - member.headerOffset), chunk);
+            } else if (offset < dataEnd) {
+                chunk = static_cast<size_t>(std::min<long long>(length, dataEnd - offset));
+                if (!readMemberData(member, offset - member.dataOffset, destination, chunk)) {
+                    return false;
+                }
+            } else {
+                chunk = static_cast<size_t>(std::min<long long>(length, member.endOffset - offset));
+                memset(destination, 0, chunk);
+            }
+            destination += chunk;
+            offset += static_cast<long long>(chunk);
+            length -= chunk;
+        }
+        return true;
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (failed_ || position_ >= bundle_->archiveSize) {
+            return traits_type::eof();
+        }
+
+        size_t length = static_cast<size_t>(std::min<long long>(
+            static_cast<long long>(buffer_.size()), bundle_->archiveSize - position_));
+        if (!readArchive(position_, buffer_.data(), length)) {
+            return traits_type::eof();
+        }
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + length);
+        position_ += static_cast<long long>(length);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        long long current = position_ - static_cast<long long>(egptr() - gptr());
+        long long base = direction == std::ios_base::beg ? 0
+                       : direction == std::ios_base::cur ? current
+                       : bundle_->archiveSize;
+        long long target = base + static_cast<long long>(offset);
+        if (target < 0 || target > bundle_->archiveSize) {
+            return pos_type(off_type(-1));
+        }
+        if (target != current) {
+            setg(buffer_.data(), buffer_.data(), buffer_.data());
+            position_ = target;
+        }
+        return pos_type(off_type(target));
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+
+public:
+    explicit TarStreamBuf(const std::shared_ptr<const UploadBundle>& bundle)
+        : bundle_(bundle),
+          buffer_(BUNDLE_STREAM_BUFFER_SIZE),
+          position_(0),
+          memberIndex_(static_cast<size_t>(-1)),
+          filePosition_(0),
+          failed_(false) {
+        setg(buffer_.data(), buffer_.data(), buffer_.data());
+    }
+
+    bool hasFailed() const { return failed_; }
+    const String& getFailure() const { return failure_; }
+};
+
+BundleBody::BundleBody(const std::shared_ptr<const UploadBundle>& bundle)
+    : streamBuf_(new TarStreamBuf(bundle)) {
+    stream_ = Aws::MakeShared<Aws::IOStream>("BundleBody", streamBuf_.get());
+}
+
+BundleBody::~BundleBody() {
+    stream_.reset();
+    streamBuf_.reset();
+}
+
+bool BundleBody::hasFailed() const {
+    return streamBuf_->hasFailed();
+}
+
+String BundleBody::getFailure() const {
+    return streamBuf_->getFailure();
+}
+
+// Exported bundling setting for folder uploads
+// Files under smallFileKB are packed into tar bundles of about bundleSizeMB each, with a
+// manifest mapping every file to its offset. smallFileKB = 0 disables bundling (default);
+// bundleSizeMB = 0 keeps the current size (default 32 MB, at most 1024 MB).
+extern "C" S3UPLOAD_API const char* __stdcall SetFolderUploadBundling(long smallFileKB, long bundleSizeMB) {
+    static std::string response;
+
+    if (smallFileKB < 0 || bundleSizeMB < 0) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+    if (bundleSizeMB > 0) {
+        g_bundleTargetSize = std::min(static_cast<long long>(bundleSizeMB) * 1024 * 1024, MAX_BUNDLE_TARGET_SIZE);
+    }
+    g_smallFileThreshold = static_cast<long long>(smallFileKB) * 1024;
+
+    std::ostringstream oss;
+    if (smallFileKB > 0) {
+        oss << "Folder upload bundling enabled for files under " << g_smallFileThreshold.load()
+            << " bytes, bundles of " << g_bundleTargetSize.load() << " bytes";
+    } else {
+        oss << "Folder upload bundling disabled";
+    }
+    response = create_response(UPLOAD_SUCCESS, oss.str());
+    return response.c_str();
+}
@@ -0,0 +1,111 @@
+#ifndef S3UPLOADBUNDLE_H
+#define S3UPLOADBUNDLE_H
+
+#include "S3Common.h"
+
+// Bundling configuration (SetFolderUploadBundling)
+// Bundle size used when bundling is enabled without one
+static const long long DEFAULT_BUNDLE_TARGET_SIZE = 32LL * 1024 * 1024;
+// Largest bundle; a bundle is sent with one PutObject and resent whole on a retry
+static const long long MAX_BUNDLE_TARGET_SIZE = 1024LL * 1024 * 1024;
+// Fewer small files than this are uploaded one by one
+static const size_t MIN_FILES_PER_BUNDLE = 2;
+// Bundles are stored under keyPrefix + BUNDLE_KEY_FOLDER
+static const String BUNDLE_KEY_FOLDER = ".bundles/";
+// Name of the manifest, the last member of every bundle
+static const String BUNDLE_MANIFEST_NAME = ".s3upload-manifest.json";
+// tar block size; headers and padded file data are multiples of it
+static const long long TAR_BLOCK_SIZE = 512;
+
+// Object metadata keys of a bundle (x-amz-meta-*)
+// The manifest offset and size allow reading it with one ranged GET
+static const String METADATA_BUNDLE_FORMAT = "s3upload-bundle";
+static const String METADATA_BUNDLE_FILE_COUNT = "s3upload-bundle-files";
+static const String METADATA_BUNDLE_MANIFEST_OFFSET = "s3upload-manifest-offset";
+static const String METADATA_BUNDLE_MANIFEST_SIZE = "s3upload-manifest-size";
+
+// One member of a tar bundle
+struct BundleMember {
+    // Local file to read; empty for members held in inlineData (the manifest)
+    String localFilePath;
+    String inlineData;
+    // Path inside the archive ('/' separated)
+    String archivePath;
+    // Key the file would have had if uploaded on its own
+    String objectKey;
+    long long size;
+    // Modification time in seconds since 1970
+    long long mtimeSeconds;
+    // Archive offsets: header(s) start, data start, end of padded data
+    long long headerOffset;
+    long long dataOffset;
+    long long endOffset;
+
+    BundleMember() : size(0), mtimeSeconds(0), headerOffset(0), dataOffset(0), endOffset(0) {}
+};
+
+// A tar archive of small files uploaded as one object
+// The archive is streamed from the files during the upload; nothing is staged on disk.
+struct UploadBundle {
+    // Bundled files in archive order, followed by the manifest
+    std::vector<BundleMember> members;
+    // Number of bundled files (members without the manifest)
+    size_t fileCount;
+    // Sum of the bundled file sizes
+    long long filesSize;
+    // Size of the whole archive including the end-of-archive blocks
+    long long archiveSize;
+
+    UploadBundle() : fileCount(0), filesSize(0), archiveSize(0) {}
+
+    const BundleMember& getManifest() const { return members.back(); }
+};
+
+// Request body that generates the tar archive of a bundle while it is read
+// Seekable, so retries rewind it like a file body. A bundled file that changed size
+// since planning ends the stream early, which fails the request (see hasFailed).
+class BundleBody {
+private:
+    class TarStreamBuf;
+
+    std::unique_ptr<TarStreamBuf> streamBuf_;
+    std::shared_ptr<Aws::IOStream> stream_;
+
+    BundleBody(const BundleBody&);
+    BundleBody& operator=(const BundleBody&);
+
+public:
+    explicit BundleBody(const std::shared_ptr<const UploadBundle>& bundle);
+    ~BundleBody();
+
+    // True when a bundled file could not be read as planned
+    bool hasFailed() const;
+    // Description of the read failure
+    String getFailure() const;
+
+    const std::shared_ptr<Aws::IOStream>& getStream() const { return stream_; }
+};
+
+// Check whether folder uploads bundle small files (SetFolderUploadBundling)
+bool isFolderBundlingEnabled();
+
+// Split folder files into bundles of small files and files uploaded on their own
+// keyPrefix ends with '/' (or is empty); it forms the per-file object keys in the manifests
+void planFolderBundles(const std::vector<LocalFileEntry>& files,
+                       const String& keyPrefix,
+                       std::vector<std::shared_ptr<const UploadBundle>>& bundles,
+                       std::vector<LocalFileEntry>& remainingFiles);
+
+// Object key of bundle number bundleIndex (1-based) of a folder upload
+// Keys only depend on the prefix, so uploading the folder again replaces its bundles
+String getBundleObjectKey(const String& keyPrefix, size_t bundleIndex);
+
+// Metadata stored on a bundle object
+ObjectMetadata getBundleMetadata(const UploadBundle& bundle);
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetFolderUploadBundling(long smallFileKB, long bundleSizeMB);
+}
+
+// S3UPLOADBUNDLE_H
+#endif
@@ -0,0 +1,272 @@
+#include "S3Common.h"
+
+// Steady clock ticks of a progress time point (0 when not reached)
+static std::chrono::steady_clock::rep toTicks(const std::chrono::steady_clock::time_point& timePoint) {
+    return timePoint.time_since_epoch().count();
+}
+
+static std::chrono::steady_clock::time_point fromTicks(std::chrono::steady_clock::rep ticks) {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+}
+
+std::shared_ptr<const String> UploadStringPool::acquire(const String& value) {
+    if (value.empty()) {
+        return nullptr;
+    }
+    auto it = index_.find(&value);
+    if (it != index_.end()) {
+        it->second.references++;
+        return it->second.value;
+    }
+
+    // The key points at the pooled string, which lives at least as long as its slot
+    Slot slot;
+    slot.value = std::make_shared<String>(value);
+    slot.references = 1;
+    const String* key = slot.value.get();
+    return index_.emplace(key, std::move(slot)).first->second.value;
+}
+
+void UploadStringPool::release(const std::shared_ptr<const String>& value) {
+    if (!value) {
+        return;
+    }
+    auto it = index_.find(value.get());
+    if (it == index_.end() || it->second.value != value) {
+        return;
+    }
+    if (--it->second.references == 0) {
+        index_.erase(it);
+    }
+}
+
+UploadHistory::UploadHistory(size_t capacity)
+    : slots_(std::max<size_t>(capacity, 1)), first_(0), next_(0) {}
+
+void UploadHistory::releaseStrings(const UploadHistoryEntry& entry) {
+    strings_.release(entry.uploadId);
+    strings_.release(entry.dataId);
+    strings_.release(entry.localFilePath);
+    strings_.release(entry.s3ObjectKey);
+    strings_.release(entry.bucketName);
+    strings_.release(entry.errorMessage);
+    strings_.release(entry.checksumCRC32C);
+}
+
+std::shared_ptr<const UploadHistoryEntry> UploadHistory::push(const AsyncUploadProgress& progress) {
+    auto entry = std::make_shared<UploadHistoryEntry>();
+    entry->uploadId = strings_.acquire(progress.uploadId);
+    entry->dataId = strings_.acquire(progress.dataId);
+    entry->localFilePath = strings_.acquire(progress.localFilePath);
+    entry->s3ObjectKey = strings_.acquire(progress.s3ObjectKey);
+    entry->bucketName = strings_.acquire(progress.bucketName);
+    entry->errorMessage = strings_.acquire(progress.errorMessage.load());
+    entry->checksumCRC32C = strings_.acquire(progress.checksumCRC32C.load());
+    entry->sequence = next_++;
+    entry->status = progress.status;
+    entry->errorCode = progress.errorCode.load();
+    entry->retryCount = progress.retryCount.load();
+    entry->totalParts = progress.totalParts.load();
+    entry->completedParts = progress.completedParts.load();
+    entry->requestCount = progress.requestCount.load();
+    entry->deduplicated = progress.deduplicated.load();
+    entry->totalSize = progress.totalSize;
+    entry->bytesSent = progress.getBytesSent();
+    entry->originalSize = progress.originalSize.load();
+    entry->throttledMs = progress.throttledMs.load();
+    entry->backoffMs = progress.backoffMs.load();
+    entry->queueWaitMs = progress.queueWaitMs.load();
+    entry->connectMs = progress.connectMs.load();
+    entry->timeTicks[0] = toTicks(progress.queuedTime);
+    entry->timeTicks[1] = toTicks(progress.startTime);
+    entry->timeTicks[2] = toTicks(progress.clientStartTime);
+    entry->timeTicks[3] = toTicks(progress.openStartTime);
+    entry->timeTicks[4] = toTicks(progress.transferStartTime);
+    entry->timeTicks[5] = toTicks(progress.endTime);
+    entry->changeVersion = progress.changeVersion.load();
+    entry->bundle = progress.bundle;
+    slots_[entry->sequence % slots_.size()].entry = entry;
+    return entry;
+}
+
+void UploadHistory::popOldest() {
+    if (first_ == next_) {
+        return;
+    }
+    Slot& slot = slots_[first_ % slots_.size()];
+    if (slot.entry) {
+        releaseStrings(*slot.entry);
+        slot.entry.reset();
+    }
+    first_++;
+}
+
+void UploadHistory::remove(const UploadHistoryEntry& entry) {
+    if (entry.sequence < first_ || entry.sequence >= next_) {
+        return;
+    }
+    Slot& slot = slots_[entry.sequence % slots_.size()];
+    if (slot.entry.get() == &entry) {
+        releaseStrings(entry);
+        slot.entry.reset();
+    }
+}
+
+void UploadHistory::setCapacity(size_t capacity) {
+    capacity = std::max<size_t>(capacity, std::max<size_t>(size(), 1));
+    if (capacity == slots_.size()) {
+        return;
+    }
+    // Sequence numbers stay the same; only their slots move
+    std::vector<Slot> resized(capacity);
+    for (unsigned long long sequence = first_; sequence < next_; sequence++) {
+        resized[sequence % capacity] = std::move(slots_[sequence % slots_.size()]);
+    }
+    slots_.swap(resized);
+}
+
+// Text of a pooled string (nullptr is the empty string)
+static const String& getText(const std::shared_ptr<const String>& value) {
+    static const String empty;
+    return value ? *value : empty;
+}
+
+std::shared_ptr<AsyncUploadProgress> UploadHistoryEntry::restore() const {
+    auto progress = std::make_shared<AsyncUploadProgress>();
+    progress->uploadId = getText(uploadId);
+    progress->dataId = getText(dataId);
+    progress->localFilePath = getText(localFilePath);
+    progress->s3ObjectKey = getText(s3ObjectKey);
+    progress->bucketName = getText(bucketName);
+    progress->errorMessage.store(errorMessage);
+    progress->checksumCRC32C.store(checksumCRC32C);
+    progress->status = static_cast<UploadStatus>(status);
+    progress->errorCode = errorCode;
+    progress->retryCount = retryCount;
+    progress->totalParts = totalParts;
+    progress->completedParts = completedParts;
+    progress->requestCount = requestCount;
+    progress->deduplicated = deduplicated;
+    progress->totalSize = totalSize;
+    progress->bytesSent = bytesSent;
+    progress->originalSize = originalSize;
+    progress->throttledMs = throttledMs;
+    progress->backoffMs = backoffMs;
+    progress->queueWaitMs = queueWaitMs;
+    progress->connectMs = connectMs;
+    progress->queuedTime = fromTicks(timeTicks[0]);
+    progress->startTime = fromTicks(timeTicks[1]);
+    progress->clientStartTime = fromTicks(timeTicks[2]);
+    progress->openStartTime = fromTicks(timeTicks[3]);
+    progress->transferStartTime = fromTicks(timeTicks[4]);
+    progress->endTime = fromTicks(timeTicks[5]);
+    progress->changeVersion = changeVersion;
+    progress->bundle = bundle;
+    return progress;
+}
+
+void UploadHistoryEntry::fillStatusRecord(UploadStatusRecord& record) const {
+    const String& id = getText(uploadId);
+    size_t idLength = std::min(id.size(), static_cast<size_t>(UPLOAD_STATUS_ID_SIZE - 1));
+    memcpy(record.uploadId, id.data(), idLength);
+    memset(record.uploadId + idLength, 0, UPLOAD_STATUS_ID_SIZE - idLength);
+    record.status = status;
+    record.errorCode = errorCode;
+    record.retryCount = retryCount;
+    record.totalParts = totalParts;
+    record.completedParts = completedParts;
+    record.totalSize = totalSize;
+    record.bytesSent = bytesSent;
+    record.startTimeMs = getStatusTimeMs(fromTicks(timeTicks[1]));
+    record.endTimeMs = getStatusTimeMs(fromTicks(timeTicks[5]));
+}
+
+void AsyncUploadManager::compactLocked(const std::shared_ptr<AsyncUploadProgress>& progress) {
+    // Step 1: Make room, then copy the record into the ring
+    evictHistoryLocked(history_.getCapacity() - 1);
+    UploadSlot compacted;
+    compacted.entry = history_.push(*progress);
+
+    // Step 2: Point the group's slot at the entry and drop the live record
+    auto groupIt = dataIdGroups_.find(progress->dataId);
+    if (groupIt != dataIdGroups_.end()) {
+        groupIt->second.uploads.replace([&progress](const UploadSlot& slot) {
+            return slot.progress == progress;
+        }, compacted);
+        markChangedLocked(groupIt->first, groupIt->second);
+    }
+    changeUploadsLocked([&progress](UploadMap& uploads) {
+        uploads.erase(progress->uploadId);
+    });
+}
+
+void AsyncUploadManager::evictHistoryLocked(size_t maxEntries) {
+    auto now = std::chrono::steady_clock::now();
+    auto maxAge = std::chrono::minutes(historyMaxAgeMinutes_);
+
+    while (history_.size() > 0) {
+        // Entries are pushed as uploads finish, so the oldest one expires first;
+        // removed entries just give their slot back
+        std::shared_ptr<const UploadHistoryEntry> oldest = history_.getOldest();
+        bool expired = !oldest || now - fromTicks(oldest->timeTicks[5]) > maxAge;
+        if (history_.size() <= maxEntries && !expired) {
+            break;
+        }
+
+        // Removed entries already left their group in removeUploadsByDataId
+        if (oldest) {
+            const String& dataId = getText(oldest->dataId);
+            bool groupDropped = unlinkSlotLocked(dataId, oldest->status, oldest->totalSize,
+                                                 [&oldest](const UploadSlot& slot) {
+                return slot.entry == oldest;
+            });
+            if (groupDropped) {
+                completionEvents_.erase(dataId);
+            }
+        }
+        history_.popOldest();
+    }
+}
+
+void AsyncUploadManager::setHistoryRetention(long long maxEntries, long long maxAgeMinutes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ChangeScope change(*this);
+    if (maxAgeMinutes > 0) {
+        historyMaxAgeMinutes_ = std::min(maxAgeMinutes, MAX_UPLOAD_HISTORY_AGE_MINUTES);
+    }
+    size_t capacity = history_.getCapacity();
+    if (maxEntries > 0) {
+        capacity = static_cast<size_t>(std::min<long long>(maxEntries, static_cast<long long>(MAX_UPLOAD_HISTORY_ENTRIES)));
+    }
+    evictHistoryLocked(capacity);
+    history_.setCapacity(capacity);
+    statusChanged_.notify_all();
+}
+
+// Configure how long finished async uploads stay queryable
+// Finished uploads leave the active set (MAX_UPLOAD_LIMIT) at once and are kept, compacted,
+// until the history holds maxEntries newer ones or they are older than maxAgeMinutes.
+// maxEntries <= 0 or maxAgeMinutes <= 0 keeps that setting. Defaults: 10000 entries, 24 hours.
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadHistoryRetention(long maxEntries, long maxAgeMinutes) {
+    static std::string response;
+
+    try {
+        auto& manager = AsyncUploadManager::getInstance();
+        manager.setHistoryRetention(maxEntries, maxAgeMinutes);
+
+        size_t capacity = 0;
+        long long ageMinutes = 0;
+        manager.getHistoryRetention(capacity, ageMinutes);
+        std::ostringstream oss;
+        oss << "Upload history keeps up to " << capacity << " finished uploads for up to "
+            << ageMinutes << " minutes";
+        response = create_response(UPLOAD_SUCCESS, oss.str());
+    }
+    catch (const std::exception& e) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to set upload history retention", e.what()));
+    }
+    catch (...) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to set upload history retention", ErrorMessage::UNKNOWN_ERROR));
+    }
+    return response.c_str();
+}
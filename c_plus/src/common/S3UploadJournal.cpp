@@ -0,0 +1,275 @@
+#include "S3UploadJournal.h"
+
+// Journal directory; empty disables journaling
+static std::mutex g_journalDirectoryMutex;
+static String g_journalDirectory;
+static bool g_journalDirectoryInitialized = false;
+
+// Serializes writes to journal files (part appends from concurrent part threads)
+static std::mutex g_journalWriteMutex;
+
+// Journal paths held by running uploads (UploadJournalLock)
+static std::mutex g_activeJournalsMutex;
+static std::unordered_set<String> g_activeJournals;
+
+// Default journal directory: %LOCALAPPDATA%\S3UploadLib\journal
+static String getDefaultJournalDirectory() {
+    String localAppData = getLocalAppDataDirectory();
+    if (localAppData.empty()) {
+        return "";
+    }
+    return localAppData + PATH_SEPARATOR + "S3UploadLib" + PATH_SEPARATOR + "journal";
+}
+
+static String getJournalDirectory() {
+    std::lock_guard<std::mutex> lock(g_journalDirectoryMutex);
+    if (!g_journalDirectoryInitialized) {
+        g_journalDirectory = getDefaultJournalDirectory();
+        g_journalDirectoryInitialized = true;
+    }
+    return g_journalDirectory;
+}
+
+bool isUploadJournalEnabled() {
+    return !getJournalDirectory().empty();
+}
+
+String getUploadJournalPath(const String& bucketName, const String& objectKey, const String& localFilePath) {
+    String directory = getJournalDirectory();
+    if (directory.empty()) {
+        return "";
+    }
+
+    // Same file to the same object always maps to the same journal
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0')
+        << hashString64(bucketName + "\n" + objectKey + "\n" + localFilePath);
+    return directory + PATH_SEPARATOR + oss.str() + UPLOAD_JOURNAL_EXTENSION;
+}
+
+bool UploadJournalLock::acquire(const String& journalPath) {
+    if (!journalPath_.empty() || journalPath.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_activeJournalsMutex);
+    if (!g_activeJournals.insert(journalPath).second) {
+        return false;
+    }
+    journalPath_ = journalPath;
+    return true;
+}
+
+UploadJournalLock::~UploadJournalLock() {
+    if (!journalPath_.empty()) {
+        std::lock_guard<std::mutex> lock(g_activeJournalsMutex);
+        g_activeJournals.erase(journalPath_);
+    }
+}
+
+bool isUploadJournalActive(const String& journalPath) {
+    std::lock_guard<std::mutex> lock(g_activeJournalsMutex);
+    return g_activeJournals.count(journalPath) > 0;
+}
+
+bool loadUploadJournal(const String& journalPath, UploadJournal& journal) {
+    std::ifstream file(journalPath.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream contentStream;
+    contentStream << file.rdbuf();
+    String content = contentStream.str();
+
+    // Only complete lines count; a crash during an append can leave a partial last line
+    std::vector<String> lines;
+    size_t lineStart = 0;
+    size_t lineEnd;
+    while ((lineEnd = content.find('\n', lineStart)) != String::npos) {
+        String line = content.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+        lineStart = lineEnd + 1;
+    }
+    if (lines.empty() || lines[0] != "S3UploadJournal " + std::to_string(UPLOAD_JOURNAL_VERSION)) {
+        return false;
+    }
+
+    UploadJournal loaded;
+    loaded.journalPath = journalPath;
+    try {
+        for (size_t i = 1; i < lines.size(); i++) {
+            size_t separator = lines[i].find('=');
+            if (separator == String::npos) {
+                continue;
+            }
+            String name = lines[i].substr(0, separator);
+            String value = lines[i].substr(separator + 1);
+
+            if (name == "bucket") {
+                loaded.bucketName = value;
+            } else if (name == "key") {
+                loaded.objectKey = value;
+            } else if (name == "localFilePath") {
+                loaded.localFilePath = value;
+            } else if (name == "dataId") {
+                loaded.dataId = value;
+            } else if (name == "uploadId") {
+                loaded.multipartUploadId = value;
+            } else if (name == "fileSize") {
+                loaded.fileSize = std::stoll(value);
+            } else if (name == "fileMtime") {
+                loaded.fileMtime = std::stoll(value);
+            } else if (name == "partSize") {
+                loaded.partSize = std::stoll(value);
+            } else if (name == "metadata") {
+                // metadata=<name>=<value>
+                size_t valueSeparator = value.find('=');
+                if (valueSeparator != String::npos) {
+                    loaded.metadata[value.substr(0, valueSeparator)] = value.substr(valueSeparator + 1);
+                }
+            } else if (name == "part") {
+                // part=<number> <etag> <crc32c>
+                std::istringstream partStream(value);
+                int partNumber = 0;
+                UploadJournalPart part;
+                if (partStream >> partNumber >> part.etag >> part.checksumCRC32C) {
+                    loaded.completedParts[partNumber] = part;
+                }
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    if (loaded.bucketName.empty() || loaded.objectKey.empty() || loaded.localFilePath.empty() ||
+        loaded.multipartUploadId.empty() || loaded.fileSize <= 0 || loaded.partSize <= 0) {
+        return false;
+    }
+    journal = loaded;
+    return true;
+}
+
+bool saveUploadJournal(const UploadJournal& journal) {
+    if (journal.journalPath.empty()) {
+        return false;
+    }
+    createDirectories(getJournalDirectory());
+
+    std::lock_guard<std::mutex> lock(g_journalWriteMutex);
+    std::ofstream file(journal.journalPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        AWS_LOGSTREAM_WARN("S3Upload", "Cannot write upload journal: " << journal.journalPath);
+        return false;
+    }
+
+    file << "S3UploadJournal " << UPLOAD_JOURNAL_VERSION << "\n"
+         << "bucket=" << journal.bucketName << "\n"
+         << "key=" << journal.objectKey << "\n"
+         << "localFilePath=" << journal.localFilePath << "\n"
+         << "dataId=" << journal.dataId << "\n"
+         << "uploadId=" << journal.multipartUploadId << "\n"
+         << "fileSize=" << journal.fileSize << "\n"
+         << "fileMtime=" << journal.fileMtime << "\n"
+         << "partSize=" << journal.partSize << "\n";
+    for (const auto& entry : journal.metadata) {
+        file << "metadata=" << entry.first << "=" << entry.second << "\n";
+    }
+    for (const auto& part : journal.completedParts) {
+        file << "part=" << part.first << " " << part.second.etag << " " << part.second.checksumCRC32C << "\n";
+    }
+    file.flush();
+    return file.good();
+}
+
+bool appendUploadJournalPart(const UploadJournal& journal, int partNumber, const UploadJournalPart& part) {
+    if (journal.journalPath.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_journalWriteMutex);
+    std::ofstream file(journal.journalPath.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "part=" << partNumber << " " << part.etag << " " << part.checksumCRC32C << "\n";
+    file.flush();
+    return file.good();
+}
+
+void removeUploadJournal(const UploadJournal& journal) {
+    if (journal.journalPath.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_journalWriteMutex);
+    DeleteFileA(journal.journalPath.c_str());
+}
+
+bool isUploadJournalFileUnchanged(const UploadJournal& journal) {
+    long long fileSize = 0;
+    long long lastWriteTime = 0;
+    if (!getFileInfo64(journal.localFilePath, fileSize, lastWriteTime)) {
+        return false;
+    }
+    return fileSize == journal.fileSize && lastWriteTime == journal.fileMtime;
+}
+
+std::vector<UploadJournal> loadAllUploadJournals() {
+    std::vector<UploadJournal> journals;
+    String directory = getJournalDirectory();
+    if (directory.empty()) {
+        return journals;
+    }
+
+    WIN32_FIND_DATAA findData;
+    HANDLE findHandle = FindFirstFileA((directory + PATH_SEPARATOR + "*" + UPLOAD_JOURNAL_EXTENSION).c_str(), &findData);
+    if (findHandle == INVALID_HANDLE_VALUE) {
+        return journals;
+    }
+
+    do {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        UploadJournal journal;
+        String journalPath = directory + PATH_SEPARATOR + findData.cFileName;
+        if (loadUploadJournal(journalPath, journal)) {
+            journals.push_back(journal);
+        } else {
+            AWS_LOGSTREAM_WARN("S3Upload", "Ignoring unreadable upload journal: " << journalPath);
+        }
+    } while (FindNextFileA(findHandle, &findData));
+
+    FindClose(findHandle);
+    return journals;
+}
+
+// Set the directory for resumable upload journals
+// An empty string disables journaling; the default is %LOCALAPPDATA%\S3UploadLib\journal
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadJournalDirectory(const char* journalDirectory) {
+    static std::string response;
+
+    String directory = journalDirectory ? journalDirectory : "";
+    while (!directory.empty() && (directory.back() == '\\' || directory.back() == '/')) {
+        directory.pop_back();
+    }
+
+    if (!directory.empty() && !createDirectories(directory)) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Cannot create journal directory", directory));
+        return response.c_str();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_journalDirectoryMutex);
+        g_journalDirectory = directory;
+        g_journalDirectoryInitialized = true;
+    }
+
+    if (directory.empty()) {
+        response = create_response(UPLOAD_SUCCESS, "Upload journaling disabled");
+    } else {
+        response = create_response(UPLOAD_SUCCESS, "Upload journal directory set to " + directory);
+    }
+    return response.c_str();
+}
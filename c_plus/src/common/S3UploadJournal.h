@@ -0,0 +1,96 @@
+#ifndef S3UPLOADJOURNAL_H
+#define S3UPLOADJOURNAL_H
+
+#include "S3Common.h"
+
+#include <map>
+
+// Journal file format version written in the first line
+static const int UPLOAD_JOURNAL_VERSION = 3;
+// Extension of journal files inside the journal directory
+static const String UPLOAD_JOURNAL_EXTENSION = ".journal";
+
+// One part already stored on S3
+struct UploadJournalPart {
+    String etag;
+    // Base64 CRC32C S3 verified for the part (needed to complete the upload)
+    String checksumCRC32C;
+};
+
+// On-disk record of one in-flight multipart upload
+// Lets an upload continue from its last completed part after a restart.
+// Credentials are never written; they are supplied again on resume.
+struct UploadJournal {
+    // Path of the journal file itself
+    String journalPath;
+    String bucketName;
+    String objectKey;
+    String localFilePath;
+    // Data ID of the async upload (empty for sync uploads)
+    String dataId;
+    // S3 multipart UploadId
+    String multipartUploadId;
+    // Local file size and last write time when the upload started
+    long long fileSize;
+    long long fileMtime;
+    // Part size used for this upload (must not change on resume)
+    long long partSize;
+    // Metadata the multipart upload was created with (restored when a staged copy is resumed)
+    ObjectMetadata metadata;
+    // Completed parts by part number
+    std::map<int, UploadJournalPart> completedParts;
+
+    UploadJournal() : fileSize(0), fileMtime(0), partSize(0) {}
+};
+
+// Check whether journaling is enabled (journal directory is set)
+bool isUploadJournalEnabled();
+
+// Get journal file path for an upload of localFilePath to bucket/key
+String getUploadJournalPath(const String& bucketName, const String& objectKey, const String& localFilePath);
+
+// Claim on a journal path for one upload running in this process
+// Uploads of the same file to the same key share a journal path; only the holder resumes
+// or writes it. The claim is released when the lock goes out of scope.
+class UploadJournalLock {
+public:
+    UploadJournalLock() {}
+    ~UploadJournalLock();
+
+    // Returns false while another upload in this process holds journalPath
+    bool acquire(const String& journalPath);
+
+private:
+    String journalPath_;
+
+    UploadJournalLock(const UploadJournalLock&) = delete;
+    UploadJournalLock& operator=(const UploadJournalLock&) = delete;
+};
+
+// Check whether an upload in this process holds the journal path
+bool isUploadJournalActive(const String& journalPath);
+
+// Load a journal file; returns false if it is missing or unreadable
+bool loadUploadJournal(const String& journalPath, UploadJournal& journal);
+
+// Write the journal header and all completed parts (replaces the file)
+bool saveUploadJournal(const UploadJournal& journal);
+
+// Append one completed part to the journal file (thread-safe)
+bool appendUploadJournalPart(const UploadJournal& journal, int partNumber, const UploadJournalPart& part);
+
+// Delete the journal file
+void removeUploadJournal(const UploadJournal& journal);
+
+// Check whether the local file still matches the size and mtime in the journal
+bool isUploadJournalFileUnchanged(const UploadJournal& journal);
+
+// Load every journal in the journal directory
+std::vector<UploadJournal> loadAllUploadJournals();
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetUploadJournalDirectory(const char* journalDirectory);
+}
+
+// S3UPLOADJOURNAL_H
+#endif
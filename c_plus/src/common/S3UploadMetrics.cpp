@@ -0,0 +1,341 @@
+#include "S3UploadMetrics.h"
+#include "S3UploadWorkerPool.h"
+#include "S3ClientCache.h"
+#include "S3BandwidthGovernor.h"
+#include "S3RetryPolicy.h"
+#include "S3UploadBacklog.h"
+
+#include <aws/core/monitoring/MonitoringInterface.h>
+#include <aws/core/monitoring/MonitoringFactory.h>
+#include <aws/core/monitoring/CoreMetrics.h>
+#include <aws/core/monitoring/HttpClientMetrics.h>
+
+// Label values, indexed like the enums they describe
+static const char* const METRICS_OPERATION_NAMES[METRICS_OP_COUNT] = {
+    "PutObject", "UploadPart", "CreateMultipartUpload", "CompleteMultipartUpload",
+    "AbortMultipartUpload", "ListParts", "HeadObject", "Other"
+};
+static const char* const METRICS_RETRY_CLASS_NAMES[RETRY_CLASS_COUNT] = {
+    "throttling", "timeout", "connection", "server"
+};
+static const char* const METRICS_PHASE_NAMES[UPLOAD_PHASE_COUNT] = {
+    "queue", "prepare", "client", "open", "transfer", "total"
+};
+static const char* const METRICS_ERROR_NAMES[UPLOAD_ERROR_INTERNAL + 1] = {
+    "none", "invalid_parameters", "sdk_not_initialized", "local_file", "access_denied",
+    "credentials_expired", "network", "s3_rejected", "internal"
+};
+
+static MetricsOperation getMetricsOperation(const String& operation) {
+    for (int i = 0; i < METRICS_OP_OTHER; i++) {
+        if (operation == METRICS_OPERATION_NAMES[i]) {
+            return static_cast<MetricsOperation>(i);
+        }
+    }
+    return METRICS_OP_OTHER;
+}
+
+// Write HELP and TYPE lines for a metric family
+static void writeMetricHeader(std::ostringstream& oss, const char* name, const char* type, const char* help) {
+    oss << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+LatencyHistogram::LatencyHistogram() : sumMs_(0), count_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0);
+    }
+}
+
+void LatencyHistogram::observe(long long ms) {
+    if (ms < 0) {
+        return;
+    }
+    int bucket = 0;
+    while (bucket < METRICS_LATENCY_BUCKET_COUNT && ms > METRICS_LATENCY_BUCKETS_MS[bucket]) {
+        bucket++;
+    }
+    buckets_[bucket]++;
+    sumMs_ += ms;
+    count_++;
+}
+
+void LatencyHistogram::write(std::ostringstream& oss, const char* name, const String& labels) const {
+    String prefix = labels.empty() ? "" : labels + ",";
+    String suffix = labels.empty() ? "" : "{" + labels + "}";
+
+    // Prometheus buckets are cumulative
+    long long cumulative = 0;
+    for (int i = 0; i <= METRICS_LATENCY_BUCKET_COUNT; i++) {
+        cumulative += buckets_[i].load();
+        oss << name << "_bucket{" << prefix << "le=\"";
+        if (i < METRICS_LATENCY_BUCKET_COUNT) {
+            oss << static_cast<double>(METRICS_LATENCY_BUCKETS_MS[i]) / 1000.0;
+        } else {
+            oss << "+Inf";
+        }
+        oss << "\"} " << cumulative << "\n";
+    }
+    oss << name << "_sum" << suffix << " " << static_cast<double>(sumMs_.load()) / 1000.0 << "\n"
+        << name << "_count" << suffix << " " << count_.load() << "\n";
+}
+
+UploadMetrics::UploadMetrics()
+    : bytesSent_(0), retryBudgetExhausted_(0), connectionsNew_(0), connectionsReused_(0) {
+    for (auto& operation : requests_) {
+        operation[0].store(0);
+        operation[1].store(0);
+    }
+    for (auto& counter : retries_) {
+        counter.store(0);
+    }
+    for (auto& counter : uploadsFinished_) {
+        counter.store(0);
+    }
+    for (auto& counter : uploadErrors_) {
+        counter.store(0);
+    }
+}
+
+UploadMetrics& UploadMetrics::getInstance() {
+    static UploadMetrics instance;
+    return instance;
+}
+
+void UploadMetrics::recordRequest(const String& operation, bool success, long long latencyMs,
+                                  long long connectMs, int connectionReused) {
+    MetricsOperation op = getMetricsOperation(operation);
+    requests_[op][success ? 1 : 0]++;
+    requestLatency_[op].observe(latencyMs);
+
+    // Step 1: Prefer the client's own reuse flag; otherwise a request that spent
+    // no time connecting went out on a pooled connection
+    if (connectionReused < 0 && connectMs >= 0) {
+        connectionReused = connectMs == 0 ? 1 : 0;
+    }
+    if (connectionReused == 1) {
+        connectionsReused_++;
+    } else if (connectionReused == 0) {
+        connectionsNew_++;
+        connectLatency_.observe(connectMs);
+    }
+}
+
+void UploadMetrics::recordRetry(RetryErrorClass errorClass, long long backoffMs) {
+    retries_[errorClass]++;
+    backoffLatency_.observe(backoffMs);
+}
+
+void UploadMetrics::recordUpload(const AsyncUploadProgress& progress) {
+    int status = progress.status;
+    if (status >= 0 && status < UPLOAD_STATUS_COUNT) {
+        uploadsFinished_[status]++;
+    }
+    if (status == UPLOAD_FAILED) {
+        int errorCode = progress.errorCode.load();
+        uploadErrors_[errorCode >= 0 && errorCode <= UPLOAD_ERROR_INTERNAL ? errorCode : UPLOAD_ERROR_INTERNAL]++;
+    }
+    for (int phase = 0; phase < UPLOAD_PHASE_COUNT; phase++) {
+        phaseLatency_[phase].observe(progress.getPhaseMs(static_cast<UploadPhase>(phase)));
+    }
+}
+
+String UploadMetrics::format() const {
+    std::ostringstream oss;
+
+    // Step 1: Counters
+    writeMetricHeader(oss, "s3upload_bytes_sent_total", "counter",
+                      "Bytes written to S3 by the HTTP clients, retried attempts included.");
+    oss << "s3upload_bytes_sent_total " << bytesSent_.load() << "\n";
+
+    writeMetricHeader(oss, "s3upload_requests_total", "counter", "S3 request attempts by operation and outcome.");
+    for (int op = 0; op < METRICS_OP_COUNT; op++) {
+        for (int success = 1; success >= 0; success--) {
+            oss << "s3upload_requests_total{operation=\"" << METRICS_OPERATION_NAMES[op] << "\",outcome=\""
+                << (success ? "success" : "failure") << "\"} " << requests_[op][success].load() << "\n";
+        }
+    }
+
+    writeMetricHeader(oss, "s3upload_retries_total", "counter", "Requests sent again, by error class.");
+    for (int errorClass = 0; errorClass < RETRY_CLASS_COUNT; errorClass++) {
+        oss << "s3upload_retries_total{class=\"" << METRICS_RETRY_CLASS_NAMES[errorClass] << "\"} "
+            << retries_[errorClass].load() << "\n";
+    }
+
+    writeMetricHeader(oss, "s3upload_retry_budget_exhausted_total", "counter",
+                      "Retries refused because the shared retry budget was empty.");
+    oss << "s3upload_retry_budget_exhausted_total " << retryBudgetExhausted_.load() << "\n";
+
+    writeMetricHeader(oss, "s3upload_connections_total", "counter",
+                      "Requests by whether they opened a new connection or reused a pooled one.");
+    oss << "s3upload_connections_total{reused=\"false\"} " << connectionsNew_.load() << "\n"
+        << "s3upload_connections_total{reused=\"true\"} " << connectionsReused_.load() << "\n";
+
+    writeMetricHeader(oss, "s3upload_uploads_finished_total", "counter", "Async uploads by final status.");
+    oss << "s3upload_uploads_finished_total{status=\"success\"} " << uploadsFinished_[UPLOAD_SUCCESS].load() << "\n"
+        << "s3upload_uploads_finished_total{status=\"failed\"} " << uploadsFinished_[UPLOAD_FAILED].load() << "\n"
+        << "s3upload_uploads_finished_total{status=\"cancelled\"} " << uploadsFinished_[UPLOAD_CANCELLED].load() << "\n";
+
+    writeMetricHeader(oss, "s3upload_upload_failures_total", "counter", "Failed async uploads by error code.");
+    for (int errorCode = UPLOAD_ERROR_NONE + 1; errorCode <= UPLOAD_ERROR_INTERNAL; errorCode++) {
+        oss << "s3upload_upload_failures_total{error=\"" << METRICS_ERROR_NAMES[errorCode] << "\"} "
+            << uploadErrors_[errorCode].load() << "\n";
+    }
+
+    // Step 2: Histograms
+    writeMetricHeader(oss, "s3upload_phase_seconds", "histogram",
+                      "Time finished async uploads spent in each phase (total = queued to finished).");
+    for (int phase = 0; phase < UPLOAD_PHASE_COUNT; phase++) {
+        phaseLatency_[phase].write(oss, "s3upload_phase_seconds",
+                                   String("phase=\"") + METRICS_PHASE_NAMES[phase] + "\"");
+    }
+
+    writeMetricHeader(oss, "s3upload_request_seconds", "histogram", "Latency of S3 request attempts by operation.");
+    for (int op = 0; op < METRICS_OP_COUNT; op++) {
+        requestLatency_[op].write(oss, "s3upload_request_seconds",
+                                  String("operation=\"") + METRICS_OPERATION_NAMES[op] + "\"");
+    }
+
+    writeMetricHeader(oss, "s3upload_connect_seconds", "histogram",
+                      "DNS, TCP and TLS setup time of requests that opened a new connection.");
+    connectLatency_.write(oss, "s3upload_connect_seconds", "");
+
+    writeMetricHeader(oss, "s3upload_retry_backoff_seconds", "histogram", "Backoff chosen before each retry.");
+    backoffLatency_.write(oss, "s3upload_retry_backoff_seconds", "");
+
+    // Step 3: Gauges read at scrape time
+    auto& pool = UploadWorkerPool::getInstance();
+    writeMetricHeader(oss, "s3upload_queue_depth", "gauge", "Async uploads waiting for a worker.");
+    oss << "s3upload_queue_depth " << pool.getQueuedJobs() << "\n";
+    writeMetricHeader(oss, "s3upload_workers_busy", "gauge", "Workers currently running an upload.");
+    oss << "s3upload_workers_busy " << pool.getBusyWorkers() << "\n";
+    writeMetricHeader(oss, "s3upload_workers", "gauge", "Configured number of upload workers.");
+    oss << "s3upload_workers " << pool.getWorkerCount() << "\n";
+    writeMetricHeader(oss, "s3upload_uploads_active", "gauge", "Async uploads queued or running.");
+    oss << "s3upload_uploads_active " << AsyncUploadManager::getInstance().getTotalUploads() << "\n";
+    size_t backlogMemory = 0;
+    size_t backlogSpilled = 0;
+    UploadBacklog::getInstance().getSizes(backlogMemory, backlogSpilled);
+    writeMetricHeader(oss, "s3upload_backlog_entries", "gauge", "Async uploads waiting in the submission backlog.");
+    oss << "s3upload_backlog_entries{location=\"memory\"} " << backlogMemory << "\n";
+    oss << "s3upload_backlog_entries{location=\"disk\"} " << backlogSpilled << "\n";
+    writeMetricHeader(oss, "s3upload_upload_history_entries", "gauge", "Finished async uploads kept in the history.");
+    oss << "s3upload_upload_history_entries " << AsyncUploadManager::getInstance().getHistorySize() << "\n";
+    writeMetricHeader(oss, "s3upload_retry_budget_available", "gauge", "Tokens left in the shared retry budget.");
+    oss << "s3upload_retry_budget_available " << RetryBudget::getInstance().getAvailable() << "\n";
+    writeMetricHeader(oss, "s3upload_client_cache_size", "gauge", "Cached S3 clients.");
+    oss << "s3upload_client_cache_size " << S3ClientCache::getInstance().getSize() << "\n";
+
+    return oss.str();
+}
+
+void recordUploadMetrics(const AsyncUploadProgress& progress) {
+    UploadMetrics::getInstance().recordUpload(progress);
+}
+
+// Get an HTTP client metric in milliseconds, -1 when the client did not report it
+static long long getHttpClientMetric(const Aws::Monitoring::CoreMetricsCollection& metrics,
+                                     Aws::Monitoring::HttpClientMetricsType type) {
+    auto it = metrics.httpClientMetrics.find(Aws::Monitoring::GetHttpClientMetricNameByType(type));
+    return it == metrics.httpClientMetrics.end() ? -1 : static_cast<long long>(it->second);
+}
+
+// SDK monitoring hook: one context per request, callbacks run on the sending thread
+class UploadMonitoring : public Aws::Monitoring::MonitoringInterface {
+private:
+    // Start of the current attempt
+    struct RequestContext {
+        std::chrono::steady_clock::time_point attemptStart;
+    };
+
+    static void recordAttempt(const Aws::String& requestName,
+                              const Aws::Monitoring::CoreMetricsCollection& metricsFromCore,
+                              void* context, bool success) {
+        auto* requestContext = static_cast<RequestContext*>(context);
+        long long latencyMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - requestContext->attemptStart).count();
+
+        // Step 1: Connection setup; the clients report DNS, connect and TLS times measured
+        // from the start of the request, so the largest one is the whole setup
+        using Aws::Monitoring::HttpClientMetricsType;
+        long long connectMs = std::max(getHttpClientMetric(metricsFromCore, HttpClientMetricsType::DnsLatency),
+                              std::max(getHttpClientMetric(metricsFromCore, HttpClientMetricsType::ConnectLatency),
+                                       getHttpClientMetric(metricsFromCore, HttpClientMetricsType::SslLatency)));
+        long long reused = getHttpClientMetric(metricsFromCore, HttpClientMetricsType::ConnectionReused);
+        UploadMetrics::getInstance().recordRequest(requestName.c_str(), success, latencyMs, connectMs,
+                                                   reused < 0 ? -1 : (reused != 0 ? 1 : 0));
+
+        // Step 2: Attribute the request to the async upload this thread is sending for
+        AsyncUploadProgress* progress = getCurrentAccountingUpload();
+        if (progress != nullptr) {
+            progress->requestCount++;
+            if (connectMs > 0) {
+                progress->connectMs += connectMs;
+            }
+        }
+    }
+
+public:
+    void* OnRequestStarted(const Aws::String&, const Aws::String&,
+                           const std::shared_ptr<const Aws::Http::HttpRequest>&) const override {
+        return new RequestContext{std::chrono::steady_clock::now()};
+    }
+
+    void OnRequestSucceeded(const Aws::String&, const Aws::String& requestName,
+                            const std::shared_ptr<const Aws::Http::HttpRequest>&,
+                            const Aws::Client::HttpResponseOutcome&,
+                            const Aws::Monitoring::CoreMetricsCollection& metricsFromCore,
+                            void* context) const override {
+        recordAttempt(requestName, metricsFromCore, context, true);
+    }
+
+    void OnRequestFailed(const Aws::String&, const Aws::String& requestName,
+                         const std::shared_ptr<const Aws::Http::HttpRequest>&,
+                         const Aws::Client::HttpResponseOutcome&,
+                         const Aws::Monitoring::CoreMetricsCollection& metricsFromCore,
+                         void* context) const override {
+        recordAttempt(requestName, metricsFromCore, context, false);
+    }
+
+    void OnRequestRetry(const Aws::String&, const Aws::String&,
+                        const std::shared_ptr<const Aws::Http::HttpRequest>&, void* context) const override {
+        static_cast<RequestContext*>(context)->attemptStart = std::chrono::steady_clock::now();
+    }
+
+    void OnFinish(const Aws::String&, const Aws::String&,
+                  const std::shared_ptr<const Aws::Http::HttpRequest>&, void* context) const override {
+        delete static_cast<RequestContext*>(context);
+    }
+};
+
+class UploadMonitoringFactory : public Aws::Monitoring::MonitoringFactory {
+public:
+    Aws::UniquePtr<Aws::Monitoring::MonitoringInterface> CreateMonitoringInstance() const override {
+        return Aws::MakeUnique<UploadMonitoring>("UploadMonitoring");
+    }
+};
+
+void registerUploadMonitoring(Aws::SDKOptions& options) {
+    auto& factories = options.monitoringOptions.customizedMonitoringFactory_create_fn;
+    factories.clear();
+    factories.push_back([]() -> Aws::UniquePtr<Aws::Monitoring::MonitoringFactory> {
+        return Aws::MakeUnique<UploadMonitoringFactory>("UploadMonitoringFactory");
+    });
+}
+
+// Process-wide upload metrics in Prometheus text format, for a local agent to scrape
+// Counters and histograms cover the whole process lifetime; gauges are read at call time.
+extern "C" S3UPLOAD_API const char* __stdcall GetUploadMetrics() {
+    static std::string response;
+
+    try {
+        response = UploadMetrics::getInstance().format();
+    }
+    catch (const std::exception& e) {
+        response = "# " + formatErrorMessage("Failed to collect upload metrics", e.what()) + "\n";
+    }
+    catch (...) {
+        response = "# " + formatErrorMessage("Failed to collect upload metrics", ErrorMessage::UNKNOWN_ERROR) + "\n";
+    }
+    return response.c_str();
+}
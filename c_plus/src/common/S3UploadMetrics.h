@@ -0,0 +1,110 @@
+#ifndef S3UPLOADMETRICS_H
+#define S3UPLOADMETRICS_H
+
+#include "S3Common.h"
+
+// Upper bounds of the latency histogram buckets (milliseconds); a final +Inf bucket catches the rest
+static const long long METRICS_LATENCY_BUCKETS_MS[] = {
+    5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000, 300000
+};
+static const int METRICS_LATENCY_BUCKET_COUNT =
+    static_cast<int>(sizeof(METRICS_LATENCY_BUCKETS_MS) / sizeof(METRICS_LATENCY_BUCKETS_MS[0]));
+
+// S3 operations counted separately; anything else is reported as "Other"
+enum MetricsOperation {
+    METRICS_OP_PUT_OBJECT = 0,
+    METRICS_OP_UPLOAD_PART = 1,
+    METRICS_OP_CREATE_MULTIPART_UPLOAD = 2,
+    METRICS_OP_COMPLETE_MULTIPART_UPLOAD = 3,
+    METRICS_OP_ABORT_MULTIPART_UPLOAD = 4,
+    METRICS_OP_LIST_PARTS = 5,
+    METRICS_OP_HEAD_OBJECT = 6,
+    METRICS_OP_OTHER = 7
+};
+static const int METRICS_OP_COUNT = METRICS_OP_OTHER + 1;
+
+// Why a request was retried (see getRetryErrorClass in S3RetryPolicy.h)
+enum RetryErrorClass {
+    // 429, 503 SlowDown and other throttling responses
+    RETRY_CLASS_THROTTLING = 0,
+    // Request timeouts
+    RETRY_CLASS_TIMEOUT = 1,
+    // Dropped connections, DNS and TLS failures (no response)
+    RETRY_CLASS_CONNECTION = 2,
+    // Other 5xx responses
+    RETRY_CLASS_SERVER = 3
+};
+static const int RETRY_CLASS_COUNT = RETRY_CLASS_SERVER + 1;
+
+// Fixed-bucket latency histogram updated without locks
+class LatencyHistogram {
+private:
+    std::atomic<long long> buckets_[METRICS_LATENCY_BUCKET_COUNT + 1];
+    std::atomic<long long> sumMs_;
+    std::atomic<long long> count_;
+
+public:
+    LatencyHistogram();
+
+    // Add one observation (negative values are ignored)
+    void observe(long long ms);
+
+    // Append the histogram in Prometheus text format, in seconds
+    // labels is either empty or a label list without braces, e.g. operation="PutObject"
+    void write(std::ostringstream& oss, const char* name, const String& labels) const;
+};
+
+// Process-wide upload counters and histograms, scraped through GetUploadMetrics
+// Request counts and latencies come from an SDK monitoring hook, so sync uploads,
+// async uploads and multipart parts are all covered; upload phases are added when
+// an async upload finishes.
+class UploadMetrics {
+private:
+    std::atomic<long long> bytesSent_;
+    std::atomic<long long> requests_[METRICS_OP_COUNT][2];
+    std::atomic<long long> retries_[RETRY_CLASS_COUNT];
+    std::atomic<long long> retryBudgetExhausted_;
+    std::atomic<long long> connectionsNew_;
+    std::atomic<long long> connectionsReused_;
+    std::atomic<long long> uploadsFinished_[UPLOAD_STATUS_COUNT];
+    std::atomic<long long> uploadErrors_[UPLOAD_ERROR_INTERNAL + 1];
+    LatencyHistogram phaseLatency_[UPLOAD_PHASE_COUNT];
+    LatencyHistogram requestLatency_[METRICS_OP_COUNT];
+    LatencyHistogram connectLatency_;
+    LatencyHistogram backoffLatency_;
+
+public:
+    UploadMetrics();
+
+    // Get singleton instance of the metrics
+    static UploadMetrics& getInstance();
+
+    // Bytes written by the HTTP clients, retried attempts included
+    void addBytesSent(long long bytes) { bytesSent_ += bytes; }
+
+    // One attempt of an S3 request finished; connectMs < 0 when the HTTP client did not report it
+    void recordRequest(const String& operation, bool success, long long latencyMs,
+                       long long connectMs, int connectionReused);
+
+    // A request is about to be sent again after backoffMs
+    void recordRetry(RetryErrorClass errorClass, long long backoffMs);
+
+    // A retry was refused because the shared retry budget ran out
+    void recordRetryBudgetExhausted() { retryBudgetExhausted_++; }
+
+    // An async upload reached a final status
+    void recordUpload(const AsyncUploadProgress& progress);
+
+    // Render all metrics and the current queue gauges in Prometheus text format
+    String format() const;
+};
+
+// Register the SDK monitoring hook that feeds UploadMetrics (before Aws::InitAPI)
+void registerUploadMonitoring(Aws::SDKOptions& options);
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall GetUploadMetrics();
+}
+
+// S3UPLOADMETRICS_H
+#endif
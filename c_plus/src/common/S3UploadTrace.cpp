@@ -0,0 +1,316 @@
+#include "S3UploadTrace.h"
+
+#include <fstream>
+
+std::atomic<bool> g_uploadTraceEnabled(false);
+
+// Bumped each time tracing is switched on; only spans of the current trace are dumped
+static std::atomic<long long> g_traceGeneration(0);
+// Trace clock time when tracing was last switched on; spans ending earlier are not dumped
+static std::atomic<long long> g_traceStartMicros(0);
+
+// Span names, indexed by TraceSpanKind
+static const char* const TRACE_SPAN_NAMES[] = {
+    "queue wait", "upload", "client acquire", "file open", "PutObject", "UploadPart",
+    "CreateMultipartUpload", "CompleteMultipartUpload", "backoff"
+};
+
+// One recorded span; written by the owning thread only, read by DumpUploadTrace
+// sequence is odd while the slot is being written, so a reader can skip torn copies.
+struct TraceSpanSlot {
+    std::atomic<unsigned long long> sequence;
+    std::atomic<long long> uploadKey;
+    // Kind (bits 48-55), attempt (bits 32-47) and part number (bits 0-31)
+    std::atomic<long long> info;
+    std::atomic<long long> startMicros;
+    std::atomic<long long> endMicros;
+};
+
+// Ring of spans owned by one thread at a time
+// A buffer outlives its thread and is handed to the next thread that starts tracing,
+// so short-lived multipart part threads do not each leave a buffer behind.
+struct TraceBuffer {
+    int threadId;
+    std::atomic<const char*> threadName;
+    // Spans written so far; the next one goes to slot written % TRACE_BUFFER_SPANS
+    std::atomic<unsigned long long> written;
+    std::unique_ptr<TraceSpanSlot[]> slots;
+
+    explicit TraceBuffer(int id)
+        : threadId(id), threadName(nullptr), written(0), slots(new TraceSpanSlot[TRACE_BUFFER_SPANS]()) {}
+};
+
+// Owns the buffers and the uploads named in the current trace
+// Its mutex is taken when a thread records its first span and when an upload
+// gets its id in a trace, never for the spans themselves.
+class TraceRegistry {
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+    std::vector<TraceBuffer*> freeBuffers_;
+    // uploadId and dataId of each upload in the current trace (id = index + 1)
+    std::vector<std::pair<String, String>> uploads_;
+
+public:
+    static TraceRegistry& getInstance() {
+        static TraceRegistry instance;
+        return instance;
+    }
+
+    // Get a buffer for a thread that starts tracing
+    TraceBuffer* acquireBuffer(const char* threadName) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TraceBuffer* buffer = nullptr;
+        if (!freeBuffers_.empty()) {
+            buffer = freeBuffers_.back();
+            freeBuffers_.pop_back();
+        } else {
+            buffers_.emplace_back(new TraceBuffer(static_cast<int>(buffers_.size()) + 1));
+            buffer = buffers_.back().get();
+        }
+        buffer->threadName = threadName;
+        return buffer;
+    }
+
+    // Hand a buffer back when its thread exits (its spans stay in it)
+    void releaseBuffer(TraceBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeBuffers_.push_back(buffer);
+    }
+
+    // Give an upload an id in the given trace; id 0 if that trace was replaced meanwhile
+    long long registerUpload(const String& uploadId, const String& dataId, long long generation) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation != g_traceGeneration.load()) {
+            return generation << 32;
+        }
+        uploads_.emplace_back(uploadId, dataId);
+        return (generation << 32) | static_cast<long long>(uploads_.size());
+    }
+
+    // Start a new trace: forget the uploads of the previous one
+    void startTrace() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uploads_.clear();
+        g_traceStartMicros = getUploadTraceMicros();
+        g_traceGeneration++;
+    }
+
+    // Copy what a dump needs; buffers are never freed, so the pointers stay valid
+    void snapshot(std::vector<TraceBuffer*>& buffers, std::vector<std::pair<String, String>>& uploads,
+                  long long& generation) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            buffers.push_back(buffer.get());
+        }
+        uploads = uploads_;
+        generation = g_traceGeneration.load();
+    }
+};
+
+// The calling thread's buffer and name
+struct ThreadTraceState {
+    TraceBuffer* buffer;
+    const char* name;
+
+    ThreadTraceState() : buffer(nullptr), name(nullptr) {}
+    ~ThreadTraceState() {
+        if (buffer) {
+            TraceRegistry::getInstance().releaseBuffer(buffer);
+        }
+    }
+};
+
+static thread_local ThreadTraceState t_traceState;
+
+// Get the upload's key in the current trace, registering it on first use
+static long long getTraceUploadKey(AsyncUploadProgress& progress) {
+    long long generation = g_traceGeneration.load();
+    long long key = progress.traceKey.load();
+    if ((key >> 32) == generation) {
+        return key;
+    }
+    long long newKey = TraceRegistry::getInstance().registerUpload(progress.uploadId, progress.dataId, generation);
+    // Part threads may register the same upload at once; the first key stored wins
+    if (!progress.traceKey.compare_exchange_strong(key, newKey) && (key >> 32) == generation) {
+        return key;
+    }
+    return newKey;
+}
+
+void recordUploadTraceSpan(TraceSpanKind kind, AsyncUploadProgress& progress,
+                           long long startMicros, long long endMicros,
+                           int partNumber, int attempt) {
+    // Step 1: First span of this thread takes a buffer
+    if (!t_traceState.buffer) {
+        t_traceState.buffer = TraceRegistry::getInstance().acquireBuffer(t_traceState.name);
+    }
+    TraceBuffer& buffer = *t_traceState.buffer;
+
+    // Step 2: Write the next slot; readers check the sequence around their copy
+    long long uploadKey = getTraceUploadKey(progress);
+    long long info = (static_cast<long long>(kind) << 48) |
+                     (static_cast<long long>(attempt & 0xFFFF) << 32) |
+                     static_cast<long long>(static_cast<unsigned int>(partNumber));
+    unsigned long long index = buffer.written.load(std::memory_order_relaxed);
+    TraceSpanSlot& slot = buffer.slots[index % TRACE_BUFFER_SPANS];
+    unsigned long long sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.uploadKey.store(uploadKey, std::memory_order_relaxed);
+    slot.info.store(info, std::memory_order_relaxed);
+    slot.startMicros.store(startMicros, std::memory_order_relaxed);
+    slot.endMicros.store(endMicros, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void setUploadTraceThreadName(const char* name) {
+    t_traceState.name = name;
+    if (t_traceState.buffer) {
+        t_traceState.buffer->threadName = name;
+    }
+}
+
+// Write the common fields of a trace event for a span
+static void writeTraceEventFields(std::ostream& out, const char* name, const char* category, char phase,
+                                  long long timestamp, int threadId) {
+    out << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"" << phase << "\","
+        << "\"ts\":" << timestamp << ",\"pid\":1,\"tid\":" << threadId;
+}
+
+// Write the args object naming the upload (and part and attempt when known)
+static void writeTraceEventArgs(std::ostream& out, const std::pair<String, String>& upload,
+                                int partNumber, int attempt) {
+    out << ",\"args\":{\"uploadId\":\"" << escapeJson(upload.first) << "\","
+        << "\"dataId\":\"" << escapeJson(upload.second) << "\"";
+    if (partNumber > 0) {
+        out << ",\"part\":" << partNumber;
+    }
+    if (attempt > 0) {
+        out << ",\"attempt\":" << attempt;
+    }
+    out << "}}";
+}
+
+// Write the current trace as Chrome trace-event JSON; returns the number of spans written
+static size_t writeUploadTrace(std::ostream& out) {
+    std::vector<TraceBuffer*> buffers;
+    std::vector<std::pair<String, String>> uploads;
+    long long generation = 0;
+    TraceRegistry::getInstance().snapshot(buffers, uploads, generation);
+    long long traceStart = g_traceStartMicros.load();
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"S3UploadLib\"}}";
+
+    size_t spanCount = 0;
+    for (TraceBuffer* buffer : buffers) {
+        // Step 1: Name the thread after whoever owns the buffer now
+        const char* threadName = buffer->threadName.load();
+        out << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"" << (threadName ? threadName : "host thread") << " "
+            << buffer->threadId << "\"}}";
+
+        // Step 2: Copy each retained slot, skipping slots rewritten during the copy
+        unsigned long long written = buffer->written.load(std::memory_order_acquire);
+        unsigned long long first = written > TRACE_BUFFER_SPANS ? written - TRACE_BUFFER_SPANS : 0;
+        for (unsigned long long index = first; index < written; index++) {
+            const TraceSpanSlot& slot = buffer->slots[index % TRACE_BUFFER_SPANS];
+            unsigned long long sequence = slot.sequence.load(std::memory_order_acquire);
+            long long uploadKey = slot.uploadKey.load(std::memory_order_relaxed);
+            long long info = slot.info.load(std::memory_order_relaxed);
+            long long startMicros = slot.startMicros.load(std::memory_order_relaxed);
+            long long endMicros = slot.endMicros.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((sequence & 1) != 0 || sequence != slot.sequence.load(std::memory_order_relaxed)) {
+                continue;
+            }
+
+            // Step 3: Keep spans of uploads named in the current trace
+            size_t uploadIndex = static_cast<size_t>(uploadKey & 0xFFFFFFFFLL);
+            if ((uploadKey >> 32) != generation || uploadIndex == 0 || uploadIndex > uploads.size() ||
+                endMicros < traceStart) {
+                continue;
+            }
+            const auto& upload = uploads[uploadIndex - 1];
+            int kind = static_cast<int>((info >> 48) & 0xFF);
+            int attempt = static_cast<int>((info >> 32) & 0xFFFF);
+            int partNumber = static_cast<int>(info & 0xFFFFFFFFLL);
+            long long start = std::max(startMicros, traceStart) - traceStart;
+            long long end = endMicros - traceStart;
+
+            // Step 4: Queue waits overlap on no particular thread, so they are async events
+            // (one row per upload); everything else nests on the thread that ran it
+            if (kind == TRACE_SPAN_QUEUE) {
+                out << ",";
+                writeTraceEventFields(out, TRACE_SPAN_NAMES[kind], "queue", 'b', start, buffer->threadId);
+                out << ",\"id\":" << uploadIndex;
+                writeTraceEventArgs(out, upload, 0, 0);
+                out << ",";
+                writeTraceEventFields(out, TRACE_SPAN_NAMES[kind], "queue", 'e', end, buffer->threadId);
+                out << ",\"id\":" << uploadIndex << "}";
+            } else {
+                out << ",";
+                writeTraceEventFields(out, TRACE_SPAN_NAMES[kind], "upload", 'X', start, buffer->threadId);
+                out << ",\"dur\":" << (end - start);
+                writeTraceEventArgs(out, upload, partNumber, attempt);
+            }
+            spanCount++;
+        }
+    }
+
+    out << "]}";
+    return spanCount;
+}
+
+// Switch span recording for async uploads on (1) or off (0)
+// Switching on starts a new trace; switching off keeps the spans for DumpUploadTrace.
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadTrace(long enabled) {
+    static std::string response;
+
+    if (enabled) {
+        if (!g_uploadTraceEnabled.load()) {
+            TraceRegistry::getInstance().startTrace();
+        }
+        g_uploadTraceEnabled = true;
+        response = create_response(UPLOAD_SUCCESS, "Upload tracing enabled");
+    } else {
+        g_uploadTraceEnabled = false;
+        response = create_response(UPLOAD_SUCCESS, "Upload tracing disabled");
+    }
+    return response.c_str();
+}
+
+// Write the spans of the current trace to path as Chrome trace-event JSON
+// (open in chrome://tracing or https://ui.perfetto.dev). Can be called while tracing.
+extern "C" S3UPLOAD_API const char* __stdcall DumpUploadTrace(const char* path) {
+    static std::string response;
+
+    if (!path || !*path) {
+        response = create_response(UPLOAD_FAILED, ErrorMessage::INVALID_PARAMETERS);
+        return response.c_str();
+    }
+
+    try {
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            response = create_response(UPLOAD_FAILED, formatErrorMessage("Cannot write trace file", path));
+            return response.c_str();
+        }
+        size_t spanCount = writeUploadTrace(out);
+        out.close();
+        if (out.fail()) {
+            response = create_response(UPLOAD_FAILED, formatErrorMessage("Cannot write trace file", path));
+            return response.c_str();
+        }
+        response = create_response(UPLOAD_SUCCESS, "Wrote " + std::to_string(spanCount) + " span(s) to " + path);
+    }
+    catch (const std::exception& e) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to write upload trace", e.what()));
+    }
+    catch (...) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to write upload trace", ErrorMessage::UNKNOWN_ERROR));
+    }
+    return response.c_str();
+}
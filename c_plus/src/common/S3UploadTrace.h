@@ -0,0 +1,96 @@
+#ifndef S3UPLOADTRACE_H
+#define S3UPLOADTRACE_H
+
+#include "S3Common.h"
+
+// Spans kept per thread; once full, a thread's oldest spans are overwritten (40 bytes each)
+static const size_t TRACE_BUFFER_SPANS = 16384;
+
+// What a trace span covers
+enum TraceSpanKind {
+    // Waiting in the worker pool queue (an async event, outside the worker threads)
+    TRACE_SPAN_QUEUE = 0,
+    // Whole run of an upload on a worker thread
+    TRACE_SPAN_UPLOAD = 1,
+    // Getting the S3 client from the cache
+    TRACE_SPAN_CLIENT = 2,
+    // Opening the request body (file, part range or bundle)
+    TRACE_SPAN_OPEN = 3,
+    // One PutObject attempt
+    TRACE_SPAN_PUT_OBJECT = 4,
+    // One UploadPart attempt
+    TRACE_SPAN_UPLOAD_PART = 5,
+    // One CreateMultipartUpload attempt
+    TRACE_SPAN_CREATE_MULTIPART = 6,
+    // One CompleteMultipartUpload attempt
+    TRACE_SPAN_COMPLETE_MULTIPART = 7,
+    // Backoff before a retry
+    TRACE_SPAN_BACKOFF = 8
+};
+
+// Set while SetUploadTrace has tracing on; read with one relaxed load per span
+extern std::atomic<bool> g_uploadTraceEnabled;
+
+// Check whether spans are being recorded
+inline bool isUploadTraceEnabled() {
+    return g_uploadTraceEnabled.load(std::memory_order_relaxed);
+}
+
+// Get a steady clock time point in trace clock units (microseconds)
+inline long long toUploadTraceMicros(const std::chrono::steady_clock::time_point& timePoint) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(timePoint.time_since_epoch()).count();
+}
+
+// Get the current trace clock time (microseconds)
+inline long long getUploadTraceMicros() {
+    return toUploadTraceMicros(std::chrono::steady_clock::now());
+}
+
+// Record a finished span for an upload into the calling thread's buffer
+// The buffer is written by its own thread only, so recording takes no lock.
+void recordUploadTraceSpan(TraceSpanKind kind, AsyncUploadProgress& progress,
+                           long long startMicros, long long endMicros,
+                           int partNumber = 0, int attempt = 0);
+
+// Name the calling thread in traces (a string literal; the pointer is kept)
+void setUploadTraceThreadName(const char* name);
+
+// Records a span from construction to destruction when tracing is on
+// Costs one relaxed load when tracing is off, or when progress is nullptr (sync uploads).
+class UploadTraceSpan {
+private:
+    AsyncUploadProgress* progress_;
+    TraceSpanKind kind_;
+    int partNumber_;
+    int attempt_;
+    long long startMicros_;
+
+public:
+    UploadTraceSpan(TraceSpanKind kind, AsyncUploadProgress* progress, int partNumber = 0, int attempt = 0)
+        : progress_(progress && isUploadTraceEnabled() ? progress : nullptr),
+          kind_(kind), partNumber_(partNumber), attempt_(attempt),
+          startMicros_(progress_ ? getUploadTraceMicros() : 0) {}
+
+    ~UploadTraceSpan() {
+        end();
+    }
+
+    // End the span before the scope does (later calls do nothing)
+    void end() {
+        if (progress_) {
+            recordUploadTraceSpan(kind_, *progress_, startMicros_, getUploadTraceMicros(), partNumber_, attempt_);
+            progress_ = nullptr;
+        }
+    }
+
+    UploadTraceSpan(const UploadTraceSpan&) = delete;
+    UploadTraceSpan& operator=(const UploadTraceSpan&) = delete;
+};
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetUploadTrace(long enabled);
+    S3UPLOAD_API const char* __stdcall DumpUploadTrace(const char* path);
+}
+
+// S3UPLOADTRACE_H
+#endif
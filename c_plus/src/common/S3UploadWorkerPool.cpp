@@ -0,0 +1,414 @@
+#include "S3UploadWorkerPool.h"
+#include "S3UploadTrace.h"
+
+static long long steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+UploadWorkerPool::UploadWorkerPool()
+    : schedulingMode_(SCHEDULE_FAIR),
+      queuePositionsDirty_(false),
+      targetWorkers_(DEFAULT_CONCURRENT_UPLOADS),
+      runningWorkers_(0),
+      busyWorkers_(0),
+      started_(false),
+      stopping_(false) {}
+
+UploadWorkerPool::~UploadWorkerPool() {
+    // Threads are normally joined in stop(); at process exit they are already gone,
+    // so only detach here to avoid std::terminate on joinable threads
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.detach();
+        }
+    }
+}
+
+UploadWorkerPool& UploadWorkerPool::getInstance() {
+    static UploadWorkerPool instance;
+    return instance;
+}
+
+void UploadWorkerPool::spawnWorkersLocked() {
+    while (runningWorkers_ < targetWorkers_) {
+        workers_.emplace_back(&UploadWorkerPool::workerLoop, this);
+        runningWorkers_++;
+    }
+}
+
+void UploadWorkerPool::takeExitedWorkersLocked(std::vector<std::thread>& exited) {
+    for (const auto& workerId : exitedWorkers_) {
+        auto workerIt = std::find_if(workers_.begin(), workers_.end(), [&workerId](const std::thread& worker) {
+            return worker.get_id() == workerId;
+        });
+        if (workerIt != workers_.end()) {
+            exited.push_back(std::move(*workerIt));
+            workers_.erase(workerIt);
+        }
+    }
+    exitedWorkers_.clear();
+}
+
+void UploadWorkerPool::joinWorkers(std::vector<std::thread>& workers) {
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+bool UploadWorkerPool::popNextEntry(PriorityLevels& levels, UploadSchedulingMode mode, long long nowMs,
+                                    QueueEntry& entry) {
+    // Step 1: Only the highest priority with queued jobs is considered (empty levels are removed)
+    auto levelIt = levels.begin();
+    if (levelIt == levels.end()) {
+        return false;
+    }
+    PriorityLevel& level = levelIt->second;
+
+    // Step 2: Choose the dataId
+    // Fair: next in the rotation. Shortest first: fewest queued bytes, unless a job waited too long.
+    auto chosenIt = level.rotation.begin();
+    bool aged = false;
+    if (mode == SCHEDULE_SHORTEST_FIRST) {
+        long long fewestBytes = -1;
+        long long oldestEnqueueMs = nowMs - SCHEDULER_AGING_MS;
+        for (auto it = level.rotation.begin(); it != level.rotation.end(); ++it) {
+            const DataIdQueue& queue = level.queues[*it];
+            if (queue.entries.front().enqueueTimeMs <= oldestEnqueueMs) {
+                oldestEnqueueMs = queue.entries.front().enqueueTimeMs;
+                chosenIt = it;
+                aged = true;
+            } else if (!aged && (fewestBytes < 0 || queue.queuedBytes < fewestBytes)) {
+                fewestBytes = queue.queuedBytes;
+                chosenIt = it;
+            }
+        }
+    }
+    String dataId = *chosenIt;
+    DataIdQueue& queue = level.queues[dataId];
+
+    // Step 3: Choose the job within the dataId (arrival order, or smallest file)
+    auto entryIt = queue.entries.begin();
+    if (mode == SCHEDULE_SHORTEST_FIRST && !aged) {
+        for (auto it = queue.entries.begin(); it != queue.entries.end(); ++it) {
+            if (it->size < entryIt->size) {
+                entryIt = it;
+            }
+        }
+    }
+    entry = *entryIt;
+    queue.entries.erase(entryIt);
+    queue.queuedBytes -= entry.size;
+
+    // Step 4: The dataId takes its next turn after every other dataId of this priority
+    level.rotation.erase(chosenIt);
+    if (queue.entries.empty()) {
+        level.queues.erase(dataId);
+    } else {
+        level.rotation.push_back(dataId);
+    }
+    if (level.rotation.empty()) {
+        levels.erase(levelIt);
+    }
+    return true;
+}
+
+AsyncUploadJob UploadWorkerPool::takeNextJobLocked() {
+    QueueEntry entry;
+    popNextEntry(levels_, schedulingMode_, steadyNowMs(), entry);
+    auto jobIt = queuedJobs_.find(entry.uploadId);
+    AsyncUploadJob job = jobIt->second;
+    queuedJobs_.erase(jobIt);
+    queuePositionsDirty_ = true;
+    return job;
+}
+
+void UploadWorkerPool::removeQueuedJobLocked(std::unordered_map<String, AsyncUploadJob>::iterator jobIt) {
+    const AsyncUploadJob& job = jobIt->second;
+    int priority = std::max(MIN_UPLOAD_PRIORITY, std::min(job.priority, MAX_UPLOAD_PRIORITY));
+    auto levelIt = levels_.find(priority);
+    if (levelIt != levels_.end()) {
+        PriorityLevel& level = levelIt->second;
+        auto queueIt = level.queues.find(job.dataId);
+        if (queueIt != level.queues.end()) {
+            DataIdQueue& queue = queueIt->second;
+            for (auto it = queue.entries.begin(); it != queue.entries.end(); ++it) {
+                if (it->uploadId == job.uploadId) {
+                    queue.queuedBytes -= it->size;
+                    queue.entries.erase(it);
+                    break;
+                }
+            }
+            if (queue.entries.empty()) {
+                level.queues.erase(queueIt);
+                level.rotation.erase(std::find(level.rotation.begin(), level.rotation.end(), job.dataId));
+            }
+        }
+        if (level.rotation.empty()) {
+            levels_.erase(levelIt);
+        }
+    }
+    queuedJobs_.erase(jobIt);
+    queuePositionsDirty_ = true;
+}
+
+void UploadWorkerPool::workerLoop() {
+    setUploadTraceThreadName("upload worker");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Step 1: Wait for a job, a shutdown or a shrink request
+        jobAvailable_.wait(lock, [this] {
+            return stopping_ || !queuedJobs_.empty() || runningWorkers_ > targetWorkers_;
+        });
+
+        // Step 2: Leave the pool when stopping or when there are too many workers
+        // (a retired thread is joined by the next start, cancel or resize)
+        if (stopping_ || runningWorkers_ > targetWorkers_) {
+            runningWorkers_--;
+            exitedWorkers_.push_back(std::this_thread::get_id());
+            return;
+        }
+
+        // Step 3: Take the next job in scheduling order and run it without holding the pool lock
+        AsyncUploadJob job = takeNextJobLocked();
+        busyWorkers_++;
+        runningJobs_.insert(job.uploadId);
+        lock.unlock();
+
+        try {
+            asyncUploadWorker(job);
+        } catch (...) {
+            // asyncUploadWorker reports its own errors; never let one kill the worker
+            AWS_LOGSTREAM_ERROR("S3Upload", "Unhandled exception in upload worker for ID: " << job.uploadId);
+        }
+
+        // Step 4: A worker whose job was cancelled already handed its slot to a new worker
+        lock.lock();
+        runningJobs_.erase(job.uploadId);
+        if (releasedJobs_.erase(job.uploadId) > 0) {
+            exitedWorkers_.push_back(std::this_thread::get_id());
+            return;
+        }
+        busyWorkers_--;
+    }
+}
+
+void UploadWorkerPool::start() {
+    std::vector<std::thread> exitedWorkers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (started_) {
+            return;
+        }
+        takeExitedWorkersLocked(exitedWorkers);
+        started_ = true;
+        stopping_ = false;
+        spawnWorkersLocked();
+        AWS_LOGSTREAM_INFO("S3Upload", "Upload worker pool started with " << targetWorkers_ << " workers");
+    }
+    joinWorkers(exitedWorkers);
+}
+
+std::vector<AsyncUploadJob> UploadWorkerPool::stop() {
+    std::vector<AsyncUploadJob> remainingJobs;
+    std::vector<std::thread> workersToJoin;
+    std::vector<String> runningUploads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            return remainingJobs;
+        }
+        while (!queuedJobs_.empty()) {
+            remainingJobs.push_back(takeNextJobLocked());
+        }
+        stopping_ = true;
+        workersToJoin.swap(workers_);
+        runningUploads.assign(runningJobs_.begin(), runningJobs_.end());
+    }
+    jobAvailable_.notify_all();
+
+    // Cancel the running uploads instead of letting them send the rest of their files: requests
+    // in flight stop within one body chunk and backoffs within RETRY_CANCEL_CHECK_MS, and the
+    // workers report them cancelled. Journaled multipart uploads stay resumable (ResumeUploads).
+    auto& manager = AsyncUploadManager::getInstance();
+    for (const auto& uploadId : runningUploads) {
+        auto progress = manager.getUpload(uploadId);
+        if (progress) {
+            progress->cancelledForShutdown = true;
+            progress->shouldCancel = true;
+        }
+    }
+
+    // Each worker exits once its upload has wound down
+    joinWorkers(workersToJoin);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    started_ = false;
+    stopping_ = false;
+    runningWorkers_ = 0;
+    busyWorkers_ = 0;
+    exitedWorkers_.clear();
+    return remainingJobs;
+}
+
+bool UploadWorkerPool::submit(const AsyncUploadJob& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_ || stopping_) {
+            return false;
+        }
+
+        // Unknown sizes count as empty: such files usually fail fast (missing or unreadable)
+        QueueEntry entry;
+        entry.uploadId = job.uploadId;
+        entry.size = std::max(0LL, job.sizeHint);
+        entry.enqueueTimeMs = steadyNowMs();
+
+        int priority = std::max(MIN_UPLOAD_PRIORITY, std::min(job.priority, MAX_UPLOAD_PRIORITY));
+        PriorityLevel& level = levels_[priority];
+        auto queueIt = level.queues.find(job.dataId);
+        if (queueIt == level.queues.end()) {
+            queueIt = level.queues.emplace(job.dataId, DataIdQueue()).first;
+            level.rotation.push_back(job.dataId);
+        }
+        queueIt->second.entries.push_back(entry);
+        queueIt->second.queuedBytes += entry.size;
+        queuedJobs_[job.uploadId] = job;
+        queuePositionsDirty_ = true;
+    }
+    jobAvailable_.notify_one();
+    return true;
+}
+
+bool UploadWorkerPool::cancel(const String& uploadId) {
+    std::vector<std::thread> exitedWorkers;
+    bool cancelled = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        takeExitedWorkersLocked(exitedWorkers);
+
+        // Step 1: A queued job never starts
+        auto jobIt = queuedJobs_.find(uploadId);
+        if (jobIt != queuedJobs_.end()) {
+            removeQueuedJobLocked(jobIt);
+            cancelled = true;
+        } else if (runningJobs_.find(uploadId) != runningJobs_.end() && releasedJobs_.insert(uploadId).second) {
+            // Step 2: A running job keeps its thread until the aborted request returns, but no
+            // longer holds a slot; a new worker picks up the next queued job meanwhile
+            busyWorkers_--;
+            runningWorkers_--;
+            if (started_ && !stopping_) {
+                spawnWorkersLocked();
+            }
+            cancelled = true;
+        }
+    }
+
+    // Step 3: Join workers that left the pool earlier (a released one exits after its upload)
+    joinWorkers(exitedWorkers);
+    return cancelled;
+}
+
+void UploadWorkerPool::setWorkerCount(int count) {
+    count = std::max(1, std::min(count, MAX_CONCURRENT_UPLOADS));
+    std::vector<std::thread> exitedWorkers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        takeExitedWorkersLocked(exitedWorkers);
+        targetWorkers_ = count;
+        if (started_ && !stopping_) {
+            spawnWorkersLocked();
+        }
+    }
+    // Wake idle workers so extra ones can retire after a shrink
+    jobAvailable_.notify_all();
+    joinWorkers(exitedWorkers);
+}
+
+int UploadWorkerPool::getWorkerCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targetWorkers_;
+}
+
+void UploadWorkerPool::setSchedulingMode(UploadSchedulingMode mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedulingMode_ = mode;
+    queuePositionsDirty_ = true;
+}
+
+std::vector<size_t> UploadWorkerPool::getQueuePositions(const std::vector<String>& uploadIds) const {
+    std::vector<size_t> positions(uploadIds.size(), 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queuedJobs_.empty()) {
+        return positions;
+    }
+
+    // Replay the scheduler on a copy; cached until the queue or the mode changes
+    if (queuePositionsDirty_) {
+        queuePositions_.clear();
+        PriorityLevels levels = levels_;
+        long long nowMs = steadyNowMs();
+        QueueEntry entry;
+        size_t position = 0;
+        while (popNextEntry(levels, schedulingMode_, nowMs, entry)) {
+            queuePositions_[entry.uploadId] = ++position;
+        }
+        queuePositionsDirty_ = false;
+    }
+    for (size_t i = 0; i < uploadIds.size(); i++) {
+        auto it = queuePositions_.find(uploadIds[i]);
+        if (it != queuePositions_.end()) {
+            positions[i] = it->second;
+        }
+    }
+    return positions;
+}
+
+size_t UploadWorkerPool::getQueuedJobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queuedJobs_.size();
+}
+
+int UploadWorkerPool::getBusyWorkers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return busyWorkers_;
+}
+
+bool UploadWorkerPool::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return started_ && !stopping_;
+}
+
+// Set the number of async uploads that run at the same time
+// Can be called before or after InitializeAwsSDK
+extern "C" S3UPLOAD_API const char* __stdcall SetMaxConcurrentUploads(long maxUploads) {
+    static std::string response;
+
+    if (maxUploads <= 0) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    auto& pool = UploadWorkerPool::getInstance();
+    pool.setWorkerCount(static_cast<int>(std::min<long>(maxUploads, MAX_CONCURRENT_UPLOADS)));
+    response = create_response(UPLOAD_SUCCESS, "Max concurrent uploads set to " + std::to_string(pool.getWorkerCount()));
+    return response.c_str();
+}
+
+// Choose how queued uploads of the same priority are ordered
+// 0 = fair (round-robin across dataIds, FIFO within one), 1 = shortest first
+extern "C" S3UPLOAD_API const char* __stdcall SetUploadScheduling(long mode) {
+    static std::string response;
+
+    if (mode != SCHEDULE_FAIR && mode != SCHEDULE_SHORTEST_FIRST) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    UploadWorkerPool::getInstance().setSchedulingMode(static_cast<UploadSchedulingMode>(mode));
+    response = create_response(UPLOAD_SUCCESS, mode == SCHEDULE_FAIR
+        ? "Upload scheduling set to fair" : "Upload scheduling set to shortest first");
+    return response.c_str();
+}
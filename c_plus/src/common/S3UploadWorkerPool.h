@@ -0,0 +1,173 @@
+#ifndef S3UPLOADWORKERPOOL_H
+#define S3UPLOADWORKERPOOL_H
+
+#include "S3Common.h"
+
+// Worker pool configuration
+// Number of uploads running at the same time by default
+static const int DEFAULT_CONCURRENT_UPLOADS = 4;
+// Upper bound for the concurrent upload setting
+static const int MAX_CONCURRENT_UPLOADS = 16;
+
+// Upload priorities (UploadFileAsyncEx); a higher priority always starts first
+static const int MIN_UPLOAD_PRIORITY = -100;
+static const int DEFAULT_UPLOAD_PRIORITY = 0;
+static const int MAX_UPLOAD_PRIORITY = 100;
+// In shortest-first mode a job waiting this long runs next regardless of size (no starvation)
+static const long long SCHEDULER_AGING_MS = 10LL * 60 * 1000;
+
+// Order in which queued uploads of the same priority start
+enum UploadSchedulingMode {
+    // Round-robin across dataIds, FIFO within a dataId
+    SCHEDULE_FAIR = 0,
+    // dataId with the fewest queued bytes first, smallest file first within it,
+    // so more studies finish (and become viewable) sooner
+    SCHEDULE_SHORTEST_FIRST = 1
+};
+
+// Everything a worker needs to run one async upload
+struct AsyncUploadJob {
+    String uploadId;
+    String accessKey;
+    String secretKey;
+    String sessionToken;
+    String region;
+    String bucketName;
+    String objectKey;
+    String localFilePath;
+    String dataId;
+    // Scheduling priority, MIN_UPLOAD_PRIORITY..MAX_UPLOAD_PRIORITY
+    int priority;
+    // File size used for shortest-first scheduling (-1 if unknown)
+    long long sizeHint;
+    // Small files uploaded as one tar bundle; localFilePath is then the folder
+    std::shared_ptr<const UploadBundle> bundle;
+
+    AsyncUploadJob() : priority(DEFAULT_UPLOAD_PRIORITY), sizeHint(-1) {}
+};
+
+// Runs one queued upload on a pool thread (implemented in S3UploadAsync.cpp)
+void asyncUploadWorker(const AsyncUploadJob& job);
+
+// Fixed-size worker pool for async uploads - thread-safe singleton
+// Uploads are queued and picked up by a bounded set of long-lived threads,
+// so the number of threads does not grow with the number of files.
+// Queued jobs start by priority, then by the scheduling mode across and within dataIds.
+class UploadWorkerPool {
+private:
+    // Scheduling view of one queued job (the job itself stays in queuedJobs_)
+    struct QueueEntry {
+        String uploadId;
+        long long size;
+        long long enqueueTimeMs;
+    };
+
+    // Queued jobs of one dataId in arrival order
+    struct DataIdQueue {
+        std::deque<QueueEntry> entries;
+        long long queuedBytes;
+
+        DataIdQueue() : queuedBytes(0) {}
+    };
+
+    // Queued jobs of one priority; rotation holds the dataIds in round-robin order
+    struct PriorityLevel {
+        std::unordered_map<String, DataIdQueue> queues;
+        std::deque<String> rotation;
+    };
+
+    typedef std::map<int, PriorityLevel, std::greater<int>> PriorityLevels;
+
+    mutable std::mutex mutex_;                  // Protects all members below
+    std::condition_variable jobAvailable_;      // Signalled when a job is queued or the pool stops
+    PriorityLevels levels_;                     // Scheduling state, highest priority first
+    std::unordered_map<String, AsyncUploadJob> queuedJobs_;  // Upload ID to job waiting for a worker
+    UploadSchedulingMode schedulingMode_;       // Order within a priority level
+    mutable std::unordered_map<String, size_t> queuePositions_;  // Upload ID to 1-based start order
+    mutable bool queuePositionsDirty_;          // queuePositions_ must be rebuilt
+    std::vector<std::thread> workers_;          // Threads started by the pool and not joined yet
+    std::vector<std::thread::id> exitedWorkers_;  // Workers that left the pool, joined on the next change
+    int targetWorkers_;                         // Configured number of workers
+    int runningWorkers_;                        // Workers currently alive
+    int busyWorkers_;                           // Workers currently running an upload
+    std::unordered_set<String> runningJobs_;    // Upload IDs of the jobs being run
+    std::unordered_set<String> releasedJobs_;   // Running jobs whose worker gave its slot up (cancelled)
+    bool started_;                              // Pool accepts and runs jobs
+    bool stopping_;                             // Pool is shutting down
+
+    // Worker thread main loop
+    void workerLoop();
+
+    // Start threads until runningWorkers_ reaches targetWorkers_ (mutex_ must be held)
+    void spawnWorkersLocked();
+
+    // Move the threads of exited workers out of workers_ so the caller joins them after
+    // releasing the lock (mutex_ must be held)
+    void takeExitedWorkersLocked(std::vector<std::thread>& exited);
+
+    // Join threads taken by takeExitedWorkersLocked (mutex_ must not be held)
+    static void joinWorkers(std::vector<std::thread>& workers);
+
+    // Remove and return the job that should start next from levels
+    // Static so queue positions can be computed by running it on a copy
+    static bool popNextEntry(PriorityLevels& levels, UploadSchedulingMode mode, long long nowMs, QueueEntry& entry);
+
+    // Take the next job off the queue (mutex_ must be held, queue not empty)
+    AsyncUploadJob takeNextJobLocked();
+
+    // Remove a queued job from the scheduling state (mutex_ must be held)
+    void removeQueuedJobLocked(std::unordered_map<String, AsyncUploadJob>::iterator jobIt);
+
+public:
+    UploadWorkerPool();
+    ~UploadWorkerPool();
+
+    // Get singleton instance of the pool
+    static UploadWorkerPool& getInstance();
+
+    // Start worker threads (no-op if already started)
+    void start();
+
+    // Stop accepting jobs, cancel running uploads and join all threads once they wind down
+    // Jobs still queued are returned so the caller can mark them as cancelled
+    std::vector<AsyncUploadJob> stop();
+
+    // Queue a job; returns false if the pool is not running
+    bool submit(const AsyncUploadJob& job);
+
+    // Give up the place of a cancelled upload
+    // A queued job is dropped. A running job's worker leaves the pool once the job returns
+    // and a new worker takes its slot right away, so the next queued job does not wait
+    // for the cancelled request to wind down. Returns false if the job is neither.
+    bool cancel(const String& uploadId);
+
+    // Change the number of workers; takes effect immediately when running
+    void setWorkerCount(int count);
+
+    // Change how queued jobs of the same priority are ordered
+    void setSchedulingMode(UploadSchedulingMode mode);
+
+    // Get the 1-based positions in which queued uploads will start, 0 for uploads not queued
+    // One call replays the scheduler at most once, so a status response asks for all its uploads together
+    std::vector<size_t> getQueuePositions(const std::vector<String>& uploadIds) const;
+
+    // Get configured number of workers
+    int getWorkerCount() const;
+
+    // Get number of jobs waiting for a worker
+    size_t getQueuedJobs() const;
+
+    // Get number of workers currently running an upload
+    int getBusyWorkers() const;
+
+    // Check whether the pool accepts jobs (started and not stopping)
+    bool isRunning() const;
+};
+
+extern "C" {
+    S3UPLOAD_API const char* __stdcall SetMaxConcurrentUploads(long maxUploads);
+    S3UPLOAD_API const char* __stdcall SetUploadScheduling(long mode);
+}
+
+// S3UPLOADWORKERPOOL_H
+#endif
@@ -1,5 +1,6 @@
 #include "common/S3Common.h"
 
+#ifdef _WIN32
 // DLL entry point
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
 {
@@ -19,3 +20,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
     }
     return TRUE;
 }
+#else
+// Shared library unload (portable build): same auto cleanup as DLL_PROCESS_DETACH
+__attribute__((destructor)) static void onLibraryUnload()
+{
+    if (g_isInitialized) {
+        CleanupAwsSDK();
+    }
+}
+#endif
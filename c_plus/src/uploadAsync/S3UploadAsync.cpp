@@ -1,23 +1,29 @@
 #include "../common/S3Common.h"
+#include "../common/S3MultipartUpload.h"
+#include "../common/S3UploadWorkerPool.h"
+#include "../common/S3ClientCache.h"
+#include "../common/S3UploadJournal.h"
+#include "../common/S3MappedFileBody.h"
+#include "../common/S3BandwidthGovernor.h"
+#include "../common/S3EegCompression.h"
+#include "../common/S3ContentIndex.h"
+#include "../common/S3RetryPolicy.h"
+#include "../common/S3UploadBundle.h"
+#include "../common/S3UploadTrace.h"
+#include "../common/S3UploadBacklog.h"
 
-// Global queue processing control - ensures only one upload runs at a time
-static std::mutex g_uploadMutex;
-static std::condition_variable g_uploadCondition;
-static std::atomic<bool> g_isUploading(false);
-static std::atomic<int> g_activeUploads(0);
-static const int MAX_CONCURRENT_UPLOADS = 1;  // Only allow one upload at a time
-
-// Async upload worker thread function
-// This function runs in a separate thread to handle file upload to S3
-void asyncUploadWorker(const String& uploadId,
-                      const String& accessKey,
-                      const String& secretKey,
-                      const String& sessionToken,
-                      const String& region,
-                      const String& bucketName,
-                      const String& objectKey,
-                      const String& localFilePath,
-                      const String& dataId) {
+// Async upload worker function
+// Runs on an UploadWorkerPool thread to handle file upload to S3
+void asyncUploadWorker(const AsyncUploadJob& job) {
+    const String& uploadId = job.uploadId;
+    const String& accessKey = job.accessKey;
+    const String& secretKey = job.secretKey;
+    const String& sessionToken = job.sessionToken;
+    const String& region = job.region;
+    const String& bucketName = job.bucketName;
+    const String& objectKey = job.objectKey;
+    const String& localFilePath = job.localFilePath;
+    const String& dataId = job.dataId;
 
     // Step 1: Get upload progress tracker from manager
     auto& manager = AsyncUploadManager::getInstance();
@@ -25,20 +31,17 @@ void asyncUploadWorker(const String& uploadId,
     if (!progress) return;
 
     try {
-        // Step 2: Wait for queue - ensure only one upload runs at a time
-        std::unique_lock<std::mutex> lock(g_uploadMutex);
-        g_uploadCondition.wait(lock, [] { 
-            return g_activeUploads.load() < MAX_CONCURRENT_UPLOADS; 
-        });
-        
-        // Increment active uploads counter
-        g_activeUploads++;
-        g_isUploading = true;
-        lock.unlock();
-        
-        // Step 3: Initialize upload progress and set status to uploading
+        // Step 2: Initialize upload progress and set status to uploading
+        // The worker pool bounds how many uploads reach this point at once
         progress->startTime = std::chrono::steady_clock::now();
+        progress->queueWaitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            progress->startTime.load() - progress->queuedTime.load()).count();
         manager.updateProgress(uploadId, UPLOAD_UPLOADING);
+        if (isUploadTraceEnabled()) {
+            recordUploadTraceSpan(TRACE_SPAN_QUEUE, *progress, toUploadTraceMicros(progress->queuedTime),
+                                  toUploadTraceMicros(progress->startTime));
+        }
+        UploadTraceSpan uploadSpan(TRACE_SPAN_UPLOAD, progress.get());
 
         AWS_LOGSTREAM_INFO("S3Upload", "=== Starting Async Upload ===");
         AWS_LOGSTREAM_INFO("S3Upload", "Upload ID: " << uploadId);
@@ -54,30 +57,30 @@ void asyncUploadWorker(const String& uploadId,
         // Step 4: Validate input parameters
         if (accessKey.empty() || secretKey.empty() || region.empty() ||
             bucketName.empty() || objectKey.empty() || localFilePath.empty()) {
-            manager.updateProgress(uploadId, UPLOAD_FAILED, "Invalid parameters");
+            manager.updateProgress(uploadId, UPLOAD_FAILED, "Invalid parameters", UPLOAD_ERROR_INVALID_PARAMETERS);
             return;
         }
 
         // Step 5: Verify AWS SDK is initialized
         if (!g_isInitialized) {
-            manager.updateProgress(uploadId, UPLOAD_FAILED, "AWS SDK not initialized");
+            manager.updateProgress(uploadId, UPLOAD_FAILED, "AWS SDK not initialized", UPLOAD_ERROR_SDK_NOT_INITIALIZED);
             return;
         }
 
-        // Step 6: Check if local file exists
-        if (!FileExists(localFilePath.c_str())) {
-            manager.updateProgress(uploadId, UPLOAD_FAILED, "Local file does not exist");
+        // Step 6: Check if local file exists (bundles read their files while streaming)
+        if (!job.bundle && !FileExists(localFilePath.c_str())) {
+            manager.updateProgress(uploadId, UPLOAD_FAILED, "Local file does not exist", UPLOAD_ERROR_LOCAL_FILE);
             return;
         }
 
         // Step 7: Get file size and validate
-        long fileSize = GetS3FileSize(localFilePath.c_str());
+        long long fileSize = job.bundle ? job.bundle->archiveSize : getFileSize64(localFilePath);
         if (fileSize < 0) {
-            manager.updateProgress(uploadId, UPLOAD_FAILED, "Cannot read file size");
+            manager.updateProgress(uploadId, UPLOAD_FAILED, "Cannot read file size", UPLOAD_ERROR_LOCAL_FILE);
             return;
         }
 
-        progress->totalSize = fileSize;
+        manager.setTotalSize(uploadId, fileSize);
         AWS_LOGSTREAM_INFO("S3Upload", "File size: " << fileSize << " bytes");
 
         // Step 8: Check for cancellation again before heavy operations
@@ -86,124 +89,334 @@ void asyncUploadWorker(const String& uploadId,
             return;
         }
 
-        // Step 9: Create S3 client using helper function
-        Aws::S3::S3Client s3Client = createS3Client(accessKey, secretKey, sessionToken, region);
-
-        // Step 10: Create S3 PutObject request
-        Aws::S3::Model::PutObjectRequest request;
-        request.SetBucket(bucketName);
-        request.SetKey(objectKey);
-
-        // Step 11: Final cancellation check before upload
-        if (progress->shouldCancel.load()) {
-            manager.updateProgress(uploadId, UPLOAD_CANCELLED);
-            return;
+        // Step 8.1: Skip content that already reached this object (re-run after a partial failure)
+        String uploadFilePath = localFilePath;
+        ObjectMetadata metadata;
+        String contentHash;
+        bool isStagedFile = isCompressionTempFile(localFilePath);
+        if (!job.bundle && !isStagedFile && isUploadDeduplicationEnabled() &&
+            ContentIndex::getInstance().getContentHash(localFilePath, contentHash)) {
+            bool alreadyUploaded = isRemoteDeduplicationCheckEnabled()
+                ? isRemoteContentEqual(*acquireS3Client(accessKey, secretKey, sessionToken, region),
+                                       bucketName, objectKey, contentHash)
+                : ContentIndex::getInstance().isObjectUploaded(bucketName, objectKey, contentHash);
+            if (alreadyUploaded) {
+                ContentIndex::getInstance().recordObjectUploaded(bucketName, objectKey, contentHash);
+                progress->deduplicated = true;
+                progress->bytesSent = progress->totalSize.load();
+                progress->endTime = std::chrono::steady_clock::now();
+                manager.updateProgress(uploadId, UPLOAD_SUCCESS);
+                AWS_LOGSTREAM_INFO("S3Upload", "Skipped upload ID: " << uploadId << ", s3://" << bucketName
+                                   << "/" << objectKey << " already holds this content");
+                return;
+            }
+            metadata[METADATA_CONTENT_SHA256] = contentHash;
         }
 
-        // Step 12: Open file stream for reading
-        auto inputData = Aws::MakeShared<Aws::FStream>("PutObjectInputStream",
-                                                       localFilePath.c_str(),
-                                                       std::ios_base::in | std::ios_base::binary);
-
-        if (!inputData->is_open()) {
-            manager.updateProgress(uploadId, UPLOAD_FAILED, "Cannot open file for reading");
-            return;
+        // Step 8.2: Send a compressed copy instead of the file when compression is enabled
+        // A staged copy is removed once the last upload using it ends, unless a journaled multipart
+        // upload of it failed and will be resumed (ResumeUploads queues the staged path itself)
+        // Bundles are sent as they are and described by their own metadata
+        StagedFileCleanup stagedFile;
+        if (job.bundle) {
+            metadata = getBundleMetadata(*job.bundle);
+        } else if (isStagedFile) {
+            stagedFile.setPath(localFilePath);
+            // The staged copy's journal holds the encoding metadata; should its upload be started
+            // over, an object without it could not be decoded, so the copy is dropped instead
+            UploadJournal stagedJournal;
+            String journalPath = isUploadJournalEnabled()
+                ? getUploadJournalPath(bucketName, objectKey, localFilePath) : "";
+            if (journalPath.empty() || !loadUploadJournal(journalPath, stagedJournal) ||
+                stagedJournal.metadata.count(METADATA_ENCODING) == 0) {
+                manager.updateProgress(uploadId, UPLOAD_FAILED,
+                                       "Compressed copy has no upload journal, upload the original file again",
+                                       UPLOAD_ERROR_LOCAL_FILE);
+                return;
+            }
+            metadata = stagedJournal.metadata;
+        } else if (isUploadCompressionEnabled()) {
+            CompressedUpload compressed;
+            String compressionMessage;
+            if (compressFileForUpload(localFilePath, progress, compressed, stagedFile, compressionMessage)) {
+                uploadFilePath = compressed.compressedPath;
+                fileSize = compressed.compressedSize;
+                metadata.insert(compressed.metadata.begin(), compressed.metadata.end());
+                progress->originalSize = compressed.originalSize;
+                manager.setTotalSize(uploadId, fileSize);
+            } else if (progress->shouldCancel.load()) {
+                manager.updateProgress(uploadId, UPLOAD_CANCELLED);
+                return;
+            } else {
+                AWS_LOGSTREAM_INFO("S3Upload", "Sending " << localFilePath << " uncompressed: " << compressionMessage);
+            }
         }
 
-        // Step 13: Set request body and content type
-        request.SetBody(inputData);
-        request.SetContentType("application/octet-stream");
+        // Step 9: Get S3 client from the cache (reuses warm connections across uploads)
+        progress->clientStartTime = std::chrono::steady_clock::now();
+        UploadTraceSpan clientSpan(TRACE_SPAN_CLIENT, progress.get());
+        auto s3Client = acquireS3Client(accessKey, secretKey, sessionToken, region);
+        clientSpan.end();
+        progress->openStartTime = std::chrono::steady_clock::now();
 
-        AWS_LOGSTREAM_INFO("S3Upload", "Starting S3 PutObject operation...");
-
-        // Step 14: Execute S3 upload with retry mechanism (up to 3 retries on failure)
+        // Step 10: Large files go through the multipart path with per-part retry
         bool uploadSuccess = false;
         std::string finalErrorMsg = "";
-        
-        // Retry loop: attempt upload up to MAX_UPLOAD_RETRIES + 1 times (initial + 3 retries)
-        for (int retryCount = 0; retryCount <= MAX_UPLOAD_RETRIES; retryCount++) {
-            // Check for cancellation before each retry attempt
+        String checksum;
+
+        if (!job.bundle && shouldUseMultipartUpload(fileSize)) {
+            AWS_LOGSTREAM_INFO("S3Upload", "Starting S3 multipart upload...");
+            // Parts open their own ranges, so the transfer starts right away; the scope
+            // attributes the create and complete requests sent from this thread
+            progress->transferStartTime = std::chrono::steady_clock::now();
+            BandwidthAccountingScope bandwidthScope(progress.get());
+            uploadSuccess = uploadFileMultipart(*s3Client, bucketName, objectKey, uploadFilePath,
+                                                fileSize, progress, metadata, checksum, finalErrorMsg);
+            // A journaled upload stopped by CleanupAwsSDK is resumed later, so its staged copy stays too
+            bool resumable = !progress->shouldCancel.load() || progress->cancelledForShutdown.load();
+            if (!uploadSuccess && resumable && stagedFile.hasPath() && isUploadJournalEnabled()) {
+                stagedFile.keep();
+            }
+            if (!uploadSuccess && progress->shouldCancel.load()) {
+                manager.updateProgress(uploadId, UPLOAD_CANCELLED);
+                return;
+            }
+        } else {
+            // Step 10.1: Map the file so the HTTP client reads straight from its pages
+            // (declared before the request so the view outlives it)
+            MappedFileBody mappedBody;
+            std::unique_ptr<BundleBody> bundleBody;
+
+            // Step 10.2: Create S3 PutObject request
+            Aws::S3::Model::PutObjectRequest request;
+            request.SetBucket(bucketName);
+            request.SetKey(objectKey);
+            for (const auto& entry : metadata) {
+                request.AddMetadata(entry.first.c_str(), entry.second.c_str());
+            }
+
+            // Step 11: Final cancellation check before upload
             if (progress->shouldCancel.load()) {
                 manager.updateProgress(uploadId, UPLOAD_CANCELLED);
                 return;
             }
-            
-            // Apply exponential backoff delay for retry attempts (2, 4, 6 seconds)
-            if (retryCount > 0) {
-                AWS_LOGSTREAM_INFO("S3Upload", "Retry attempt " << retryCount << " for upload ID: " << uploadId);
-                std::this_thread::sleep_for(std::chrono::seconds(retryCount * 2));
+
+            // Step 12: Use the mapped view as body; empty or unmappable files use a file stream,
+            // bundles stream the tar archive straight from their files
+            std::shared_ptr<Aws::IOStream> inputData;
+            UploadTraceSpan openSpan(TRACE_SPAN_OPEN, progress.get());
+            if (job.bundle) {
+                bundleBody.reset(new BundleBody(job.bundle));
+                inputData = bundleBody->getStream();
+                request.SetContentLength(fileSize);
+            } else if (mappedBody.open(uploadFilePath, 0, fileSize)) {
+                inputData = mappedBody.getStream();
+            } else {
+                auto fileStream = Aws::MakeShared<Aws::FStream>("PutObjectInputStream",
+                                                                uploadFilePath.c_str(),
+                                                                std::ios_base::in | std::ios_base::binary);
+                if (!fileStream->is_open()) {
+                    manager.updateProgress(uploadId, UPLOAD_FAILED, "Cannot open file for reading", UPLOAD_ERROR_LOCAL_FILE);
+                    return;
+                }
+                inputData = fileStream;
             }
+            openSpan.end();
+
+            // Step 13: Set request body and content type
+            request.SetBody(inputData);
+            request.SetContentType("application/octet-stream");
+            // CRC32C is computed while the body streams out and sent as a trailer,
+            // so the file is read once (the client signs with an unsigned payload)
+            request.SetChecksumAlgorithm(Aws::S3::Model::ChecksumAlgorithm::CRC32C);
+
+            // Feed bytes sent into progress counters without taking the manager lock
+            RequestBytesTracker bytesTracker(progress);
+            bytesTracker.attach(request);
+            BandwidthAccountingScope bandwidthScope(progress.get());
+
+            AWS_LOGSTREAM_INFO("S3Upload", "Starting S3 PutObject operation...");
+            progress->transferStartTime = std::chrono::steady_clock::now();
+
+            // Step 14: Execute S3 upload, retrying transient errors (up to MAX_UPLOAD_RETRIES)
+            // with jittered backoff; permanent errors such as 400/403 fail on the first attempt
+            RetryController retry(progress);
+            while (true) {
+                // Check for cancellation before each attempt
+                if (progress->shouldCancel.load()) {
+                    manager.updateProgress(uploadId, UPLOAD_CANCELLED);
+                    return;
+                }
             
-            // Execute the actual S3 upload operation
-            auto outcome = s3Client.PutObject(request);
+                if (retry.getRetryCount() > 0) {
+                    AWS_LOGSTREAM_INFO("S3Upload", "Retry attempt " << retry.getRetryCount() << " for upload ID: " << uploadId);
+                    // Rewind body so the retry sends the whole file again
+                    inputData->clear();
+                    inputData->seekg(0, std::ios::beg);
+                }
             
-            if (outcome.IsSuccess()) {
-                // Upload succeeded - exit retry loop
-                uploadSuccess = true;
-                AWS_LOGSTREAM_INFO("S3Upload", "Async upload SUCCESS for ID: " << uploadId << " (attempt " << (retryCount + 1) << ")");
-                break;
-            } else {
-                // Upload failed - log error and prepare for potential retry
-                auto error = outcome.GetError();
-                finalErrorMsg = "S3 upload failed (attempt " + std::to_string(retryCount + 1) + "): " + std::string(error.GetMessage().c_str());
-                AWS_LOGSTREAM_WARN("S3Upload", "Upload attempt " << (retryCount + 1) << " failed for ID: " << uploadId << " - " << finalErrorMsg);
-                
-                // If this is the last attempt, exit retry loop
-                if (retryCount == MAX_UPLOAD_RETRIES) {
+                // Execute the actual S3 upload operation
+                UploadTraceSpan attemptSpan(TRACE_SPAN_PUT_OBJECT, progress.get(), 0, retry.getRetryCount() + 1);
+                auto outcome = s3Client->PutObject(request);
+                attemptSpan.end();
+            
+                if (outcome.IsSuccess()) {
+                    // Upload succeeded - exit retry loop
+                    uploadSuccess = true;
+                    retry.recordSuccess();
+                    checksum = outcome.GetResult().GetChecksumCRC32C().c_str();
+                    AWS_LOGSTREAM_INFO("S3Upload", "Async upload SUCCESS for ID: " << uploadId << " (attempt " << (retry.getRetryCount() + 1) << ")");
                     break;
+                } else {
+                    // Upload failed - log error and prepare for potential retry
+                    bytesTracker.rollback();
+                    auto error = outcome.GetError();
+                    finalErrorMsg = "S3 upload failed (attempt " + std::to_string(retry.getRetryCount() + 1) + "): " + std::string(error.GetMessage().c_str());
+                    AWS_LOGSTREAM_WARN("S3Upload", "Upload attempt " << (retry.getRetryCount() + 1) << " failed for ID: " << uploadId << " - " << finalErrorMsg);
+
+                    // An expired session will not recover; drop the cached client (not retried)
+                    if (error.GetErrorType() == Aws::S3::S3Errors::EXPIRED_TOKEN) {
+                        S3ClientCache::getInstance().invalidate(accessKey, sessionToken, region);
+                    }
+
+                    // A bundled file that changed or vanished fails the bundle for good
+                    if (bundleBody && bundleBody->hasFailed()) {
+                        finalErrorMsg = bundleBody->getFailure();
+                        progress->errorCode = UPLOAD_ERROR_LOCAL_FILE;
+                        break;
+                    }
+                
+                    // Permanent errors, exhausted attempts or budget, and cancellation end the loop
+                    if (!retry.shouldRetry(error)) {
+                        if (progress->shouldCancel.load()) {
+                            manager.updateProgress(uploadId, UPLOAD_CANCELLED);
+                            return;
+                        }
+                        break;
+                    }
                 }
             }
-        }
 
-        AWS_LOGSTREAM_INFO("S3Upload", "PutObject operation completed");
+            AWS_LOGSTREAM_INFO("S3Upload", "PutObject operation completed");
+        }
 
         // Step 15: Handle final upload result
         if (uploadSuccess) {
+            progress->bytesSent = progress->totalSize.load();
+            progress->checksumCRC32C = checksum;
+            if (!contentHash.empty()) {
+                ContentIndex::getInstance().recordObjectUploaded(bucketName, objectKey, contentHash);
+            }
             progress->endTime = std::chrono::steady_clock::now();
             manager.updateProgress(uploadId, UPLOAD_SUCCESS);
             AWS_LOGSTREAM_INFO("S3Upload", "Async upload SUCCESS for ID: " << uploadId);
         } else {
+            // The error code was recorded by the request that gave up (internal error otherwise)
             manager.updateProgress(uploadId, UPLOAD_FAILED, finalErrorMsg);
-            AWS_LOGSTREAM_ERROR("S3Upload", "Async upload FAILED for ID: " << uploadId << " after " << (MAX_UPLOAD_RETRIES + 1) << " attempts - " << finalErrorMsg);
+            AWS_LOGSTREAM_ERROR("S3Upload", "Async upload FAILED for ID: " << uploadId << " after " << (progress->retryCount.load() + 1) << " attempt(s) - " << finalErrorMsg);
         }
-        
-        // Step 16: Release upload lock to allow next upload to start
-        {
-            std::lock_guard<std::mutex> lock(g_uploadMutex);
-            g_activeUploads--;
-            g_isUploading = false;
-        }
-        g_uploadCondition.notify_all();
 
     } catch (const std::exception& e) {
-        // Step 17: Handle exceptions during upload
+        // Step 16: Handle exceptions during upload
         std::string errorMsg = "Upload failed with exception: " + std::string(e.what());
-        manager.updateProgress(uploadId, UPLOAD_FAILED, errorMsg);
+        manager.updateProgress(uploadId, UPLOAD_FAILED, errorMsg, UPLOAD_ERROR_INTERNAL);
         AWS_LOGSTREAM_ERROR("S3Upload", "Exception in async upload: " << e.what());
-        
-        // Release upload lock
-        {
-            std::lock_guard<std::mutex> lock(g_uploadMutex);
-            g_activeUploads--;
-            g_isUploading = false;
-        }
-        g_uploadCondition.notify_all();
     } catch (...) {
-        // Step 18: Handle unknown exceptions
-        manager.updateProgress(uploadId, UPLOAD_FAILED, "Unknown error");
+        // Step 17: Handle unknown exceptions
+        manager.updateProgress(uploadId, UPLOAD_FAILED, "Unknown error", UPLOAD_ERROR_INTERNAL);
         AWS_LOGSTREAM_ERROR("S3Upload", "Unknown exception in async upload");
-        
-        // Release upload lock
-        {
-            std::lock_guard<std::mutex> lock(g_uploadMutex);
-            g_activeUploads--;
-            g_isUploading = false;
+    }
+}
+
+// Serializes the in-flight lookup and submission in queueAsyncUpload
+static std::mutex g_queueMutex;
+
+// Submit an upload through the backlog, which registers it with the manager and queues it
+// on the worker pool once fewer than MAX_UPLOAD_LIMIT uploads are active
+// Fills job.uploadId; knownSize (if >= 0) is recorded right away so status
+// queries report the size before the worker starts.
+// A request identical to a queued or running upload (same dataId, bucket, key and file)
+// is merged into it: job.uploadId is the existing upload and coalesced is set.
+// Uploads still waiting in the backlog are not merged into.
+// Bundles are never merged, their contents depend on the folder at the time of the call.
+static bool queueAsyncUpload(AsyncUploadJob& job, long long knownSize, bool& coalesced, String& errorMessage) {
+    auto& manager = AsyncUploadManager::getInstance();
+    coalesced = false;
+
+    // Step 1: Merge into an identical in-flight upload, otherwise submit a new one
+    std::lock_guard<std::mutex> lock(g_queueMutex);
+    auto existing = job.bundle ? nullptr
+        : manager.findInFlightUpload(job.dataId, job.bucketName, job.objectKey, job.localFilePath);
+    if (existing) {
+        job.uploadId = existing->uploadId;
+        coalesced = true;
+        AWS_LOGSTREAM_INFO("S3Upload", "Coalesced duplicate request into upload ID: " << job.uploadId);
+        return true;
+    }
+    job.uploadId = generateUploadId(job.dataId);
+    job.sizeHint = knownSize;
+
+    // Step 2: Hand the job to the backlog; it starts right away if there is room
+    return UploadBacklog::getInstance().submit(job, knownSize, errorMessage);
+}
+
+// Validate and queue one file upload; returns the JSON response for the export
+// A request identical to one already queued or running returns that upload's ID
+static String startAsyncUpload(
+    const char* accessKey,
+    const char* secretKey,
+    const char* sessionToken,
+    const char* region,
+    const char* bucketName,
+    const char* objectKey,
+    const char* localFilePath,
+    const char* dataId,
+    int priority
+) {
+    // Step 1: Validate input parameters
+    if (!accessKey || !secretKey || !region || !bucketName || !objectKey || !localFilePath || !dataId ||
+        priority < MIN_UPLOAD_PRIORITY || priority > MAX_UPLOAD_PRIORITY) {
+        return create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+    }
+
+    // Step 2: Check if AWS SDK is initialized
+    if (!g_isInitialized) {
+        return create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::SDK_NOT_INITIALIZED));
+    }
+
+    try {
+        // Step 3: Copy C-style parameters into the job (avoid pointer lifetime issues)
+        AsyncUploadJob job;
+        job.accessKey = accessKey;
+        job.secretKey = secretKey;
+        job.sessionToken = sessionToken ? sessionToken : "";
+        job.region = region;
+        job.bucketName = bucketName;
+        job.objectKey = objectKey;
+        job.localFilePath = localFilePath;
+        job.dataId = dataId;
+        job.priority = priority;
+
+        // Step 4: Register and queue the job (or join the identical one in flight); the worker validates the file
+        String queueError;
+        bool coalesced = false;
+        if (!queueAsyncUpload(job, getFileSize64(job.localFilePath), coalesced, queueError)) {
+            return create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", queueError));
         }
-        g_uploadCondition.notify_all();
+
+        // Step 5: Return success response with upload ID
+        return create_response(UPLOAD_SUCCESS, job.uploadId);
+
+    } catch (const std::exception& e) {
+        // Step 6: Handle exceptions while queueing the upload
+        return create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", e.what()));
+    } catch (...) {
+        // Step 7: Handle unknown exceptions
+        return create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", ErrorMessage::UNKNOWN_ERROR));
     }
 }
 
-// Exported async upload function - starts file upload in background thread
+// Exported async upload function - queues file upload on the worker pool
 // Returns JSON with upload ID on success, error message on failure
 extern "C" S3UPLOAD_API const char* __stdcall UploadFileAsync(
     const char* accessKey,
@@ -216,9 +429,54 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileAsync(
     const char* dataId
 ) {
     static std::string response;
+    response = startAsyncUpload(accessKey, secretKey, sessionToken, region, bucketName, objectKey,
+                                localFilePath, dataId, DEFAULT_UPLOAD_PRIORITY);
+    return response.c_str();
+}
+
+// Exported async upload with a scheduling priority (-100..100, default uploads use 0)
+// A higher priority starts before every queued upload of lower priority; uploads of the
+// same priority share the workers across dataIds (see SetUploadScheduling)
+extern "C" S3UPLOAD_API const char* __stdcall UploadFileAsyncEx(
+    const char* accessKey,
+    const char* secretKey,
+    const char* sessionToken,
+    const char* region,
+    const char* bucketName,
+    const char* objectKey,
+    const char* localFilePath,
+    const char* dataId,
+    long priority
+) {
+    static std::string response;
+    response = startAsyncUpload(accessKey, secretKey, sessionToken, region, bucketName, objectKey,
+                                localFilePath, dataId, static_cast<int>(priority));
+    return response.c_str();
+}
+
+// Exported async folder upload - walks localFolderPath recursively and queues every file
+// under one dataId. Object keys are keyPrefix + path relative to the folder ('/' separated).
+// Returns JSON with file count and total batch size on success, error message on failure
+// Files already queued or running for the dataId (a re-run before the first finished) join
+// their in-flight upload and are counted in coalescedCount.
+// With SetFolderUploadBundling, small files are packed into tar bundles uploaded under
+// keyPrefix + ".bundles/"; bundleCount and bundledFileCount report how many.
+// { "code": 2, "message": "Queued 12 file(s)", "dataId": "...", "fileCount": 12, "coalescedCount": 0,
+//   "bundleCount": 0, "bundledFileCount": 0, "totalSize": 123456 }
+extern "C" S3UPLOAD_API const char* __stdcall UploadFolderAsync(
+    const char* accessKey,
+    const char* secretKey,
+    const char* sessionToken,
+    const char* region,
+    const char* bucketName,
+    const char* keyPrefix,
+    const char* localFolderPath,
+    const char* dataId
+) {
+    static std::string response;
 
     // Step 1: Validate input parameters
-    if (!accessKey || !secretKey || !region || !bucketName || !objectKey || !localFilePath || !dataId) {
+    if (!accessKey || !secretKey || !region || !bucketName || !keyPrefix || !localFolderPath || !dataId) {
         response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
         return response.c_str();
     }
@@ -229,72 +487,217 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileAsync(
         return response.c_str();
     }
 
-    // Step 2.1: Check upload queue limit (max 100 uploads)
-    auto& manager = AsyncUploadManager::getInstance();
-    size_t totalUploads = manager.getTotalUploads();
-    
-    if (totalUploads >= MAX_UPLOAD_LIMIT) {
-        // Check if there are existing uploads with the same dataId
-        auto existingUploads = manager.getAllUploadsByDataId(dataId);
-        
-        if (existingUploads.empty()) {
-            // No existing uploads with same dataId, reject new upload
-            std::string errorMsg = "Upload queue is full (" + std::to_string(totalUploads) + 
-                                 " uploads). Please wait for some uploads to complete before trying again.";
-            response = create_response(UPLOAD_FAILED, formatErrorMessage("Upload limit exceeded", errorMsg));
-            AWS_LOGSTREAM_WARN("S3Upload", "Upload rejected due to queue limit: " << errorMsg);
+    try {
+        // Step 3: Walk the folder once, collecting relative paths and sizes
+        std::vector<LocalFileEntry> files;
+        if (!listFilesRecursive(localFolderPath, files)) {
+            response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::LOCAL_FOLDER_NOT_EXIST, localFolderPath));
+            return response.c_str();
+        }
+        if (files.empty()) {
+            response = create_response(UPLOAD_FAILED, formatErrorMessage("No files found in folder", localFolderPath));
             return response.c_str();
-        } else {
-            // Allow upload to continue if same dataId exists (folder upload scenario)
-            AWS_LOGSTREAM_INFO("S3Upload", "Upload queue full but allowing continuation for existing dataId: " << dataId);
         }
+
+        // Step 4: Queue every file as one batch under the dataId
+        String prefix = keyPrefix;
+        if (!prefix.empty() && prefix.back() != '/') {
+            prefix += "/";
+        }
+
+        AsyncUploadJob job;
+        job.accessKey = accessKey;
+        job.secretKey = secretKey;
+        job.sessionToken = sessionToken ? sessionToken : "";
+        job.region = region;
+        job.bucketName = bucketName;
+        job.dataId = dataId;
+
+        // Step 4.1: Pack small files into bundles when bundling is enabled
+        std::vector<std::shared_ptr<const UploadBundle>> bundles;
+        std::vector<LocalFileEntry> individualFiles;
+        planFolderBundles(files, prefix, bundles, individualFiles);
+
+        long long totalSize = 0;
+        int queuedCount = 0;
+        int coalescedCount = 0;
+        int bundledFileCount = 0;
+        for (const auto& file : individualFiles) {
+            job.objectKey = prefix + file.relativePath;
+            job.localFilePath = file.fullPath;
+
+            String queueError;
+            bool coalesced = false;
+            if (!queueAsyncUpload(job, file.size, coalesced, queueError)) {
+                response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", queueError));
+                return response.c_str();
+            }
+            totalSize += file.size;
+            queuedCount++;
+            if (coalesced) {
+                coalescedCount++;
+            }
+        }
+
+        // Step 4.2: Queue each bundle as one upload; localFilePath names the folder
+        job.localFilePath = localFolderPath;
+        for (size_t i = 0; i < bundles.size(); i++) {
+            job.objectKey = getBundleObjectKey(prefix, i + 1);
+            job.bundle = bundles[i];
+
+            String queueError;
+            bool coalesced = false;
+            if (!queueAsyncUpload(job, bundles[i]->archiveSize, coalesced, queueError)) {
+                response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", queueError));
+                return response.c_str();
+            }
+            totalSize += bundles[i]->filesSize;
+            queuedCount += static_cast<int>(bundles[i]->fileCount);
+            bundledFileCount += static_cast<int>(bundles[i]->fileCount);
+        }
+
+        // Step 5: Return batch size right away, before any bytes are sent
+        AWS_LOGSTREAM_INFO("S3Upload", "Queued folder " << localFolderPath << ": " << queuedCount
+                           << " file(s) (" << bundledFileCount << " in " << bundles.size() << " bundle(s)), "
+                           << totalSize << " bytes for dataId: " << dataId);
+        std::ostringstream oss;
+        oss << "{"
+            << "\"code\":" << UPLOAD_SUCCESS << ","
+            << "\"message\":\"Queued " << queuedCount << " file(s)\","
+            << "\"dataId\":\"" << escapeJson(dataId) << "\","
+            << "\"fileCount\":" << queuedCount << ","
+            << "\"coalescedCount\":" << coalescedCount << ","
+            << "\"bundleCount\":" << bundles.size() << ","
+            << "\"bundledFileCount\":" << bundledFileCount << ","
+            << "\"totalSize\":" << totalSize
+            << "}";
+        response = oss.str();
+        return response.c_str();
+
+    } catch (const std::exception& e) {
+        // Step 6: Handle exceptions while queueing the batch
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start folder upload", e.what()));
+        return response.c_str();
+    } catch (...) {
+        // Step 7: Handle unknown exceptions
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start folder upload", ErrorMessage::UNKNOWN_ERROR));
+        return response.c_str();
+    }
+}
+
+// Resume multipart uploads left in the upload journal by an earlier run (crash, restart, network loss)
+// Each journaled upload is queued again under its original dataId and continues from its last
+// completed part. Credentials are not stored in the journal, so they are passed in here.
+// dataId limits resuming to one batch; NULL or "" resumes every journaled async upload.
+// Journals for files that changed since the upload started are discarded.
+// { "code": 2, "message": "Resumed 2 upload(s)", "resumedCount": 2, "skippedCount": 1, "dataIds": ["..."] }
+extern "C" S3UPLOAD_API const char* __stdcall ResumeUploads(
+    const char* accessKey,
+    const char* secretKey,
+    const char* sessionToken,
+    const char* region,
+    const char* dataId
+) {
+    static std::string response;
+
+    // Step 1: Validate input parameters
+    if (!accessKey || !secretKey || !region) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    // Step 2: Check if AWS SDK is initialized
+    if (!g_isInitialized) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::SDK_NOT_INITIALIZED));
+        return response.c_str();
     }
 
     try {
-        // Step 3: Generate unique upload ID using dataId and current timestamp
-        auto now = std::chrono::high_resolution_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-        String uploadId = getUploadId(dataId, timestamp);
-
-        // Step 4: Register upload with manager for progress tracking and queue
-        manager.addUpload(uploadId, localFilePath, objectKey);
-
-        // Step 5: Convert C-style parameters to C++ strings (avoid pointer lifetime issues)
-        String strAccessKey = accessKey;
-        String strSecretKey = secretKey;
-        String strSessionToken = sessionToken ? sessionToken : "";
-        String strRegion = region;
-        String strBucketName = bucketName;
-        String strObjectKey = objectKey;
-        String strLocalFilePath = localFilePath;
-        String strDataId = dataId;
-
-        // Step 6: Start background thread for async upload (will be queued automatically)
-        std::thread uploadThread(asyncUploadWorker, uploadId,
-                               strAccessKey, strSecretKey, strSessionToken,
-                               strRegion, strBucketName, strObjectKey, strLocalFilePath, strDataId);
-        uploadThread.detach(); // Detach thread so it runs independently
-
-        // Step 7: Return success response with upload ID
-        response = create_response(UPLOAD_SUCCESS, uploadId);
+        String dataIdFilter = dataId ? dataId : "";
+        int resumedCount = 0;
+        int skippedCount = 0;
+        std::vector<String> resumedDataIds;
+
+        // Step 3: Queue every matching journal whose local file is unchanged
+        for (const auto& journal : loadAllUploadJournals()) {
+            // Sync uploads have no dataId; they resume when UploadFileSync is called again
+            if (journal.dataId.empty() || (!dataIdFilter.empty() && journal.dataId != dataIdFilter)) {
+                continue;
+            }
+            // An upload of this process is still writing the journal
+            if (isUploadJournalActive(journal.journalPath)) {
+                skippedCount++;
+                continue;
+            }
+            if (!isUploadJournalFileUnchanged(journal)) {
+                AWS_LOGSTREAM_INFO("S3Upload", "Discarding journal for changed file: " << journal.localFilePath);
+                removeUploadJournal(journal);
+                skippedCount++;
+                continue;
+            }
+            AsyncUploadJob job;
+            job.accessKey = accessKey;
+            job.secretKey = secretKey;
+            job.sessionToken = sessionToken ? sessionToken : "";
+            job.region = region;
+            job.bucketName = journal.bucketName;
+            job.objectKey = journal.objectKey;
+            job.localFilePath = journal.localFilePath;
+            job.dataId = journal.dataId;
+
+            // An upload already running for this journal is left alone
+            String queueError;
+            bool coalesced = false;
+            if (!queueAsyncUpload(job, journal.fileSize, coalesced, queueError)) {
+                response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to resume upload", queueError));
+                return response.c_str();
+            }
+            if (coalesced) {
+                skippedCount++;
+                continue;
+            }
+            resumedCount++;
+            if (std::find(resumedDataIds.begin(), resumedDataIds.end(), journal.dataId) == resumedDataIds.end()) {
+                resumedDataIds.push_back(journal.dataId);
+            }
+        }
+
+        // Step 4: Report what was queued so the caller can wait on the dataIds
+        AWS_LOGSTREAM_INFO("S3Upload", "Resumed " << resumedCount << " upload(s), skipped " << skippedCount);
+        std::ostringstream oss;
+        oss << "{"
+            << "\"code\":" << UPLOAD_SUCCESS << ","
+            << "\"message\":\"Resumed " << resumedCount << " upload(s)\","
+            << "\"resumedCount\":" << resumedCount << ","
+            << "\"skippedCount\":" << skippedCount << ","
+            << "\"dataIds\":[";
+        for (size_t i = 0; i < resumedDataIds.size(); i++) {
+            if (i > 0) {
+                oss << ",";
+            }
+            oss << "\"" << escapeJson(resumedDataIds[i]) << "\"";
+        }
+        oss << "]}";
+        response = oss.str();
         return response.c_str();
 
     } catch (const std::exception& e) {
-        // Step 8: Handle exceptions during thread creation
-        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", e.what()));
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to resume uploads", e.what()));
         return response.c_str();
     } catch (...) {
-        // Step 9: Handle unknown exceptions
-        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to start async upload", ErrorMessage::UNKNOWN_ERROR));
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Failed to resume uploads", ErrorMessage::UNKNOWN_ERROR));
         return response.c_str();
     }
 }
 
-// Get async upload status as byte array - safer for VB6 interop
+// Write the status JSON of a dataId into buffer (truncated if necessary)
+// sinceVersion 0 lists every upload; otherwise only the uploads changed after that version.
+// The summary always covers the whole dataId, and "version" is the value to pass next time.
 // Returns the size of data copied to buffer, 0 on error
-extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusBytes(
-    const char* dataId, 
-    unsigned char* buffer, 
+static int writeUploadStatusJson(
+    const char* dataId,
+    unsigned long long sinceVersion,
+    unsigned char* buffer,
     int bufferSize
 ) {
     // Step 1: Validate parameters
@@ -302,10 +705,13 @@ extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusBytes(
         return 0;
     }
 
-    // Step 2: Look up all uploads that match the dataId prefix
+    // Step 2: Look up aggregates, live totals and changed uploads of the dataId under one lock
     auto& manager = AsyncUploadManager::getInstance();
-    auto allUploads = manager.getAllUploadsByDataId(dataId);
-    if (allUploads.empty()) {
+    DataIdSummary summary;
+    DataIdProgressTotals totals;
+    std::vector<std::shared_ptr<AsyncUploadProgress>> changedUploads;
+    unsigned long long version = 0;
+    if (!manager.getDataIdChanges(dataId, sinceVersion, summary, totals, changedUploads, version)) {
         // Return error JSON if no uploads found
         std::string errorJson = create_response(UPLOAD_FAILED, formatErrorMessage("No uploads found with dataId"));
         int dataSize = static_cast<int>(errorJson.size());
@@ -315,83 +721,114 @@ extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusBytes(
     }
 
     try {
-        // Step 3: Check status of all uploads with this dataId
-        bool allCompleted = true;
-        bool anyFailed = false;
-        bool anyUploading = false;
-        std::string errorMessage = "";
-        long long totalSize = 0;
-        int uploadedCount = 0;
-        long long uploadedSize = 0;
-        
-        for (auto& progress : allUploads) {
-            totalSize += progress->totalSize;
-            
-            if (progress->status == UPLOAD_SUCCESS) {
-                uploadedCount++;
-                uploadedSize += progress->totalSize;
-            } else if (progress->status == UPLOAD_FAILED) {
-                anyFailed = true;
-                if (errorMessage.empty()) {
-                    errorMessage = progress->errorMessage;
-                }
-                allCompleted = false;
-            } else if (progress->status == UPLOAD_UPLOADING || progress->status == UPLOAD_PENDING || progress->status == UPLOAD_CANCELLED) {
-                anyUploading = true;
-                allCompleted = false;
-            }
-        }
-        
-        // Step 4: Determine overall status
-        int overallStatus;
-        if (anyFailed) {
-            overallStatus = UPLOAD_FAILED;
-        } else if (allCompleted && !anyUploading) {
-            overallStatus = UPLOAD_SUCCESS;
-        } else {
-            overallStatus = UPLOAD_UPLOADING;
-        }
+        // Step 3: Counts, sizes and overall status come from the dataId aggregates
+        int overallStatus = summary.getOverallStatus();
 
-        // Step 5: Build JSON response with array of upload information and summary
-        int totalUploadCount = static_cast<int>(allUploads.size());
-        
+        // Step 4: Build JSON response with the summary and the (changed) uploads
         std::ostringstream oss;
         oss << "{"
             << "\"code\":" << UPLOAD_SUCCESS << ","
             << "\"status\":" << overallStatus << ","
-            << "\"uploadedCount\":" << uploadedCount << ","
-            << "\"uploadedSize\":" << uploadedSize << ","
-            << "\"totalSize\":" << totalSize << ","
-            << "\"totalUploadCount\":" << totalUploadCount << ","
-            << "\"errorMessage\":\"" << errorMessage << "\","
-            << "\"dataId\":\"" << dataId << "\","
+            << "\"uploadedCount\":" << summary.statusCounts[UPLOAD_SUCCESS] << ","
+            << "\"uploadedSize\":" << totals.uploadedSize << ","
+            << "\"totalSize\":" << summary.totalSize << ","
+            << "\"totalUploadCount\":" << summary.uploadCount << ","
+            << "\"backlogCount\":" << summary.backlogCount << ","
+            << "\"totalFileCount\":" << totals.totalFileCount << ","
+            << "\"uploadedFileCount\":" << totals.uploadedFileCount << ","
+            << "\"throughputBytesPerSec\":" << static_cast<long long>(totals.throughput) << ","
+            << "\"etaSeconds\":" << totals.getEtaSeconds(overallStatus) << ","
+            << "\"errorCode\":" << summary.firstErrorCode << ","
+            << "\"errorMessage\":\"" << escapeJson(summary.firstErrorMessage) << "\","
+            << "\"dataId\":\"" << escapeJson(dataId) << "\","
+            << "\"version\":" << version << ","
+            << "\"sinceVersion\":" << sinceVersion << ","
+            << "\"changedCount\":" << changedUploads.size() << ","
             << "\"uploads\":[";
 
+        // Status is read once so each record agrees with itself while a worker updates it;
+        // queue positions of all pending uploads come from one pass over the worker pool queue
+        std::vector<UploadStatus> statuses;
+        std::vector<String> pendingUploadIds;
+        statuses.reserve(changedUploads.size());
+        for (const auto& progress : changedUploads) {
+            statuses.push_back(progress->status);
+            pendingUploadIds.push_back(statuses.back() == UPLOAD_PENDING ? progress->uploadId : String());
+        }
+        std::vector<size_t> queuePositions = UploadWorkerPool::getInstance().getQueuePositions(pendingUploadIds);
+
         // Add array of individual upload information
-        for (size_t i = 0; i < allUploads.size(); ++i) {
-            auto& progress = allUploads[i];
+        for (size_t i = 0; i < changedUploads.size(); ++i) {
+            auto& progress = changedUploads[i];
             if (i > 0) oss << ",";
-            
-            // Convert time points to milliseconds since epoch
-            auto startTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                progress->startTime.time_since_epoch()).count();
-            
-            long long endTimeMs = 0;
-            if (progress->endTime.time_since_epoch().count() > 0) {
-                endTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    progress->endTime.time_since_epoch()).count();
+
+            UploadStatus status = statuses[i];
+            long long totalSize = progress->totalSize;
+
+            // Queued uploads report where they stand and how long they have waited so far
+            size_t queuePosition = queuePositions[i];
+            long long queueWaitMs = progress->queueWaitMs.load();
+            if (status == UPLOAD_PENDING) {
+                queueWaitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - progress->queuedTime.load()).count();
             }
-            
+
+            // Uncompressed uploads report their own size and a ratio of 1
+            long long originalSize = progress->originalSize.load() > 0 ? progress->originalSize.load() : totalSize;
+            double compressionRatio = totalSize > 0
+                ? static_cast<double>(originalSize) / static_cast<double>(totalSize) : 1.0;
+
             oss << "{"
-                << "\"uploadId\":\"" << progress->uploadId << "\","
-                << "\"localFilePath\":\"" << progress->localFilePath << "\","
-                << "\"s3ObjectKey\":\"" << progress->s3ObjectKey << "\","
-                << "\"status\":" << progress->status << ","
-                << "\"totalSize\":" << progress->totalSize << ","
-                << "\"errorMessage\":\"" << progress->errorMessage << "\","
-                << "\"startTime\":" << startTimeMs << ","
-                << "\"endTime\":" << endTimeMs
-                << "}";
+                << "\"uploadId\":\"" << escapeJson(progress->uploadId) << "\","
+                << "\"localFilePath\":\"" << escapeJson(progress->localFilePath) << "\","
+                << "\"s3ObjectKey\":\"" << escapeJson(progress->s3ObjectKey) << "\","
+                << "\"status\":" << status << ","
+                << "\"totalSize\":" << totalSize << ","
+                << "\"bytesSent\":" << progress->getBytesSent() << ","
+                << "\"throughputBytesPerSec\":" << static_cast<long long>(progress->getThroughput()) << ","
+                << "\"etaSeconds\":" << progress->getEtaSeconds() << ","
+                << "\"totalParts\":" << progress->totalParts.load() << ","
+                << "\"completedParts\":" << progress->completedParts.load() << ","
+                << "\"throttledMs\":" << progress->throttledMs.load() << ","
+                << "\"retryCount\":" << progress->retryCount.load() << ","
+                << "\"backoffMs\":" << progress->backoffMs.load() << ","
+                << "\"queuePosition\":" << queuePosition << ","
+                << "\"queueWaitMs\":" << queueWaitMs << ","
+                << "\"originalSize\":" << originalSize << ","
+                << "\"compressionRatio\":" << std::fixed << std::setprecision(2) << compressionRatio
+                << std::defaultfloat << ","
+                << "\"checksum\":\"" << progress->checksumCRC32C.load() << "\","
+                << "\"deduplicated\":" << (progress->deduplicated.load() ? "true" : "false") << ","
+                << "\"errorCode\":" << progress->errorCode.load() << ","
+                << "\"errorMessage\":\"" << escapeJson(progress->errorMessage.load()) << "\","
+                << "\"startTime\":" << getStatusTimeMs(progress->startTime) << ","
+                << "\"endTime\":" << getStatusTimeMs(progress->endTime) << ","
+                << "\"phases\":{"
+                << "\"queueMs\":" << progress->getPhaseMs(UPLOAD_PHASE_QUEUE) << ","
+                << "\"prepareMs\":" << progress->getPhaseMs(UPLOAD_PHASE_PREPARE) << ","
+                << "\"clientMs\":" << progress->getPhaseMs(UPLOAD_PHASE_CLIENT) << ","
+                << "\"openMs\":" << progress->getPhaseMs(UPLOAD_PHASE_OPEN) << ","
+                << "\"transferMs\":" << progress->getPhaseMs(UPLOAD_PHASE_TRANSFER) << ","
+                << "\"totalMs\":" << progress->getPhaseMs(UPLOAD_PHASE_TOTAL) << ","
+                << "\"connectMs\":" << progress->connectMs.load() << ","
+                << "\"requestCount\":" << progress->requestCount.load()
+                << "},"
+                << "\"bundledFiles\":[";
+
+            // Files of a bundle share its status; offset is where their data starts in the tar
+            if (progress->bundle) {
+                for (size_t j = 0; j < progress->bundle->fileCount; j++) {
+                    const BundleMember& member = progress->bundle->members[j];
+                    if (j > 0) oss << ",";
+                    oss << "{"
+                        << "\"localFilePath\":\"" << escapeJson(member.localFilePath) << "\","
+                        << "\"s3ObjectKey\":\"" << escapeJson(member.objectKey) << "\","
+                        << "\"offset\":" << member.dataOffset << ","
+                        << "\"size\":" << member.size
+                        << "}";
+                }
+            }
+            oss << "]}";
         }
 
         oss << "]}";
@@ -424,7 +861,51 @@ extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusBytes(
     }
 }
 
-// Clean up uploads by dataId - removes all uploads that match the dataId prefix
+// Get async upload status as byte array - safer for VB6 interop
+// Returns the size of data copied to buffer, 0 on error
+extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusBytes(
+    const char* dataId, 
+    unsigned char* buffer, 
+    int bufferSize
+) {
+    return writeUploadStatusJson(dataId, 0, buffer, bufferSize);
+}
+
+// Get only the uploads of a dataId that changed after sinceVersion - for large batches
+// Pass 0 first, then the "version" of the previous response; the summary fields always
+// describe the whole dataId. A Double carries the version so VB6 can pass it back as is.
+// Returns the size of data copied to buffer, 0 on error
+extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusDelta(
+    const char* dataId,
+    double sinceVersion,
+    unsigned char* buffer,
+    int bufferSize
+) {
+    unsigned long long since = sinceVersion > 0 ? static_cast<unsigned long long>(sinceVersion) : 0;
+    return writeUploadStatusJson(dataId, since, buffer, bufferSize);
+}
+
+// Get async upload status as fixed-size records - for hosts that poll often
+// Fills summary and up to maxRecords records (registration order) without building JSON
+// or allocating; summary->uploadCount tells how many records a complete snapshot needs.
+// Returns the number of records written, -1 if the dataId is unknown or parameters are invalid
+extern "C" S3UPLOAD_API int __stdcall GetAsyncUploadStatusRecords(
+    const char* dataId,
+    UploadStatusSummaryRecord* summary,
+    UploadStatusRecord* records,
+    int maxRecords
+) {
+    if (!dataId || !summary || maxRecords < 0 || (maxRecords > 0 && !records)) {
+        return -1;
+    }
+    try {
+        return AsyncUploadManager::getInstance().fillStatusRecords(dataId, *summary, records, maxRecords);
+    } catch (...) {
+        return -1;
+    }
+}
+
+// Clean up uploads by dataId - removes all uploads registered for the dataId
 // Returns JSON response indicating success or failure
 extern "C" S3UPLOAD_API const char* __stdcall CleanupUploadsByDataId(
     const char* dataId
@@ -438,32 +919,21 @@ extern "C" S3UPLOAD_API const char* __stdcall CleanupUploadsByDataId(
     }
 
     try {
-        // Step 2: Get manager instance and find uploads by dataId
+        // Step 2: Remove all uploads of the dataId through the index, backlogged ones included
         auto& manager = AsyncUploadManager::getInstance();
-        auto allUploads = manager.getAllUploadsByDataId(dataId);
-        
-        if (allUploads.empty()) {
+        UploadBacklog::getInstance().discardDataId(dataId);
+        size_t removedCount = manager.removeUploadsByDataId(dataId);
+
+        // Removed uploads free room for backlogged ones
+        UploadBacklog::getInstance().admit();
+
+        if (removedCount == 0) {
             // No uploads found with this dataId
             response = create_response(UPLOAD_SUCCESS, "No uploads found with dataId: " + std::string(dataId));
             return response.c_str();
         }
 
-        // Step 3: Remove all uploads that match the dataId
-        int removedCount = 0;
-        
-        // Get all upload IDs that match the dataId
-        std::vector<String> uploadIdsToRemove;
-        for (const auto& progress : allUploads) {
-            uploadIdsToRemove.push_back(progress->uploadId);
-        }
-        
-        // Remove each upload from the manager
-        for (const auto& uploadId : uploadIdsToRemove) {
-            manager.removeUpload(uploadId);
-            removedCount++;
-        }
-
-        // Step 4: Return success response with cleanup count
+        // Step 3: Return success response with cleanup count
         std::string message = "Successfully cleaned up " + std::to_string(removedCount) + " upload(s) for dataId: " + std::string(dataId);
         response = create_response(UPLOAD_SUCCESS, message);
         
@@ -471,15 +941,177 @@ extern "C" S3UPLOAD_API const char* __stdcall CleanupUploadsByDataId(
         return response.c_str();
 
     } catch (const std::exception& e) {
-        // Step 5: Handle exceptions during cleanup
+        // Step 4: Handle exceptions during cleanup
         std::string errorMsg = "Failed to cleanup uploads: " + std::string(e.what());
         response = create_response(UPLOAD_FAILED, formatErrorMessage("Cleanup failed", e.what()));
         AWS_LOGSTREAM_ERROR("S3Upload", "Exception during cleanup: " << e.what());
         return response.c_str();
     } catch (...) {
-        // Step 6: Handle unknown exceptions
+        // Step 5: Handle unknown exceptions
         response = create_response(UPLOAD_FAILED, formatErrorMessage("Cleanup failed", ErrorMessage::UNKNOWN_ERROR));
         AWS_LOGSTREAM_ERROR("S3Upload", "Unknown exception during cleanup");
         return response.c_str();
     }
 }
+
+
+// Cancel a queued or running upload
+// Its requests in flight stop at the next body chunk (see RequestBytesTracker), its place
+// in the worker pool goes to the next queued job and it is reported cancelled right away,
+// so a status callback runs on the calling thread; the worker aborts a multipart upload
+// on S3 while it winds down in the background.
+// Returns false if the upload finished before it could be cancelled.
+static bool cancelActiveUpload(const std::shared_ptr<AsyncUploadProgress>& progress) {
+    progress->shouldCancel = true;
+    UploadWorkerPool::getInstance().cancel(progress->uploadId);
+    AsyncUploadManager::getInstance().updateProgress(progress->uploadId, UPLOAD_CANCELLED);
+    return progress->status.load() == UPLOAD_CANCELLED;
+}
+
+// Cancel one async upload by its upload ID, whether backlogged, queued or running
+// Returns JSON response indicating success or failure
+extern "C" S3UPLOAD_API const char* __stdcall CancelUpload(
+    const char* uploadId
+) {
+    static std::string response;
+
+    // Step 1: Validate input parameters
+    if (!uploadId) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    try {
+        // Step 2: An upload not registered yet is cancelled in the backlog; look again
+        // afterwards in case the backlog admitted it meanwhile
+        auto& manager = AsyncUploadManager::getInstance();
+        bool cancelled = false;
+        auto progress = manager.getUpload(uploadId);
+        if (!progress) {
+            cancelled = UploadBacklog::getInstance().cancelUpload(uploadId);
+            progress = manager.getUpload(uploadId);
+        }
+
+        // Step 3: Stop the registered upload
+        if (progress) {
+            cancelled = !isFinishedStatus(progress->status) && cancelActiveUpload(progress);
+            if (!cancelled) {
+                response = create_response(UPLOAD_FAILED, "Upload has already finished: " + std::string(uploadId));
+                return response.c_str();
+            }
+        }
+        if (!cancelled) {
+            response = create_response(UPLOAD_FAILED, "No queued or running upload with ID: " + std::string(uploadId));
+            return response.c_str();
+        }
+
+        response = create_response(UPLOAD_SUCCESS, "Cancelled upload: " + std::string(uploadId));
+        AWS_LOGSTREAM_INFO("S3Upload", "Cancelled upload ID: " << uploadId);
+        return response.c_str();
+
+    } catch (const std::exception& e) {
+        // Step 4: Handle exceptions during cancellation
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Cancel failed", e.what()));
+        AWS_LOGSTREAM_ERROR("S3Upload", "Exception during cancel: " << e.what());
+        return response.c_str();
+    } catch (...) {
+        // Step 5: Handle unknown exceptions
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Cancel failed", ErrorMessage::UNKNOWN_ERROR));
+        AWS_LOGSTREAM_ERROR("S3Upload", "Unknown exception during cancel");
+        return response.c_str();
+    }
+}
+
+// Cancel every backlogged, queued and running upload of a dataId
+// Finished uploads keep their status; uploads submitted afterwards are not affected
+// Returns JSON response indicating success or failure
+extern "C" S3UPLOAD_API const char* __stdcall CancelUploadsByDataId(
+    const char* dataId
+) {
+    static std::string response;
+
+    // Step 1: Validate input parameters
+    if (!dataId) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    try {
+        // Step 2: Cancel the backlogged uploads first, so none is admitted after the active ones are listed
+        size_t cancelledCount = UploadBacklog::getInstance().cancelDataId(dataId);
+
+        // Step 3: Stop the queued and running uploads
+        for (const auto& progress : AsyncUploadManager::getInstance().getActiveUploadsByDataId(dataId)) {
+            if (cancelActiveUpload(progress)) {
+                cancelledCount++;
+            }
+        }
+
+        if (cancelledCount == 0) {
+            response = create_response(UPLOAD_SUCCESS, "No queued or running uploads with dataId: " + std::string(dataId));
+            return response.c_str();
+        }
+
+        std::string message = "Cancelled " + std::to_string(cancelledCount) + " upload(s) for dataId: " + std::string(dataId);
+        response = create_response(UPLOAD_SUCCESS, message);
+        AWS_LOGSTREAM_INFO("S3Upload", message);
+        return response.c_str();
+
+    } catch (const std::exception& e) {
+        // Step 4: Handle exceptions during cancellation
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Cancel failed", e.what()));
+        AWS_LOGSTREAM_ERROR("S3Upload", "Exception during cancel: " << e.what());
+        return response.c_str();
+    } catch (...) {
+        // Step 5: Handle unknown exceptions
+        response = create_response(UPLOAD_FAILED, formatErrorMessage("Cancel failed", ErrorMessage::UNKNOWN_ERROR));
+        AWS_LOGSTREAM_ERROR("S3Upload", "Unknown exception during cancel");
+        return response.c_str();
+    }
+}
+
+// Block until all uploads of the dataId have finished, any of them changes status,
+// or timeoutMs expires - replaces fixed-interval status polling
+// Returns the overall status (UPLOAD_SUCCESS, UPLOAD_FAILED or UPLOAD_UPLOADING), -1 if dataId is unknown
+extern "C" S3UPLOAD_API int __stdcall WaitForUploadsByDataId(
+    const char* dataId,
+    long timeoutMs
+) {
+    if (!dataId) {
+        return -1;
+    }
+    return AsyncUploadManager::getInstance().waitForDataId(dataId, timeoutMs);
+}
+
+// Register a callback invoked on every upload status transition (pass NULL to remove)
+// The callback mostly runs on upload worker threads, but cancellations are reported on the
+// thread calling CancelUpload, CancelUploadsByDataId or CleanupAwsSDK before the call returns.
+// Hosts that cannot take calls from foreign threads (VB6) should use WaitForUploadsByDataId
+// or an event handle instead
+extern "C" S3UPLOAD_API const char* __stdcall RegisterUploadStatusCallback(
+    UploadStatusCallback callback
+) {
+    static std::string response;
+
+    AsyncUploadManager::getInstance().setStatusCallback(callback);
+    response = create_response(UPLOAD_SUCCESS, callback ? "Status callback registered" : "Status callback removed");
+    return response.c_str();
+}
+
+// Register a Win32 event that is set when every upload of the dataId has finished
+// Pass NULL as completionEvent to remove the registration
+extern "C" S3UPLOAD_API const char* __stdcall RegisterUploadCompletionEvent(
+    const char* dataId,
+    HANDLE completionEvent
+) {
+    static std::string response;
+
+    if (!dataId) {
+        response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::INVALID_PARAMETERS));
+        return response.c_str();
+    }
+
+    AsyncUploadManager::getInstance().setCompletionEvent(dataId, completionEvent);
+    response = create_response(UPLOAD_SUCCESS, completionEvent ? "Completion event registered" : "Completion event removed");
+    return response.c_str();
+}
@@ -1,4 +1,8 @@
 #include "../common/S3Common.h"
+#include "../common/S3MultipartUpload.h"
+#include "../common/S3ClientCache.h"
+#include "../common/S3MappedFileBody.h"
+#include "../common/S3RetryPolicy.h"
 
 // S3 upload implementation with Session Token support
 extern "C" S3UPLOAD_API const char* __stdcall UploadFileSync(
@@ -30,7 +34,7 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileSync(
     }
 
     // Get file size
-    long fileSize = GetS3FileSize(localFilePath);
+    long long fileSize = getFileSize64(localFilePath);
     if (fileSize < 0) {
         response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::CANNOT_READ_FILE_SIZE, localFilePath));
         return response.c_str();
@@ -47,42 +51,85 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileSync(
         AWS_LOGSTREAM_INFO("S3Upload", "File: " << localFilePath);
         AWS_LOGSTREAM_INFO("S3Upload", "SessionToken length: " << (sessionToken ? strlen(sessionToken) : 0));
         
-        // Create S3 client using helper function
-        Aws::S3::S3Client s3Client = createS3Client(
+        // Get S3 client from the cache (reuses warm connections across uploads)
+        auto s3Client = acquireS3Client(
             String(accessKey),
             String(secretKey),
             sessionToken ? String(sessionToken) : "",
             String(region)
         );
 
+        // Large files go through the multipart path with per-part retry
+        if (shouldUseMultipartUpload(fileSize)) {
+            AWS_LOGSTREAM_INFO("S3Upload", "Starting S3 multipart upload...");
+            String multipartError;
+            String checksum;
+            if (uploadFileMultipart(*s3Client, bucketName, objectKey, localFilePath, fileSize, nullptr, ObjectMetadata(), checksum, multipartError)) {
+                std::ostringstream oss;
+                oss << "Successfully uploaded " << localFilePath
+                    << " (" << fileSize << " bytes) to s3://"
+                    << bucketName << "/" << objectKey
+                    << " in region " << region << " using multipart upload"
+                    << " (CRC32C " << checksum << ")";
+
+                AWS_LOGSTREAM_INFO("S3Upload", "Upload SUCCESS: " << oss.str());
+                response = create_response(UPLOAD_SUCCESS, oss.str());
+            } else {
+                AWS_LOGSTREAM_ERROR("S3Upload", "Upload FAILED: " << multipartError);
+                response = create_response(UPLOAD_FAILED, multipartError);
+            }
+            return response.c_str();
+        }
+
+        // Map the file so the HTTP client reads straight from its pages
+        // (declared before the request so the view outlives it)
+        MappedFileBody mappedBody;
+
         // Create upload request
         AWS_LOGSTREAM_INFO("S3Upload", "Creating PutObject request...");
         Aws::S3::Model::PutObjectRequest request;
         request.SetBucket(bucketName);
         request.SetKey(objectKey);
 
-        // Open file stream
-        AWS_LOGSTREAM_INFO("S3Upload", "Opening file stream for: " << localFilePath);
-        auto inputData = Aws::MakeShared<Aws::FStream>("PutObjectInputStream",
-                                                       localFilePath,
-                                                       std::ios_base::in | std::ios_base::binary);
-
-        if (!inputData->is_open()) {
-            AWS_LOGSTREAM_ERROR("S3Upload", "Failed to open file: " << localFilePath);
-            response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::CANNOT_OPEN_FILE, localFilePath));
-            return response.c_str();
+        // Use the mapped view as body; empty or unmappable files use a file stream
+        AWS_LOGSTREAM_INFO("S3Upload", "Opening file for: " << localFilePath);
+        std::shared_ptr<Aws::IOStream> inputData;
+        if (mappedBody.open(localFilePath, 0, fileSize)) {
+            inputData = mappedBody.getStream();
+        } else {
+            auto fileStream = Aws::MakeShared<Aws::FStream>("PutObjectInputStream",
+                                                            localFilePath,
+                                                            std::ios_base::in | std::ios_base::binary);
+            if (!fileStream->is_open()) {
+                AWS_LOGSTREAM_ERROR("S3Upload", "Failed to open file: " << localFilePath);
+                response = create_response(UPLOAD_FAILED, formatErrorMessage(ErrorMessage::CANNOT_OPEN_FILE, localFilePath));
+                return response.c_str();
+            }
+            inputData = fileStream;
         }
 
         AWS_LOGSTREAM_INFO("S3Upload", "File opened successfully, setting request body...");
         request.SetBody(inputData);
         request.SetContentType("application/octet-stream");
+        // CRC32C is computed while the body streams out and sent as a trailer
+        request.SetChecksumAlgorithm(Aws::S3::Model::ChecksumAlgorithm::CRC32C);
 
         // Execute upload
         AWS_LOGSTREAM_INFO("S3Upload", "Starting S3 PutObject operation...");
         AWS_LOGSTREAM_INFO("S3Upload", "File size: " << fileSize << " bytes");
         AWS_LOGSTREAM_INFO("S3Upload", "This may take a while depending on file size and network...");
         
-        auto outcome = s3Client.PutObject(request);
+        // Transient errors are retried with a rewound body (the client itself does not retry)
+        RetryController retry(nullptr);
+        auto outcome = s3Client->PutObject(request);
+        while (!outcome.IsSuccess() && retry.shouldRetry(outcome.GetError())) {
+            inputData->clear();
+            inputData->seekg(0, std::ios::beg);
+            outcome = s3Client->PutObject(request);
+        }
+        if (outcome.IsSuccess()) {
+            retry.recordSuccess();
+        }
         
         AWS_LOGSTREAM_INFO("S3Upload", "PutObject operation completed");
 
@@ -96,6 +143,7 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileSync(
             if (sessionToken && strlen(sessionToken) > 0) {
                 oss << " using STS credentials";
             }
+            oss << " (CRC32C " << outcome.GetResult().GetChecksumCRC32C() << ")";
 
             AWS_LOGSTREAM_INFO("S3Upload", "Upload SUCCESS: " << oss.str());
             response = create_response(UPLOAD_SUCCESS, oss.str());
@@ -108,6 +156,9 @@ extern "C" S3UPLOAD_API const char* __stdcall UploadFileSync(
 
             AWS_LOGSTREAM_ERROR("S3Upload", "Upload FAILED: " << oss.str());
             AWS_LOGSTREAM_ERROR("S3Upload", "Error type: " << error.GetExceptionName());
+            if (error.GetErrorType() == Aws::S3::S3Errors::EXPIRED_TOKEN) {
+                S3ClientCache::getInstance().invalidate(accessKey, sessionToken ? sessionToken : "", region);
+            }
             response = create_response(UPLOAD_FAILED, oss.str());
             return response.c_str();
         }
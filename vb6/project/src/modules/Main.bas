@@ -7,7 +7,7 @@ Option Explicit
 ' - Microsoft Scripting Runtime (for Dictionary object)
 
 ' Windows API declarations
-Private Declare Sub Sleep Lib "kernel32" (ByVal dwMilliseconds As Long)
+Private Declare Function GetTickCount Lib "kernel32" () As Long
 
 ' Required files:
 ' Project -> Add file -> Add the following files
@@ -103,7 +103,7 @@ Sub Main()
     ' Determine upload type and execute upload
     isFolder = IsPathFolder(uploadFilePath)
     Dim maxWaitTime As Long
-    maxWaitTime = 600 ' Maximum wait time in seconds (10 minutes)
+    maxWaitTime = 6000 ' Maximum wait time in seconds (100 minutes)
     
     If isFolder Then
         ' 6.1. Upload folder contents
@@ -113,8 +113,7 @@ Sub Main()
         uploadDataName = fso.GetFolder(uploadFilePath).Name
         ' S3 file key: patient/patientId/source_data/dataId/abc.ds/single_file_name
         s3FileKey = "patient/" & patientId & "/source_data/" & dataId & "/" & uploadDataName & "/"
-        Dim uploadIds As String
-        uploadSuccess = UploadFolderContents(uploadFilePath, s3Credentials, totalFileSize, s3FileKey, dataId, uploadIds)
+        uploadSuccess = UploadFolderContents(uploadFilePath, s3Credentials, totalFileSize, s3FileKey, dataId)
         
         ' 6.1.1. Monitor folder upload status
         If uploadSuccess Then
@@ -166,83 +165,50 @@ Sub Main()
     Exit Sub
 End Sub
 
-' Upload all files in a folder to S3 and confirm with API
-Private Function UploadFolderContents(ByVal folderPath As String, ByVal s3Credentials As String, ByRef totalFileSize As Long, ByVal s3FileKey As String, ByVal dataId As String, ByRef uploadIds As String) As Boolean
+' Upload all files in a folder (including subfolders) to S3 as one batch
+' The folder is walked inside S3UploadLib.dll and all files are queued under the same dataId
+Private Function UploadFolderContents(ByVal folderPath As String, ByVal s3Credentials As String, ByRef totalFileSize As Long, ByVal s3FileKey As String, ByVal dataId As String) As Boolean
     Dim fso As Object
-    Dim folder As Object
-    Dim file As Object
-    Dim fileCount As Integer
-    Dim uploadedCount As Integer
-    Dim failedCount As Integer
-    Dim currentFile As String
-    Dim currentFileSize As Long
+    Dim credentialsObj As Object
+    Dim startObj As Object
+    Dim startResponse As String
     
-    ' 1. Initialize file system object for folder operations
-    Set fso = CreateObject("Scripting.FileSystemObject")
+    On Error GoTo ErrorHandler
     
-    ' 2. Validate that the specified folder path exists
+    ' 1. Validate that the specified folder path exists
+    Set fso = CreateObject("Scripting.FileSystemObject")
     If Not fso.FolderExists(folderPath) Then
         Debug.Print "ERROR: Folder does not exist: " & folderPath
         UploadFolderContents = False
         Exit Function
     End If
+    Set fso = Nothing
+    
+    ' 2. Parse S3 credentials
+    Set credentialsObj = JsonConverter.ParseJson(s3Credentials)
     
-    ' 3. Get folder object and count files
-    Set folder = fso.GetFolder(folderPath)
-    fileCount = folder.Files.Count
+    ' 3. Queue the whole folder in one call
+    ' Folder file key: patient/patientId/source_data/dataId/abc.ds/relative/path/abc.xyz
+    Debug.Print "Submit folder to queue - " & folderPath
+    startResponse = UploadFolderAsync(credentialsObj("accessKeyId"), credentialsObj("secretAccessKey"), credentialsObj("sessionToken"), S3_REGION, S3_BUCKET, s3FileKey, folderPath, dataId)
+    Debug.Print startResponse
     
-    If fileCount = 0 Then
-        Debug.Print "ERROR: No files found in folder"
+    ' 4. Parse response; the batch size is known before any bytes are sent
+    Set startObj = JsonConverter.ParseJson(startResponse)
+    If startObj("code") <> 2 Then
+        Debug.Print "ERROR: Failed to start folder upload - " & startObj("message")
         UploadFolderContents = False
         Exit Function
     End If
     
-    ' 4. Initialize counters and size tracking
-    uploadedCount = 0
-    failedCount = 0
-    totalFileSize = 0
-    uploadIds = "" ' Initialize upload IDs string
-    
-    ' 5. Loop through all files in the folder
-    For Each file In folder.Files
-        currentFile = file.path
-        
-        ' 6. Get file size before upload
-        currentFileSize = GetLocalFileSize(currentFile)
-        
-        ' 7. Upload the current file
-        Dim singleS3FileKey As String
-        Dim currentUploadId As String
-        ' Single file in folder: patient/patientId/source_data/dataId/abc.ds/abc.xyz
-        singleS3FileKey = s3FileKey & GetFileName(currentFile)
-        If UploadSingleFile(currentFile, s3Credentials, singleS3FileKey, dataId, currentUploadId) Then
-            uploadedCount = uploadedCount + 1
-            totalFileSize = totalFileSize + currentFileSize
-            ' Add upload ID to the list (comma-separated)
-            If uploadIds = "" Then
-                uploadIds = currentUploadId
-            Else
-                uploadIds = uploadIds & "," & currentUploadId
-            End If
-        Else
-            failedCount = failedCount + 1
-            Debug.Print "ERROR: Failed to start upload for " & currentFile
-        End If
-    Next file
-    
-    ' 9. Determine if upload process was successful
-    ' If any files failed to upload, the entire process is failed
-    If failedCount > 0 Then
-        Debug.Print "ERROR: " & failedCount & " files failed to upload"
-        UploadFolderContents = False
-    Else
-        UploadFolderContents = True
-    End If
+    totalFileSize = CLng(startObj("totalSize"))
+    Debug.Print "SUCCESS: Queued " & startObj("fileCount") & " file(s), " & totalFileSize & " bytes"
+    UploadFolderContents = True
+    Exit Function
     
-    ' 10. Cleanup file system objects to free memory
-    Set file = Nothing
-    Set folder = Nothing
-    Set fso = Nothing
+ErrorHandler:
+    Debug.Print "ERROR: Folder upload failed - " & Err.Description
+    UploadFolderContents = False
 End Function
 
 ' Upload a single file to S3 using AWS SDK
@@ -316,15 +282,17 @@ Private Function MonitorUploadStatus(ByVal dataId As String, ByVal maxWaitTime A
     Dim waitTime As Long
     Dim statusCode As Long
     Dim uploadStatus As Long
+    Dim startTick As Long
 
     waitTime = 0
+    startTick = GetTickCount()
 
     Do While waitTime < maxWaitTime
         ' Use byte array method for safer data transfer
         Dim buffer(0 To 2097151) As Byte ' 2MB buffer should be enough for status JSON
         Dim bytesReceived As Long
 
-        Debug.Print "Query status for dataId: " & dataId & " (attempt " & (waitTime + 1) & ")"
+        Debug.Print "Query status for dataId: " & dataId & " (" & waitTime & "s elapsed)"
 
         ' Try byte array method first
         On Error GoTo ErrorHandler
@@ -375,13 +343,14 @@ ParseResponse:
             Exit Do
         End If
 
-        ' Wait 10 seconds (10 x 1 second) before checking again
+        ' Wait up to 10 seconds before checking again, blocking in the DLL for at most
+        ' 1 second at a time so the UI keeps responding; stop early once the batch finishes
         Dim j As Integer
         For j = 1 To 10
+            If WaitForUploadsByDataId(dataId, 1000) <> 1 Then Exit For
             DoEvents
-            Sleep 1000
         Next j
-        waitTime = waitTime + 1
+        waitTime = (GetTickCount() - startTick) \ 1000
     Loop
 
     GoTo ContinueAfterLoop
@@ -41,6 +41,21 @@ Declare Function UploadFileAsync Lib "S3UploadLib.dll" ( _
     ByVal dataId As String _
 ) As String
 
+' Start asynchronous upload with a scheduling priority (-100 to 100, UploadFileAsync uses 0)
+' Higher priorities start before every queued upload of lower priority
+' Return value: JSON string with upload ID on success, error on failure
+Declare Function UploadFileAsyncEx Lib "S3UploadLib.dll" ( _
+    ByVal accessKey As String, _
+    ByVal secretKey As String, _
+    ByVal sessionToken As String, _
+    ByVal region As String, _
+    ByVal bucketName As String, _
+    ByVal objectKey As String, _
+    ByVal localFilePath As String, _
+    ByVal dataId As String, _
+    ByVal priority As Long _
+) As String
+
 ' Get upload status as byte array (safer for large responses)
 ' Parameters:
 '   dataId: Data ID used to identify the upload
@@ -53,6 +68,69 @@ Declare Function GetAsyncUploadStatusBytes Lib "S3UploadLib.dll" ( _
     ByVal bufferSize As Long _
 ) As Long
 
+' Get only the uploads that changed since an earlier status query - cheaper for large batches
+' Parameters:
+'   dataId: Data ID used to identify the upload
+'   sinceVersion: 0 for everything, then the "version" value of the previous response
+'   buffer: Byte array to receive the JSON data
+'   bufferSize: Size of the buffer
+' The summary fields always describe the whole dataId
+' Return value: Number of bytes copied to buffer, 0 on error
+Declare Function GetAsyncUploadStatusDelta Lib "S3UploadLib.dll" ( _
+    ByVal dataId As String, _
+    ByVal sinceVersion As Double, _
+    ByRef buffer As Byte, _
+    ByVal bufferSize As Long _
+) As Long
+
+' Binary status snapshot (GetAsyncUploadStatusRecords), same layout as the DLL structs
+' 64-bit values are Currency: the number shown is value / 10000, multiply by 10000 for bytes
+' errorCode: 0 none, 1 invalid parameters, 2 SDK not initialized, 3 local file,
+' 4 access denied, 5 credentials expired, 6 network (retries exhausted), 7 rejected by S3, 8 internal
+Type UploadStatusSummaryRecord
+    structSize As Long
+    recordSize As Long
+    status As Long
+    errorCode As Long
+    uploadCount As Long
+    pendingCount As Long
+    uploadingCount As Long
+    uploadedCount As Long
+    failedCount As Long
+    cancelledCount As Long
+    totalSize As Currency
+    uploadedSize As Currency
+    throughputBytesPerSec As Currency
+    etaSeconds As Currency
+End Type
+
+Type UploadStatusRecord
+    uploadId(0 To 63) As Byte
+    status As Long
+    errorCode As Long
+    retryCount As Long
+    totalParts As Long
+    completedParts As Long
+    totalSize As Currency
+    bytesSent As Currency
+    startTimeMs As Currency
+    endTimeMs As Currency
+End Type
+
+' Get upload status as fixed-size records - cheap enough to poll from a timer, no JSON parsing
+' Parameters:
+'   dataId: Data ID used to identify the upload
+'   summary: Receives the dataId summary
+'   records: First element of an UploadStatusRecord array, e.g. records(0)
+'   maxRecords: Number of elements in the array (summary.uploadCount tells how many are needed)
+' Return value: Number of records filled, -1 if dataId is unknown
+Declare Function GetAsyncUploadStatusRecords Lib "S3UploadLib.dll" ( _
+    ByVal dataId As String, _
+    ByRef summary As UploadStatusSummaryRecord, _
+    ByRef records As UploadStatusRecord, _
+    ByVal maxRecords As Long _
+) As Long
+
 ' Clean up uploads by dataId - removes all uploads that match the dataId prefix
 ' Parameters:
 '   dataId: Data ID used to identify the uploads to clean up
@@ -60,4 +138,185 @@ Declare Function GetAsyncUploadStatusBytes Lib "S3UploadLib.dll" ( _
 ' { "code": 2, "message": "Successfully cleaned up X upload(s) for dataId: xxx" }
 Declare Function CleanupUploadsByDataId Lib "S3UploadLib.dll" ( _
     ByVal dataId As String _
+) As String
+
+' Cancel one async upload - a backlogged or queued upload never starts, a running one
+' stops sending at once and its multipart upload is aborted on S3
+' The upload is reported cancelled (status 4) before the call returns
+' Parameters:
+'   uploadId: Upload ID returned by UploadFileAsync / UploadFileAsyncEx
+' Return value: JSON string indicating success or failure
+' { "code": 2, "message": "Cancelled upload: xxx" }
+Declare Function CancelUpload Lib "S3UploadLib.dll" ( _
+    ByVal uploadId As String _
+) As String
+
+' Cancel every backlogged, queued and running upload of a dataId (finished uploads keep their status)
+' The uploads are reported cancelled (status 4) before the call returns
+' Parameters:
+'   dataId: Data ID used to identify the uploads to cancel
+' Return value: JSON string indicating success or failure
+' { "code": 2, "message": "Cancelled X upload(s) for dataId: xxx" }
+Declare Function CancelUploadsByDataId Lib "S3UploadLib.dll" ( _
+    ByVal dataId As String _
+) As String
+
+' Configure multipart upload for large files
+' Parameters:
+'   thresholdMB: Files larger than this (in MB) are uploaded in parts, 0 keeps the current value
+'   partConcurrency: Number of parts uploaded at the same time per file, 0 keeps the current value
+' Return value: JSON string with the active settings
+' { "code": 2, "message": "Multipart threshold 16777216 bytes, 4 concurrent parts" }
+Declare Function ConfigureMultipartUpload Lib "S3UploadLib.dll" ( _
+    ByVal thresholdMB As Long, _
+    ByVal partConcurrency As Long _
+) As String
+
+' Set how many async uploads run at the same time (default 4, max 16)
+' Can be called before or after InitializeAwsSDK
+' Return value: JSON string with the active setting
+' { "code": 2, "message": "Max concurrent uploads set to 4" }
+Declare Function SetMaxConcurrentUploads Lib "S3UploadLib.dll" ( _
+    ByVal maxUploads As Long _
+) As String
+
+' Get S3 client cache statistics
+' Clients are reused across uploads with the same access key, session token and region
+' Return value: JSON string
+' { "code": 2, "hits": 10, "misses": 1, "evictions": 0, "size": 1 }
+Declare Function GetS3ClientCacheStats Lib "S3UploadLib.dll" () As String
+
+' Send uploads to an S3-compatible endpoint instead of AWS, e.g. "http://127.0.0.1:9000"
+' Buckets are addressed path-style; pass "" to switch back to AWS
+' Return value: JSON string indicating success or failure
+Declare Function SetS3Endpoint Lib "S3UploadLib.dll" ( _
+    ByVal endpoint As String _
+) As String
+
+' Get process-wide upload metrics as Prometheus text (not JSON), for a local agent to scrape
+' Counters and latency histograms: bytes sent, requests, retries by error class,
+' connection reuse and per-phase upload times; gauges: queue depth and busy workers
+Declare Function GetUploadMetrics Lib "S3UploadLib.dll" () As String
+
+' Record a timeline of async uploads (off by default); enabled = 1 starts a new trace, 0 stops
+' Return value: JSON string indicating success
+Declare Function SetUploadTrace Lib "S3UploadLib.dll" ( _
+    ByVal enabled As Long _
+) As String
+
+' Write the recorded timeline to a file as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+' Return value: JSON string with the number of spans written
+Declare Function DumpUploadTrace Lib "S3UploadLib.dll" ( _
+    ByVal path As String _
+) As String
+
+' Keep finished async uploads in status queries for at most maxEntries records and maxAgeMinutes
+' (defaults 10000 and 1440); values <= 0 keep the current setting
+' Only queued and running uploads count toward the 100 active uploads
+' Return value: JSON string indicating success
+Declare Function SetUploadHistoryRetention Lib "S3UploadLib.dll" ( _
+    ByVal maxEntries As Long, _
+    ByVal maxAgeMinutes As Long _
+) As String
+
+' Submissions beyond 100 active uploads wait in a backlog instead of being rejected
+' The first maxMemoryEntries (default 10000) stay in memory, the rest spill to spillDirectory
+' maxMemoryEntries <= 0 keeps the current limit; vbNullString keeps the directory, "" uses the temp directory
+' Return value: JSON string indicating success or failure
+Declare Function SetUploadBacklog Lib "S3UploadLib.dll" ( _
+    ByVal maxMemoryEntries As Long, _
+    ByVal spillDirectory As String _
+) As String
+
+' Start asynchronous upload of a whole folder (recursive) under one dataId
+' Object keys are keyPrefix + path relative to the folder, using "/" separators
+' Return value: JSON string with the batch size, known before any bytes are sent
+' { "code": 2, "message": "Queued 12 file(s)", "dataId": "...", "fileCount": 12, "totalSize": 123456 }
+Declare Function UploadFolderAsync Lib "S3UploadLib.dll" ( _
+    ByVal accessKey As String, _
+    ByVal secretKey As String, _
+    ByVal sessionToken As String, _
+    ByVal region As String, _
+    ByVal bucketName As String, _
+    ByVal keyPrefix As String, _
+    ByVal localFolderPath As String, _
+    ByVal dataId As String _
+) As String
+
+' Block until all uploads of the dataId have finished, any of them changes status,
+' or timeoutMs expires - use instead of sleeping between status queries
+' Return value: overall status (2 = success, 3 = failed, 1 = still uploading), -1 if dataId is unknown
+Declare Function WaitForUploadsByDataId Lib "S3UploadLib.dll" ( _
+    ByVal dataId As String, _
+    ByVal timeoutMs As Long _
+) As Long
+
+' Register a Win32 event (CreateEvent handle) that is set when every upload of the dataId has finished
+' Pass 0 as completionEvent to remove the registration
+' Return value: JSON string indicating success or failure
+Declare Function RegisterUploadCompletionEvent Lib "S3UploadLib.dll" ( _
+    ByVal dataId As String, _
+    ByVal completionEvent As Long _
+) As String
+
+' Set the directory for resumable upload journals ("" disables journaling)
+' Default: %LOCALAPPDATA%\S3UploadLib\journal
+' Return value: JSON string indicating success or failure
+Declare Function SetUploadJournalDirectory Lib "S3UploadLib.dll" ( _
+    ByVal journalDirectory As String _
+) As String
+
+' Resume multipart uploads left unfinished by an earlier run
+' Uploads are queued again under their original dataId; pass "" as dataId to resume all
+' Return value: JSON string with resumedCount, skippedCount and the resumed dataIds
+Declare Function ResumeUploads Lib "S3UploadLib.dll" ( _
+    ByVal accessKey As String, _
+    ByVal secretKey As String, _
+    ByVal sessionToken As String, _
+    ByVal region As String, _
+    ByVal dataId As String _
+) As String
+
+' Limit total upload bandwidth of all uploads in KB/s (0 = unlimited)
+' Return value: JSON string indicating success or failure
+Declare Function SetBandwidthLimit Lib "S3UploadLib.dll" ( _
+    ByVal limitKBps As Long _
+) As String
+
+' Time-of-day bandwidth schedule in local time, e.g. "07:00-18:00=256;18:00-07:00=0" (KB/s)
+' Outside all windows the SetBandwidthLimit value applies; "" removes the schedule
+' Return value: JSON string indicating success or failure
+Declare Function SetBandwidthSchedule Lib "S3UploadLib.dll" ( _
+    ByVal schedule As String _
+) As String
+
+' Compress async uploads before sending (EDF/BDF delta filter + zstd); enabled: 0 = off, 1 = on
+' level <= 0 keeps the current zstd level
+' Return value: JSON string indicating success or failure
+Declare Function SetUploadCompression Lib "S3UploadLib.dll" ( _
+    ByVal enabled As Long, _
+    ByVal level As Long _
+) As String
+
+' Skip async uploads whose content already reached their object; enabled/verifyRemote: 0 = off, 1 = on
+' verifyRemote = 1 confirms with HeadObject instead of trusting the local index
+' Return value: JSON string indicating success or failure
+Declare Function SetUploadDeduplication Lib "S3UploadLib.dll" ( _
+    ByVal enabled As Long, _
+    ByVal verifyRemote As Long _
+) As String
+
+' Order of queued uploads with the same priority: 0 = fair across dataIds, 1 = shortest first
+' Return value: JSON string indicating success or failure
+Declare Function SetUploadScheduling Lib "S3UploadLib.dll" ( _
+    ByVal mode As Long _
+) As String
+
+' Pack folder files under smallFileKB into tar bundles of about bundleSizeMB (0 = keep current, default 32)
+' Used by UploadFolderAsync; smallFileKB = 0 disables bundling (default)
+' Each bundle ends with a manifest mapping every file to its offset in the tar
+' Return value: JSON string indicating success or failure
+Declare Function SetFolderUploadBundling Lib "S3UploadLib.dll" ( _
+    ByVal smallFileKB As Long, _
+    ByVal bundleSizeMB As Long _
 ) As String
\ No newline at end of file